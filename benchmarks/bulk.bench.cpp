@@ -0,0 +1,137 @@
+/*
+ * This file is part of the hrewrite library.
+ * Copyright (c) 2021 ONERA.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+ // Author: Michael Lienhardt
+ // Maintainer: Michael Lienhardt
+ // email: michael.lienhardt@onera.fr
+
+// construction of a term DAG with shared subterms: one create_sterm per node, and one bulk build from its CSR description.
+// The export of the DAG back into its CSR description is also measured
+// usage: bulk [nb_nodes] [nb_leaves]
+
+#include "benchmarks/common.hpp"
+
+#include "hrewrite/hrewrite.hpp"
+#include "hrewrite/theory/theory_free.hpp"
+#include "hrewrite/theory/theory_literal.hpp"
+#include "hrewrite/theory/theory_variable.hpp"
+
+#include <cstdint>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+
+struct t_id {};
+
+template<typename t_alphabet, const t_alphabet& alphabet>
+using my_automata = hrw::utils::tt_automata<hrw::utils::natset, hrw::utils::natset>::template type<t_alphabet, alphabet>;
+template<typename t_alphabet, const t_alphabet& alphabet>
+using t_vparser = hrw::utils::combine_variant<t_alphabet, alphabet, hrw::utils::element, my_automata>;
+template<typename t_alphabet, const t_alphabet& alphabet>
+using t_sparser = hrw::utils::combine_variant<t_alphabet, alphabet, hrw::utils::sequence, my_automata>;
+
+template<typename ... Args> using unordered_set_wrapper = std::unordered_set<Args...>;
+
+using t_ctx_th = hrw::context_theory<t_id,
+  hrw::context_sort<hrw::utils::natset>,
+  hrw::theory::tp_theory_variable_vector<t_vparser>::template type,
+  hrw::theory::tp_theory_free<hrw::utils::small_vector_default, t_sparser>::template type,
+  hrw::theory::tp_theory_literal<int>::template type
+>;
+using t_ctx_tm = hrw::context_term<t_ctx_th, hrw::utils::registry_unique<unordered_set_wrapper, true>>;
+using t_term_full_ref = typename t_ctx_tm::t_term_full_ref;
+using t_theory_free = std::tuple_element_t<0, typename t_ctx_th::theories_structured>;
+using t_theory_lit = std::tuple_element_t<1, typename t_ctx_th::theories_structured>;
+using t_container = typename t_theory_free::template tt_term<typename t_ctx_tm::t_term_full>::t_container;
+using t_index = hrw::term_bulk::t_index;
+
+struct t_int_values {
+  template<typename T> T get(std::size_t k) { return static_cast<T>(k); }
+};
+
+
+int main(int argc, char** argv) {
+  std::size_t nb_nodes = bench::get_arg(argc, argv, 1, 1000000);
+  std::size_t nb_leaves = std::max<std::size_t>(1, std::min(nb_nodes, bench::get_arg(argc, argv, 2, 1024)));
+
+  hrw::t_sort_id sort = t_ctx_th::add_sort("num");
+  auto c_lit = t_ctx_th::template add_constructor<t_theory_lit>(sort, "lit");
+  auto c_node = t_ctx_th::template add_constructor<t_theory_free>(sort, "node", "num num");
+
+  bench::title("bulk: " + std::to_string(nb_nodes) + " nodes");
+
+  // the DAG of the binary benchmark: every node refers to the previous one and to a random one
+  std::vector<t_index> theories, constructors, offsets{0}, children;
+  theories.reserve(nb_nodes); constructors.reserve(nb_nodes); offsets.reserve(nb_nodes + 1); children.reserve(2 * nb_nodes);
+  for(std::size_t i = 0; i < nb_leaves; ++i) {
+    theories.push_back(t_ctx_th::template theory_index_v<t_theory_lit>);
+    constructors.push_back(c_lit.id());
+    offsets.push_back(0);
+  }
+  std::uint64_t seed = 42;
+  auto next = [&seed](std::size_t n) { seed = seed * 6364136223846793005ull + 1442695040888963407ull; return static_cast<std::size_t>((seed >> 33) % n); };
+  for(std::size_t i = nb_leaves; i < nb_nodes; ++i) {
+    theories.push_back(t_ctx_th::template theory_index_v<t_theory_free>);
+    constructors.push_back(c_node.id());
+    children.push_back(static_cast<t_index>(i - 1));
+    children.push_back(static_cast<t_index>(next(i)));
+    offsets.push_back(static_cast<t_index>(children.size()));
+  }
+  hrw::term_bulk desc{nb_nodes, children.size(), theories.data(), constructors.data(), offsets.data(), children.data()};
+  std::vector<t_term_full_ref> externals;
+
+  {
+    t_ctx_tm ctx_tm;
+    double t = bench::time_ms([&]() {
+      std::vector<t_term_full_ref> nodes;
+      nodes.reserve(nb_nodes);
+      for(std::size_t i = 0; i < nb_leaves; ++i) { nodes.push_back(ctx_tm.create_sterm(c_lit, static_cast<int>(i))); }
+      for(std::size_t i = nb_leaves; i < nb_nodes; ++i) {
+        nodes.push_back(ctx_tm.create_sterm(c_node, t_container({nodes[children[2 * (i - nb_leaves)]], nodes[children[2 * (i - nb_leaves) + 1]]})));
+      }
+      bench::keep(nodes.back());
+    });
+    bench::report("create_sterm per node, checked", nb_nodes, t);
+  }
+  {
+    t_ctx_tm ctx_tm;
+    hrw::term_bulk_builder<t_ctx_tm> builder(ctx_tm);
+    double t = bench::time_ms([&]() { bench::keep(builder.build(desc, externals, t_int_values(), true).back()); });
+    bench::report("bulk build, checked", nb_nodes, t);
+  }
+  {
+    t_ctx_tm ctx_tm;
+    hrw::term_bulk_builder<t_ctx_tm> builder(ctx_tm);
+    double t = bench::time_ms([&]() { bench::keep(builder.build(desc, externals, t_int_values(), false).back()); });
+    bench::report("bulk build, unchecked", nb_nodes, t);
+  }
+  {
+    t_ctx_tm ctx_tm;
+    hrw::term_bulk_builder<t_ctx_tm> builder(ctx_tm);
+    t_term_full_ref root = builder.build(desc, externals, t_int_values(), false).back();
+    double t = bench::time_ms([&]() {
+      hrw::term_bulk_exporter<t_ctx_tm> exporter;
+      std::size_t sum = 0;
+      exporter.add(root, [&sum](int v) { sum += v; });
+      bench::keep(exporter.data().children.size() + sum);
+    });
+    bench::report("bulk export", nb_nodes, t);
+  }
+
+  return 0;
+}
@@ -0,0 +1,71 @@
+/*
+ * This file is part of the hrewrite library.
+ * Copyright (c) 2021 ONERA.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+ // Author: Michael Lienhardt
+ // Maintainer: Michael Lienhardt
+ // email: michael.lienhardt@onera.fr
+
+#ifndef __HREWRITE_BENCHMARK_COMMON_H__
+#define __HREWRITE_BENCHMARK_COMMON_H__
+
+#include <chrono>
+#include <string>
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+
+
+namespace bench {
+
+  // returns the parameter at position idx in the command line, or dflt
+  inline std::size_t get_arg(int argc, char** argv, int idx, std::size_t dflt) {
+    if(idx < argc) { return std::strtoull(argv[idx], nullptr, 10); }
+    else { return dflt; }
+  }
+
+  // prevents the compiler from removing a computation
+  template<typename T>
+  inline void keep(T const& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+  }
+
+  // executes f once and returns its duration in milliseconds
+  template<typename F>
+  double time_ms(F&& f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+  }
+
+  inline void report(const std::string& name, std::size_t nb_ops, double ms) {
+    std::cout << "  " << std::left << std::setw(40) << name
+      << std::right << std::setw(10) << nb_ops << " ops "
+      << std::setw(12) << std::fixed << std::setprecision(3) << ms << " ms "
+      << std::setw(10) << std::setprecision(1) << ((ms * 1e6) / static_cast<double>(nb_ops ? nb_ops : 1)) << " ns/op"
+      << std::endl;
+  }
+
+  inline void title(const std::string& name) {
+    std::cout << "==================================================================\n";
+    std::cout << "= " << name << std::endl;
+  }
+
+}
+
+
+#endif // __HREWRITE_BENCHMARK_COMMON_H__
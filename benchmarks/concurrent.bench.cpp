@@ -0,0 +1,104 @@
+/*
+ * This file is part of the hrewrite library.
+ * Copyright (c) 2021 ONERA.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+ // Author: Michael Lienhardt
+ // Maintainer: Michael Lienhardt
+ // email: michael.lienhardt@onera.fr
+
+
+// hash-consing of binary trees from several threads: registry_unique behind a global mutex vs registry_concurrent
+// usage: concurrent [nb_threads] [nb_nodes_per_thread] [nb_leaves]
+
+#include "benchmarks/common.hpp"
+
+#include "hrewrite/utils/container.hpp"
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <unordered_set>
+
+
+// a hash-consed binary node: children are unique, so they are compared and hashed by address
+struct t_node {
+  unsigned int m_c;
+  const t_node* m_left;
+  const t_node* m_right;
+  friend bool operator==(const t_node& n1, const t_node& n2) { return (n1.m_c == n2.m_c) && (n1.m_left == n2.m_left) && (n1.m_right == n2.m_right); }
+};
+
+struct t_node_hash {
+  hrw::utils::hash_value operator()(const t_node& n) const {
+    hrw::utils::hash_value res(n.m_c);
+    res << std::hash<const t_node*>()(n.m_left) << std::hash<const t_node*>()(n.m_right);
+    return res;
+  }
+};
+
+
+// every thread builds the same nodes, so that most insertions find an existing node, as when rewriting shared subterms
+template<typename F>
+void run_threads(std::size_t nb_threads, std::size_t nb_nodes, std::size_t nb_leaves, F&& add) {
+  std::vector<std::thread> threads;
+  for(std::size_t i = 0; i < nb_threads; ++i) {
+    threads.emplace_back([&add, nb_nodes, nb_leaves]() {
+      std::vector<const t_node*> nodes;
+      nodes.reserve(nb_nodes);
+      for(std::size_t j = 0; j < nb_leaves; ++j) { nodes.push_back(add(t_node{static_cast<unsigned int>(j), nullptr, nullptr})); }
+      for(std::size_t j = nb_leaves; j < nb_nodes; ++j) {
+        std::size_t k1 = (j * 2654435761u) % j;
+        std::size_t k2 = (j * 40503u + 17) % j;
+        nodes.push_back(add(t_node{static_cast<unsigned int>(j), nodes[k1], nodes[k2]}));
+      }
+      bench::keep(nodes.back());
+    });
+  }
+  for(std::thread& t: threads) { t.join(); }
+}
+
+
+int main(int argc, char** argv) {
+  std::size_t nb_threads = bench::get_arg(argc, argv, 1, std::max(2u, std::thread::hardware_concurrency()));
+  std::size_t nb_nodes = bench::get_arg(argc, argv, 2, 200000);
+  std::size_t nb_leaves = bench::get_arg(argc, argv, 3, 64);
+
+  bench::title("concurrent hash-consing: " + std::to_string(nb_threads) + " threads");
+
+  {
+    hrw::utils::registry_unique<std::unordered_set, true>::make<t_node, t_node_hash> reg;
+    std::mutex m;
+    double t = bench::time_ms([&]() {
+      run_threads(nb_threads, nb_nodes, nb_leaves, [&](t_node&& n) {
+        std::lock_guard<std::mutex> lock(m);
+        return reg.add(std::move(n));
+      });
+    });
+    bench::report("registry_unique + global mutex", nb_threads * nb_nodes, t);
+  }
+
+  {
+    hrw::utils::registry_concurrent<std::unordered_set>::make<t_node, t_node_hash> reg;
+    double t = bench::time_ms([&]() {
+      run_threads(nb_threads, nb_nodes, nb_leaves, [&](t_node&& n) { return reg.add(std::move(n)); });
+    });
+    bench::report("registry_concurrent", nb_threads * nb_nodes, t);
+    std::cout << "  unique nodes: " << reg.size() << std::endl;
+  }
+
+  return 0;
+}
@@ -0,0 +1,133 @@
+/*
+ * This file is part of the hrewrite library.
+ * Copyright (c) 2021 ONERA.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+ // Author: Michael Lienhardt
+ // Maintainer: Michael Lienhardt
+ // email: michael.lienhardt@onera.fr
+
+
+// std::unordered_set/map vs flat_hash_set/map, on the workloads of the term registries and of the normal form cache
+// usage: flat_hash [nb_nodes] [nb_lookups]
+
+#include "benchmarks/common.hpp"
+
+#include "hrewrite/utils/container.hpp"
+#include "hrewrite/utils/flat_hash.hpp"
+
+#include <string>
+#include <vector>
+#include <unordered_set>
+#include <unordered_map>
+
+
+// a binary node whose children are unique, as a free term in a unique registry
+struct t_node {
+  unsigned int m_c;
+  const t_node* m_left;
+  const t_node* m_right;
+  friend bool operator==(const t_node& n1, const t_node& n2) { return (n1.m_c == n2.m_c) && (n1.m_left == n2.m_left) && (n1.m_right == n2.m_right); }
+};
+
+struct t_node_hash {
+  hrw::utils::hash_value operator()(const t_node& n) const {
+    hrw::utils::hash_value res(n.m_c);
+    res << std::hash<const t_node*>()(n.m_left) << std::hash<const t_node*>()(n.m_right);
+    return res;
+  }
+};
+
+template<typename ... Args> using std_set = std::unordered_set<Args...>;
+template<typename ... Args> using flat_set = hrw::utils::flat_hash_set<Args...>;
+template<typename ... Args> using std_map = std::unordered_map<Args...>;
+template<typename ... Args> using flat_map = hrw::utils::flat_hash_map<Args...>;
+
+
+// builds a DAG of nb_nodes nodes, then rebuilds it: the second pass only finds existing nodes
+template<typename t_reg>
+void run_registry(const std::string& name, std::size_t nb_nodes) {
+  bench::title("registry: " + name);
+  using t_ptr = typename t_reg::t_ptr;
+  t_reg reg;
+  std::vector<t_ptr> nodes;
+  nodes.reserve(nb_nodes);
+
+  auto build = [&](bool first) {
+    for(std::size_t j = 0; j < nb_nodes; ++j) {
+      t_node n{static_cast<unsigned int>(j), nullptr, nullptr};
+      if(j > 0) {
+        n.m_left = &(*nodes[(j * 2654435761u) % j]);
+        n.m_right = &(*nodes[j - 1]);
+      }
+      t_ptr p = reg.add(std::move(n));
+      if(first) { nodes.push_back(p); }
+      else { bench::keep(p); }
+    }
+  };
+
+  double t = bench::time_ms([&]() { build(true); });
+  bench::report("add (new nodes)", nb_nodes, t);
+  t = bench::time_ms([&]() { build(false); });
+  bench::report("add (existing nodes)", nb_nodes, t);
+}
+
+
+// the cache of normal forms of context_rw: term reference -> term reference
+template<template<typename ...> typename tt_map>
+void run_map(const std::string& name, std::size_t nb_nodes, std::size_t nb_lookups) {
+  bench::title("normal form cache: " + name);
+  std::vector<t_node> nodes(nb_nodes);
+  tt_map<const t_node*, const t_node*> map;
+
+  double t = bench::time_ms([&]() {
+    for(std::size_t i = 0; i < nb_nodes; ++i) { map.insert(std::make_pair(&nodes[i], &nodes[(i * 7) % nb_nodes])); }
+  });
+  bench::report("insert", nb_nodes, t);
+
+  t = bench::time_ms([&]() {
+    std::size_t acc = 0;
+    for(std::size_t i = 0; i < nb_lookups; ++i) {
+      auto it = map.find(&nodes[(i * 2654435761u) % nb_nodes]);
+      acc += (it != map.end())?(it->second->m_c):0;
+    }
+    bench::keep(acc);
+  });
+  bench::report("find (hit)", nb_lookups, t);
+
+  std::vector<t_node> others(nb_nodes);
+  t = bench::time_ms([&]() {
+    std::size_t acc = 0;
+    for(std::size_t i = 0; i < nb_lookups; ++i) { acc += (map.find(&others[i % nb_nodes]) == map.end()); }
+    bench::keep(acc);
+  });
+  bench::report("find (miss)", nb_lookups, t);
+}
+
+
+int main(int argc, char** argv) {
+  std::size_t nb_nodes = bench::get_arg(argc, argv, 1, 500000);
+  std::size_t nb_lookups = bench::get_arg(argc, argv, 2, 2000000);
+
+  run_registry<hrw::utils::registry_unique<std_set, false>::make<t_node, t_node_hash>>("registry_unique<std::unordered_set, false>", nb_nodes);
+  run_registry<hrw::utils::registry_unique<flat_set, false>::make<t_node, t_node_hash>>("registry_unique<flat_hash_set, false>", nb_nodes);
+  run_registry<hrw::utils::registry_arena<std_set>::make<t_node, t_node_hash>>("registry_arena<std::unordered_set>", nb_nodes);
+  run_registry<hrw::utils::registry_arena<flat_set>::make<t_node, t_node_hash>>("registry_arena<flat_hash_set>", nb_nodes);
+
+  run_map<std_map>("std::unordered_map", nb_nodes, nb_lookups);
+  run_map<flat_map>("flat_hash_map", nb_nodes, nb_lookups);
+
+  return 0;
+}
@@ -0,0 +1,154 @@
+/*
+ * This file is part of the hrewrite library.
+ * Copyright (c) 2021 ONERA.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+ // Author: Michael Lienhardt
+ // Maintainer: Michael Lienhardt
+ // email: michael.lienhardt@onera.fr
+
+
+
+// distribution in buckets and throughput of the hash of hash-consed terms: a constructor and the addresses of its children
+// usage: hash [nb_terms] [max_arity]
+
+#include "benchmarks/common.hpp"
+
+#include "hrewrite/utils/hash.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+
+// the combiner used before hash_mix
+struct hash_boost {
+  std::size_t m_content;
+  hash_boost& operator<<(std::size_t s) {
+    this->m_content ^= s + 0x9e3779b9 + (this->m_content<<6) + (this->m_content>>2);
+    return *this;
+  }
+};
+
+struct t_term {
+  unsigned int m_c;
+  std::vector<const t_term*> m_subs;
+};
+
+template<typename t_combine, typename t_ptr_hash>
+std::size_t hash_term(const t_term& t) {
+  t_combine res{t.m_c};
+  for(const t_term* s: t.m_subs) { res << t_ptr_hash()(s); }
+  return static_cast<std::size_t>(res.m_content);
+}
+
+struct hash_value_wrapper {
+  hrw::utils::hash_value m_content;
+  hash_value_wrapper& operator<<(std::size_t s) { this->m_content << s; return *this; }
+};
+
+
+// number of buckets used, maximal load and mean number of values sharing the bucket of a value
+void report_buckets(const std::string& name, const std::vector<std::size_t>& hashes, std::size_t nb_buckets, bool pow2) {
+  std::vector<std::size_t> buckets(nb_buckets, 0);
+  for(std::size_t h: hashes) { ++buckets[pow2?(h & (nb_buckets - 1)):(h % nb_buckets)]; }
+  std::size_t nb_empty = static_cast<std::size_t>(std::count(buckets.begin(), buckets.end(), 0));
+  std::size_t max_load = *std::max_element(buckets.begin(), buckets.end());
+  double sharing = 0;
+  for(std::size_t b: buckets) { sharing += static_cast<double>(b) * static_cast<double>(b); }
+  sharing /= static_cast<double>(hashes.size());
+  std::cout << "  " << std::left << std::setw(40) << name << std::right
+    << " empty: " << std::setw(6) << std::setprecision(1) << (100.0 * static_cast<double>(nb_empty) / static_cast<double>(nb_buckets)) << "%"
+    << "  max load: " << std::setw(5) << max_load
+    << "  sharing: " << std::setw(6) << std::setprecision(2) << sharing << std::endl;
+}
+
+template<typename t_combine, typename t_ptr_hash>
+void run(const std::string& name, const std::vector<std::unique_ptr<t_term>>& terms) {
+  bench::title(name);
+  std::vector<std::size_t> hashes;
+  hashes.reserve(terms.size());
+  double t = bench::time_ms([&]() {
+    for(const auto& term: terms) { hashes.push_back(hash_term<t_combine, t_ptr_hash>(*term)); }
+  });
+  bench::report("hash", terms.size(), t);
+
+  std::size_t nb_pow2 = 1;
+  while(nb_pow2 < terms.size()) { nb_pow2 <<= 1; }
+  report_buckets("power of two buckets", hashes, nb_pow2, true);
+  report_buckets("prime buckets", hashes, 1000003, false);
+
+  // registry of the terms, as in m_applications
+  struct t_hash { std::size_t operator()(const t_term* t) const { return hash_term<t_combine, t_ptr_hash>(*t); } };
+  std::unordered_set<const t_term*, t_hash> reg;
+  t = bench::time_ms([&]() {
+    for(const auto& term: terms) { reg.insert(term.get()); }
+  });
+  bench::report("unordered_set insert", terms.size(), t);
+  t = bench::time_ms([&]() {
+    std::size_t acc = 0;
+    for(const auto& term: terms) { acc += reg.count(term.get()); }
+    bench::keep(acc);
+  });
+  bench::report("unordered_set find", terms.size(), t);
+}
+
+// hash of the references to the terms, as in the registries and in m_applications
+template<typename t_ptr_hash>
+void run_pointers(const std::string& name, const std::vector<std::unique_ptr<t_term>>& terms) {
+  bench::title(name);
+  std::vector<std::size_t> hashes;
+  hashes.reserve(terms.size());
+  double t = bench::time_ms([&]() {
+    for(const auto& term: terms) { hashes.push_back(t_ptr_hash()(term.get())); }
+  });
+  bench::report("hash", terms.size(), t);
+
+  std::size_t nb_pow2 = 1;
+  while(nb_pow2 < terms.size()) { nb_pow2 <<= 1; }
+  report_buckets("power of two buckets", hashes, nb_pow2, true);
+  report_buckets("prime buckets", hashes, 1000003, false);
+}
+
+
+int main(int argc, char** argv) {
+  std::size_t nb_terms = bench::get_arg(argc, argv, 1, 1000000);
+  std::size_t max_arity = std::max<std::size_t>(1, bench::get_arg(argc, argv, 2, 2));
+
+  // a DAG of terms allocated one by one, as in a registry: a few leaves, then nodes on random previous terms
+  std::vector<std::unique_ptr<t_term>> terms;
+  terms.reserve(nb_terms);
+  std::uint64_t seed = 42;
+  for(std::size_t i = 0; i < nb_terms; ++i) {
+    std::size_t arity = (i < 16)?0:(1 + (i % max_arity));
+    auto t = std::make_unique<t_term>(t_term{static_cast<unsigned int>(i % 8), {}});
+    for(std::size_t j = 0; j < arity; ++j) {
+      seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+      t->m_subs.push_back(terms[(seed >> 33) % i].get());
+    }
+    terms.push_back(std::move(t));
+  }
+
+  run_pointers<std::hash<const t_term*>>("pointers, identity", terms);
+  run_pointers<hrw::utils::hash_mixed<const t_term*>>("pointers, hash_mixed", terms);
+  run<hash_boost, std::hash<const t_term*>>("boost combine, identity on pointers", terms);
+  run<hash_value_wrapper, std::hash<const t_term*>>("hash_value, identity on pointers", terms);
+  run<hash_value_wrapper, hrw::utils::hash_mixed<const t_term*>>("hash_value, hash_mixed on pointers", terms);
+
+  return 0;
+}
@@ -0,0 +1,129 @@
+/*
+ * This file is part of the hrewrite library.
+ * Copyright (c) 2021 ONERA.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+ // Author: Michael Lienhardt
+ // Maintainer: Michael Lienhardt
+ // email: michael.lienhardt@onera.fr
+
+// set operations on the different natset implementations
+// usage: natset [max_value] [nb_elements] [nb_iterations]
+
+#include "benchmarks/common.hpp"
+
+#include "hrewrite/utils/natset.hpp"
+
+#include <string>
+#include <vector>
+#include <random>
+
+using namespace hrw::utils;
+using t_nat = _natset_detail::t_nat;
+
+
+template<typename N>
+N create(std::size_t max) {
+  if constexpr(N::kind == e_natset_kind::FREE) {
+    return N();
+  } else {
+    return N(max);
+  }
+}
+
+template<typename N>
+void run(const std::string& name, std::size_t max, const std::vector<t_nat>& v1, const std::vector<t_nat>& v2, std::size_t nb_iterations) {
+  bench::title(name);
+  N s1 = create<N>(max);
+  N s2 = create<N>(max);
+  for(t_nat v: v1) { s1.insert(v); }
+  for(t_nat v: v2) { s2.insert(v); }
+
+  double t = bench::time_ms([&]() {
+    std::size_t acc = 0;
+    for(std::size_t i = 0; i < nb_iterations; ++i) {
+      for(t_nat v: s1) { acc += v; }
+    }
+    bench::keep(acc);
+  });
+  bench::report("iteration (sets)", nb_iterations, t);
+
+  t = bench::time_ms([&]() {
+    std::size_t acc = 0;
+    for(std::size_t i = 0; i < nb_iterations; ++i) {
+      for(t_nat v = 0; v < max; ++v) { acc += s1.contains(v); }
+    }
+    bench::keep(acc);
+  });
+  bench::report("contains (full scan)", nb_iterations, t);
+
+  t = bench::time_ms([&]() {
+    std::size_t acc = 0;
+    for(std::size_t i = 0; i < nb_iterations; ++i) { acc += s1.cup(s2).empty(); }
+    bench::keep(acc);
+  });
+  bench::report("cup", nb_iterations, t);
+
+  t = bench::time_ms([&]() {
+    std::size_t acc = 0;
+    for(std::size_t i = 0; i < nb_iterations; ++i) { acc += s1.cap(s2).empty(); }
+    bench::keep(acc);
+  });
+  bench::report("cap", nb_iterations, t);
+
+  N s = create<N>(max);
+  t = bench::time_ms([&]() {
+    for(std::size_t i = 0; i < nb_iterations; ++i) {
+      s.clear();
+      s.cup_update(s1);
+      s.cap_update(s2);
+    }
+    bench::keep(s.empty());
+  });
+  bench::report("clear + cup_update + cap_update", nb_iterations, t);
+
+  t = bench::time_ms([&]() {
+    std::size_t acc = 0;
+    for(std::size_t i = 0; i < nb_iterations; ++i) { acc += s1.includes(s) + s2.includes(s1); }
+    bench::keep(acc);
+  });
+  bench::report("includes", nb_iterations, t);
+}
+
+
+int main(int argc, char** argv) {
+  constexpr std::size_t limit = 1024;
+  std::size_t max = bench::get_arg(argc, argv, 1, limit);
+  std::size_t nb_elements = bench::get_arg(argc, argv, 2, 64);
+  std::size_t nb_iterations = bench::get_arg(argc, argv, 3, 100000);
+
+  std::mt19937 gen;
+  std::uniform_int_distribution<t_nat> distrib(0, static_cast<t_nat>(max - 1));
+  std::vector<t_nat> v1, v2;
+  for(std::size_t i = 0; i < nb_elements; ++i) {
+    v1.push_back(distrib(gen));
+    v2.push_back(distrib(gen));
+  }
+
+  if(max < limit) {
+    run<natset_static<limit>>("natset_static<" + std::to_string(limit) + ">", max, v1, v2, nb_iterations);
+  }
+  run<natset_fixed<>>("natset_fixed", max, v1, v2, nb_iterations);
+  run<natset_extensible<64>>("natset_extensible<64>", max, v1, v2, nb_iterations);
+  run<natset_extensible<8>>("natset_extensible<8>", max, v1, v2, nb_iterations);
+  run<tt_natset<natset_extensible<64>>>("tt_natset<natset_extensible<64>>", max, v1, v2, nb_iterations);
+
+  return 0;
+}
@@ -0,0 +1,72 @@
+/*
+ * This file is part of the hrewrite library.
+ * Copyright (c) 2021 ONERA.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+ // Author: Michael Lienhardt
+ // Maintainer: Michael Lienhardt
+ // email: michael.lienhardt@onera.fr
+
+
+
+// filling a registry with distinct values and clearing it, as done by a context_term between two computations
+// usage: pool [nb_values] [nb_rounds]
+
+#include "benchmarks/common.hpp"
+
+#include "hrewrite/utils/container.hpp"
+
+#include <string>
+#include <unordered_set>
+
+
+struct t_value {
+  std::size_t m_a, m_b, m_c;
+};
+bool operator==(const t_value& v1, const t_value& v2) { return (v1.m_a == v2.m_a) && (v1.m_b == v2.m_b) && (v1.m_c == v2.m_c); }
+struct t_value_hash {
+  std::size_t operator()(const t_value& v) const { return std::hash<std::size_t>()(v.m_a * 31 + v.m_b * 7 + v.m_c); }
+};
+
+
+template<template<typename> typename Allocator>
+void run(const std::string& name, std::size_t nb_values, std::size_t nb_rounds) {
+  bench::title(name);
+  using t_reg = hrw::utils::registry_unique<std::unordered_set, false, false>::make<t_value, t_value_hash, std::equal_to<t_value>, Allocator>;
+  t_reg reg;
+
+  double t_add = 0, t_clear = 0;
+  for(std::size_t r = 0; r < nb_rounds; ++r) {
+    t_add += bench::time_ms([&]() {
+      for(std::size_t i = 0; i < nb_values; ++i) {
+        bench::keep(reg.add(t_value{i, i + r, r}));
+      }
+    });
+    t_clear += bench::time_ms([&]() { reg.clear(); });
+  }
+  bench::report("add", nb_values * nb_rounds, t_add);
+  bench::report("clear", nb_values * nb_rounds, t_clear);
+}
+
+
+int main(int argc, char** argv) {
+  std::size_t nb_values = bench::get_arg(argc, argv, 1, 1000000);
+  std::size_t nb_rounds = bench::get_arg(argc, argv, 2, 5);
+
+  run<std::allocator>("std::allocator", nb_values, nb_rounds);
+  run<hrw::utils::pool_allocator>("pool_allocator", nb_values, nb_rounds);
+
+  return 0;
+}
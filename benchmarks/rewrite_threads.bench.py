@@ -0,0 +1,91 @@
+#
+# This file is part of the hrewrite library.
+# Copyright (c) 2021 ONERA.
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, version 3.
+#
+# This program is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+# General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program. If not, see <http://www.gnu.org/licenses/>.
+#
+
+# Author: Michael Lienhardt
+# Maintainer: Michael Lienhardt
+# email: michael.lienhardt@onera.fr
+
+
+# rewriting without guards releases the GIL: this benchmark compares running
+# python work and rewritings sequentially and in parallel.
+# usage (from the root of the repository): python3 benchmarks/rewrite_threads.bench.py [nb_threads] [depth]
+
+import sys
+import time
+import threading
+
+sys.path.insert(0, ".")
+import python as hrw
+
+
+def python_work(n):
+  res = 0
+  for i in range(n):
+    res += (i * i) % 7
+  return res
+
+
+def main():
+  nb_threads = int(sys.argv[1]) if(len(sys.argv) > 1) else 4
+  depth      = int(sys.argv[2]) if(len(sys.argv) > 2) else 200
+
+  hrw.sort("num")
+  zero = hrw.constructor("zero", hrw.free("") >> "num")
+  succ = hrw.constructor("succ", hrw.free("num") >> "num")
+  plus = hrw.constructor("plus", hrw.free("num num") >> "num")
+
+  alpha, beta = hrw.vars("num", "num")
+  rw = hrw.rw_engine_cls()
+  rw.add(plus(zero, beta), beta)
+  rw.add(plus(succ(alpha), beta), succ(plus(alpha, beta)))
+
+  def number(n):
+    res = zero.data
+    for _ in range(n):
+      res = succ(res)
+    return res
+
+  # each job rewrites a distinct term, so that the normal form cache does not hide the work
+  terms = [plus(number(depth + i), number(depth)) for i in range(nb_threads)]
+  work = 2000 * depth
+
+  def job(t):
+    rw.rewrite(t)
+
+  start = time.perf_counter()
+  for t in terms:
+    job(t)
+    python_work(work)
+  sequential = time.perf_counter() - start
+
+  rw.clear_nf()
+  terms = [plus(number(depth + i), number(depth + 1)) for i in range(nb_threads)]
+
+  start = time.perf_counter()
+  threads = [threading.Thread(target=job, args=(t,)) for t in terms]
+  for th in threads: th.start()
+  for _ in terms: python_work(work)
+  for th in threads: th.join()
+  parallel = time.perf_counter() - start
+
+  print(f"rewrite_threads: threads={nb_threads} depth={depth}")
+  print(f"  sequential: {sequential * 1000:.2f} ms")
+  print(f"  parallel  : {parallel * 1000:.2f} ms")
+
+
+if(__name__ == "__main__"):
+  main()
@@ -0,0 +1,116 @@
+/*
+ * This file is part of the hrewrite library.
+ * Copyright (c) 2021 ONERA.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+ // Author: Michael Lienhardt
+ // Maintainer: Michael Lienhardt
+ // email: michael.lienhardt@onera.fr
+
+
+// construction of the children lists of free terms, as done by create_sterm_from_diff, instantiate and rewrite
+// usage: small_vector [nb_terms] [max_arity]
+
+#include "benchmarks/common.hpp"
+
+#include "hrewrite/utils/container.hpp"
+
+#include <string>
+#include <vector>
+
+
+// allocator counting the number of allocations
+static std::size_t nb_allocations = 0;
+
+template<typename T>
+struct counting_allocator {
+  using value_type = T;
+  counting_allocator() = default;
+  template<typename U> counting_allocator(const counting_allocator<U>&) {}
+  T* allocate(std::size_t n) { ++nb_allocations; return std::allocator<T>().allocate(n); }
+  void deallocate(T* p, std::size_t n) { std::allocator<T>().deallocate(p, n); }
+  friend bool operator==(const counting_allocator&, const counting_allocator&) { return true; }
+  friend bool operator!=(const counting_allocator&, const counting_allocator&) { return false; }
+};
+
+
+// a free term: a constructor and its children (references to previously built terms)
+template<template<typename> typename tt_container>
+struct t_term {
+  using t_container = tt_container<const t_term*>;
+  unsigned int m_c;
+  t_container m_subs;
+};
+
+
+template<template<typename> typename tt_container>
+void run(const std::string& name, std::size_t nb_terms, std::size_t max_arity) {
+  bench::title(name + " (arity 0 to " + std::to_string(max_arity) + ")");
+  using T = t_term<tt_container>;
+  using C = typename T::t_container;
+  using t_ref = const T*;
+  std::vector<T> terms;
+  terms.reserve(nb_terms);
+
+  nb_allocations = 0;
+  double t = bench::time_ms([&]() {
+    for(std::size_t i = 0; i < nb_terms; ++i) {
+      C c;
+      std::size_t arity = (terms.empty())?0:(i % (max_arity + 1));
+      for(std::size_t j = 0; j < arity; ++j) { c.push_back(&(terms[(i * 7 + j * 13) % terms.size()])); }
+      terms.push_back(T{static_cast<unsigned int>(i), std::move(c)});
+    }
+  });
+  bench::report("build", nb_terms, t);
+  std::cout << "  allocations: " << nb_allocations << std::endl;
+
+  t = bench::time_ms([&]() {
+    std::size_t acc = 0;
+    for(const T& term: terms) {
+      for(t_ref s: term.m_subs) { acc += s->m_c; }
+    }
+    bench::keep(acc);
+  });
+  bench::report("traversal", nb_terms, t);
+
+  // rebuild every term from its children, as in a rewriting step that changes nothing
+  nb_allocations = 0;
+  t = bench::time_ms([&]() {
+    std::size_t acc = 0;
+    for(const T& term: terms) {
+      C c;
+      for(t_ref s: term.m_subs) { c.push_back(s); }
+      T tmp{term.m_c, std::move(c)};
+      acc += tmp.m_subs.size();
+    }
+    bench::keep(acc);
+  });
+  bench::report("rebuild", nb_terms, t);
+  std::cout << "  allocations: " << nb_allocations << std::endl;
+}
+
+template<typename T> using t_vector = std::vector<T, counting_allocator<T>>;
+template<typename T> using t_small_vector = hrw::utils::small_vector<T, 4, counting_allocator<T>>;
+
+
+int main(int argc, char** argv) {
+  std::size_t nb_terms = bench::get_arg(argc, argv, 1, 1000000);
+  std::size_t max_arity = bench::get_arg(argc, argv, 2, 2);
+
+  run<t_vector>("std::vector", nb_terms, max_arity);
+  run<t_small_vector>("small_vector<4>", nb_terms, max_arity);
+
+  return 0;
+}
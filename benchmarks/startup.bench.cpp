@@ -0,0 +1,87 @@
+/*
+ * This file is part of the hrewrite library.
+ * Copyright (c) 2021 ONERA.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+ // Author: Michael Lienhardt
+ // Maintainer: Michael Lienhardt
+ // email: michael.lienhardt@onera.fr
+
+// declaration of a large signature: sorts, subsorts and constructors, with lookups by name
+// usage: startup [nb_sorts] [nb_constructors]
+
+#include "benchmarks/common.hpp"
+
+#include "hrewrite/utils.hpp"
+#include "hrewrite/context_sort.hpp"
+#include "hrewrite/context_constructor.hpp"
+
+#include <string>
+#include <vector>
+
+
+int main(int argc, char** argv) {
+  std::size_t nb_sorts = bench::get_arg(argc, argv, 1, 20000);
+  std::size_t nb_constructors = bench::get_arg(argc, argv, 2, 50000);
+
+  using t_ctx_sort = hrw::context_sort<hrw::utils::natset_extensible<64>>;
+  using t_ctx_constructor = hrw::context_constructor<void>;
+
+  bench::title("startup: " + std::to_string(nb_sorts) + " sorts, " + std::to_string(nb_constructors) + " constructors");
+
+  std::vector<std::string> sort_names;
+  sort_names.reserve(nb_sorts);
+  for(std::size_t i = 0; i < nb_sorts; ++i) { sort_names.push_back("Sort_" + std::to_string(i)); }
+  std::vector<std::string> constructor_names;
+  constructor_names.reserve(nb_constructors);
+  for(std::size_t i = 0; i < nb_constructors; ++i) { constructor_names.push_back("constructor_" + std::to_string(i)); }
+
+  t_ctx_sort ctx_sort;
+  t_ctx_constructor ctx_constructor;
+
+  double t = bench::time_ms([&]() {
+    for(const std::string& name: sort_names) { ctx_sort.add_sort(name); }
+  });
+  bench::report("add_sort", nb_sorts, t);
+
+  // a binary tree of sorts
+  t = bench::time_ms([&]() {
+    for(std::size_t i = 1; i < nb_sorts; ++i) { ctx_sort.add_subsort(sort_names[i], sort_names[(i - 1) / 2]); }
+  });
+  bench::report("add_subsort (by name)", nb_sorts - 1, t);
+
+  t = bench::time_ms([&]() {
+    hrw::t_sort_id acc = 0;
+    for(const std::string& name: sort_names) { acc += ctx_sort.get_letter(name); }
+    bench::keep(acc);
+  });
+  bench::report("get_letter", nb_sorts, t);
+
+  t = bench::time_ms([&]() {
+    for(std::size_t i = 0; i < nb_constructors; ++i) {
+      ctx_constructor.add_constructor(static_cast<hrw::t_sort_id>(i % nb_sorts), constructor_names[i]);
+    }
+  });
+  bench::report("add_constructor", nb_constructors, t);
+
+  t = bench::time_ms([&]() {
+    std::size_t acc = 0;
+    for(const std::string& name: constructor_names) { acc += ctx_constructor.contains(name); }
+    bench::keep(acc);
+  });
+  bench::report("contains (constructor name)", nb_constructors, t);
+
+  return 0;
+}
@@ -0,0 +1,131 @@
+/*
+ * This file is part of the hrewrite library.
+ * Copyright (c) 2021 ONERA.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+ // Author: Michael Lienhardt
+ // Maintainer: Michael Lienhardt
+ // email: michael.lienhardt@onera.fr
+
+// reading terms from their textual form: from a string in memory, and from a mapped file
+// usage: text [nb_terms] [depth]
+
+#include "benchmarks/common.hpp"
+
+#include "hrewrite/hrewrite.hpp"
+#include "hrewrite/theory/theory_free.hpp"
+#include "hrewrite/theory/theory_literal.hpp"
+#include "hrewrite/theory/theory_variable.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+
+struct t_id {};
+
+template<typename t_alphabet, const t_alphabet& alphabet>
+using my_automata = hrw::utils::tt_automata<hrw::utils::natset, hrw::utils::natset>::template type<t_alphabet, alphabet>;
+template<typename t_alphabet, const t_alphabet& alphabet>
+using t_vparser = hrw::utils::combine_variant<t_alphabet, alphabet, hrw::utils::element, my_automata>;
+template<typename t_alphabet, const t_alphabet& alphabet>
+using t_sparser = hrw::utils::combine_variant<t_alphabet, alphabet, hrw::utils::sequence, my_automata>;
+
+template<typename ... Args> using unordered_set_wrapper = std::unordered_set<Args...>;
+
+using t_ctx_th = hrw::context_theory<t_id,
+  hrw::context_sort<hrw::utils::natset>,
+  hrw::theory::tp_theory_variable_vector<t_vparser>::template type,
+  hrw::theory::tp_theory_free<hrw::utils::small_vector_default, t_sparser>::template type,
+  hrw::theory::tp_theory_literal<int>::template type
+>;
+using t_ctx_tm = hrw::context_term<t_ctx_th, hrw::utils::registry_unique<unordered_set_wrapper, true>>;
+using t_term_full_ref = typename t_ctx_tm::t_term_full_ref;
+using t_theory_free = std::tuple_element_t<0, typename t_ctx_th::theories_structured>;
+using t_theory_lit = std::tuple_element_t<1, typename t_ctx_th::theories_structured>;
+
+
+int main(int argc, char** argv) {
+  std::size_t nb_terms = bench::get_arg(argc, argv, 1, 100000);
+  std::size_t depth = std::max<std::size_t>(1, bench::get_arg(argc, argv, 2, 4));
+
+  hrw::t_sort_id sort = t_ctx_th::add_sort("num");
+  auto c_lit = t_ctx_th::template add_constructor<t_theory_lit>(sort, "lit");
+  auto c_node = t_ctx_th::template add_constructor<t_theory_free>(sort, "node", "num num");
+
+  // complete binary trees whose leaves are random literals
+  std::uint64_t seed = 42;
+  auto next = [&seed]() { seed = seed * 6364136223846793005ull + 1442695040888963407ull; return static_cast<unsigned int>((seed >> 33) % 100000); };
+  std::string text;
+  std::size_t nb_nodes = 0;
+  auto write = [&](auto& self, std::size_t d) -> void {
+    ++nb_nodes;
+    if(d == 0) {
+      text += "(lit " + std::to_string(next()) + ")";
+    } else {
+      text += "(node ";
+      self(self, d - 1);
+      text += " ";
+      self(self, d - 1);
+      text += ")";
+    }
+  };
+  for(std::size_t i = 0; i < nb_terms; ++i) {
+    write(write, depth);
+    text += "\n";
+  }
+
+  bench::title("text: " + std::to_string(nb_terms) + " terms, " + std::to_string(nb_nodes) + " nodes, " + std::to_string(text.size() >> 20) + " MB");
+  auto report = [&](const std::string& name, double t) {
+    bench::report(name, nb_nodes, t);
+    std::cout << "  " << std::string(40, ' ') << std::setw(10) << std::setprecision(1) << ((static_cast<double>(text.size()) / (1 << 20)) / (t / 1000.)) << " MB/s" << std::endl;
+  };
+
+  for(bool check: {true, false}) {
+    t_ctx_tm ctx_tm;
+    hrw::term_text_parser<t_ctx_tm> parser(ctx_tm, check);
+    parser.declare(c_lit);
+    parser.declare(c_node);
+    std::size_t nb = 0;
+    double t = bench::time_ms([&]() {
+      parser.parse(text, [&nb](t_term_full_ref) { ++nb; }, [](t_term_full_ref, t_term_full_ref) {});
+    });
+    bench::keep(nb);
+    report(std::string("parse from memory, ") + (check ? "checked" : "unchecked"), t);
+  }
+  {
+    std::string path = "hrewrite_bench_text.txt";
+    {
+      std::ofstream out(path, std::ios::binary);
+      out << text;
+    }
+    t_ctx_tm ctx_tm;
+    hrw::term_text_parser<t_ctx_tm> parser(ctx_tm);
+    parser.declare(c_lit);
+    parser.declare(c_node);
+    std::size_t nb = 0;
+    double t = bench::time_ms([&]() {
+      parser.parse_file(path, [&nb](t_term_full_ref) { ++nb; }, [](t_term_full_ref, t_term_full_ref) {});
+    });
+    bench::keep(nb);
+    std::remove(path.c_str());
+    report("parse from a mapped file, checked", t);
+  }
+
+  return 0;
+}
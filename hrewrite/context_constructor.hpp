@@ -24,10 +24,14 @@
 #define __HREWRITE_C_CONSTRUCTOR_H__
 
 #include <string>
-#include <vector>
+#include <string_view>
+#include <deque>
+#include <unordered_map>
 
 #include "hrewrite/utils.hpp"
+#include "hrewrite/parsing/intern.hpp"
 #include "hrewrite/theory/core.hpp"
+#include "hrewrite/exceptions/undeclared.hpp"
 
 namespace hrw {
 
@@ -49,25 +53,30 @@ namespace hrw {
     const t_spec& get_spec(t_constructor_id c) const;
 
     bool contains(const t_constructor_id c) const;
-    bool contains(const std::string& name) const;
+    bool contains(std::string_view name) const;
+    // the last constructor declared with that name
+    t_constructor_id get_id(std::string_view name) const;
 
-    void clear() { this->m_constructors.clear(); }
+    void clear() {
+      this->m_constructors.clear();
+      this->m_constructor_names.clear();
+    }
 
   private:
+    using t_spec_ref = typename hrw::utils::spec_intern<t_spec>::reference;
     struct container_constructor {
-      container_constructor(const t_sort_id sort, const std::string& name, const t_spec& spec): m_sort(sort), m_name(name), m_spec(spec) {}
-      container_constructor(const t_sort_id sort, const std::string& name, t_spec&& spec): m_sort(sort), m_name(name), m_spec(spec) {}
-      container_constructor(const t_sort_id sort, std::string&& name, const t_spec& spec): m_sort(sort), m_name(name), m_spec(spec) {}
-      container_constructor(const t_sort_id sort, std::string&& name, t_spec&& spec): m_sort(sort), m_name(name), m_spec(spec) {}
+      container_constructor(const t_sort_id sort, const std::string& name, t_spec_ref spec): m_sort(sort), m_name(name), m_spec(spec) {}
+      container_constructor(const t_sort_id sort, std::string&& name, t_spec_ref spec): m_sort(sort), m_name(name), m_spec(spec) {}
       t_sort_id sort() const { return this->m_sort; }
       const std::string& name() const { return this->m_name; }
-      const t_spec& spec() const { return this->m_spec; }
+      const t_spec& spec() const { return *(this->m_spec); }
 
       const t_sort_id m_sort;
       const std::string m_name;
-      const t_spec m_spec;
+      const t_spec_ref m_spec;
     };
-    std::vector<container_constructor> m_constructors;
+    std::deque<container_constructor> m_constructors;
+    std::unordered_map<std::string_view, t_constructor_id> m_constructor_names; // views on the names stored in m_constructors
   };
 
 
@@ -86,9 +95,14 @@ namespace hrw {
     const std::string& get_name(t_constructor_id c) const;
 
     bool contains(const t_constructor_id c) const;
-    bool contains(const std::string& name) const;
+    bool contains(std::string_view name) const;
+    // the last constructor declared with that name
+    t_constructor_id get_id(std::string_view name) const;
 
-    void clear() { this->m_constructors.clear(); }
+    void clear() {
+      this->m_constructors.clear();
+      this->m_constructor_names.clear();
+    }
 
   private:
     struct container_constructor {
@@ -100,7 +114,8 @@ namespace hrw {
       const t_sort_id m_sort;
       const std::string m_name;
     };
-    std::vector<container_constructor> m_constructors;
+    std::deque<container_constructor> m_constructors;
+    std::unordered_map<std::string_view, t_constructor_id> m_constructor_names; // views on the names stored in m_constructors
   };
 
 
@@ -113,16 +128,20 @@ namespace hrw {
 
   template<typename targ_spec>
   t_constructor_id context_constructor<targ_spec>::add_constructor(const t_sort_id sort, const std::string& name, const std::string& spec) {
-    this->m_constructors.emplace_back(container_constructor(sort, name, t_spec(spec)));
+    this->m_constructors.emplace_back(container_constructor(sort, name, hrw::utils::spec_intern<t_spec>::get(spec)));
     // std::cout << "add_constructor[spec][" << this << "](" << sort << ", " << name << ", " << spec << ") -> " << (this->m_constructors.size() - 1) << std::endl;
-    return (this->m_constructors.size() - 1);
+    t_constructor_id res = this->m_constructors.size() - 1;
+    this->m_constructor_names[this->m_constructors.back().name()] = res;
+    return res;
   }
 
   template<typename targ_spec>
   t_constructor_id context_constructor<targ_spec>::add_constructor(const t_sort_id sort, std::string&& name, std::string&& spec) {
-    this->m_constructors.emplace_back(container_constructor(sort, std::forward<std::string>(name), t_spec(spec)));
+    this->m_constructors.emplace_back(container_constructor(sort, std::forward<std::string>(name), hrw::utils::spec_intern<t_spec>::get(spec)));
     // std::cout << "add_constructor[spec][" << this << "](" << sort << ", " << name << ", " << spec << ") -> " << (this->m_constructors.size() - 1) << std::endl;
-    return (this->m_constructors.size() - 1);
+    t_constructor_id res = this->m_constructors.size() - 1;
+    this->m_constructor_names[this->m_constructors.back().name()] = res;
+    return res;
   }
 
   template<typename targ_spec>
@@ -146,13 +165,17 @@ namespace hrw {
     return (this->m_constructors.size() > c);
   }
   template<typename targ_spec>
-  bool context_constructor<targ_spec>::contains(const std::string& name) const {
-    for(auto cdata: this-> m_constructors) {
-      if(name == cdata.m_name) {
-        return true;
-      }
+  bool context_constructor<targ_spec>::contains(std::string_view name) const {
+    return (this->m_constructor_names.find(name) != this->m_constructor_names.end());
+  }
+  template<typename targ_spec>
+  t_constructor_id context_constructor<targ_spec>::get_id(std::string_view name) const {
+    auto it = this->m_constructor_names.find(name);
+    if(it == this->m_constructor_names.end()) {
+      throw hrw::exception::ndeclared_constructor(std::string(name));
+    } else {
+      return it->second;
     }
-    return false;
   }
 
 
@@ -162,7 +185,9 @@ namespace hrw {
   inline t_constructor_id context_constructor<void>::add_constructor(const t_sort_id sort, const std::string& name) {
     this->m_constructors.emplace_back(container_constructor(sort, name));
     // std::cout << "add_constructor[void][" << this << "](" << sort << ", " << name << ") -> " << (this->m_constructors.size() - 1) << std::endl;
-    return (this->m_constructors.size() - 1);
+    t_constructor_id res = this->m_constructors.size() - 1;
+    this->m_constructor_names[this->m_constructors.back().name()] = res;
+    return res;
   }
 
   inline t_sort_id context_constructor<void>::get_sort(t_constructor_id c) const {
@@ -177,13 +202,16 @@ namespace hrw {
     // std::cout << "contains[void][" << this << "](" << c << ") vs " << (this->m_constructors.size()) << std::endl;
     return (this->m_constructors.size() > c);
   }
-  inline bool context_constructor<void>::contains(const std::string& name) const {
-    for(auto cdata: this-> m_constructors) {
-      if(name == cdata.m_name) {
-        return true;
-      }
+  inline bool context_constructor<void>::contains(std::string_view name) const {
+    return (this->m_constructor_names.find(name) != this->m_constructor_names.end());
+  }
+  inline t_constructor_id context_constructor<void>::get_id(std::string_view name) const {
+    auto it = this->m_constructor_names.find(name);
+    if(it == this->m_constructor_names.end()) {
+      throw hrw::exception::ndeclared_constructor(std::string(name));
+    } else {
+      return it->second;
     }
-    return false;
   }
 
 
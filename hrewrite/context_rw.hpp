@@ -26,9 +26,11 @@
 #include <vector>
 #include <tuple>
 #include <stack>
+#include <atomic>
 
 #include <iostream>
 #include <functional>
+#include <optional>
 
 #include "hrewrite/utils/variant.hpp"
 #include "hrewrite/hterm_print.hpp"
@@ -92,7 +94,7 @@ namespace hrw {
               c.push_back(this->m_ctx.template rewrite_by_need<has_limit, e_rw_status::FULL>(s));
             }
           }
-          return this->m_ctx.m_ctx_term.template create_sterm_from_diff<t_term>(t, std::move(c));
+          return this->m_ctx.m_ctx_term.template create_sterm_from_diff<t_term>(this->m_t, t, std::move(c));
         } else if constexpr(t_configuration::conf == e_configuration::SWAP) {
           bool res = false;
           for(t_term_full_ref s: t) {
@@ -117,7 +119,7 @@ namespace hrw {
               c.push_back(tmp.second);                
             }
           }
-          return std::make_pair(res, this->m_ctx.m_ctx_term.template create_sterm_from_diff<t_term>(t, std::move(c)));
+          return std::make_pair(res, this->m_ctx.m_ctx_term.template create_sterm_from_diff<t_term>(this->m_t, t, std::move(c)));
         }
       } else {
         if constexpr(t_configuration::conf == e_configuration::STORE) {
@@ -180,9 +182,23 @@ namespace hrw {
       t_term_full_ref
     >;
 
+    // with reference counting, the recorded rule applications do not keep their source term alive:
+    // an application is removed when its source term is released
+    static inline constexpr bool weak_cache_v = t_configuration::store_v && t_ctx_term::t_registry::ref_counting;
 
 
-    context_rw(t_ctx_term& ctx): m_ctx_term(ctx), m_substitution() {};
+
+    context_rw(t_ctx_term& ctx): m_ctx_term(ctx), m_substitution(), m_has_guard(false) {
+      if constexpr(weak_cache_v) {
+        this->m_release_id = this->m_ctx_term.add_release_callback([this](const t_term_full* t) { this->release_nf(t); });
+      }
+    }
+    context_rw(const context_rw&) = delete;
+    ~context_rw() {
+      if constexpr(weak_cache_v) {
+        this->m_ctx_term.remove_release_callback(this->m_release_id);
+      }
+    }
 
     t_ctx_term& get_ctx_term() { return this->m_ctx_term; }
 
@@ -202,14 +218,30 @@ namespace hrw {
     void add(type const & ctx_rw);
     void clear();
     void clear_nf();
+    // true if one of the rules has a guard
+    bool has_guard() const { return this->m_has_guard; }
+
+
+    //////////////////////////////////////////
+    // garbage collection
+
+    // applies f on the terms used by this context: the rules, and the recorded rule applications
+    template<typename F>
+    void for_each_root(F&& f) const;
+    // collects the terms of the term context that are not used by this context nor registered as roots
+    std::size_t collect() { return this->m_ctx_term.collect(*this); }
 
 
     //////////////////////////////////////////
     // rewriting
 
+    // with a step budget, the rewriting throws rw_limit when it would apply more rules than the budget.
+    // The budget may be lowered by another thread to cancel the rewriting
     template<e_strategy stg=e_strategy::STY_INNER>
     t_term_full_ref rewrite(t_term_full_ref t, unsigned int nb_steps);
     template<e_strategy stg=e_strategy::STY_INNER>
+    t_term_full_ref rewrite(t_term_full_ref t, const std::atomic<unsigned int>& budget);
+    template<e_strategy stg=e_strategy::STY_INNER>
     t_term_full_ref rewrite(t_term_full_ref t);
     unsigned int get_rw_count() const;
 
@@ -253,19 +285,57 @@ namespace hrw {
     using t_rule = std::tuple<t_term_full_ref, t_term_full_ref, t_guard>;
     using t_rules = std::vector<std::vector<t_rule>>;
     t_rules m_rules[nb_alternative];
+    bool m_has_guard;
 
     //////////////////////////
     // rule application repo
     template<bool store, typename=void> struct t_registry_make { struct type {}; };
-    template<bool store> struct t_registry_make<store, std::enable_if_t<store, void>> { using type = targ_map<t_term_full_ref, t_term_full_ref, t_term_full_ref_hash>; };
+    template<bool store> struct t_registry_make<store, std::enable_if_t<store && !weak_cache_v, void>> { using type = targ_map<t_term_full_ref, t_term_full_ref, t_term_full_ref_hash>; };
+    // in the weak cache, the image of an application is empty when it is the source term
+    template<bool store> struct t_registry_make<store, std::enable_if_t<store && weak_cache_v, void>> { using type = targ_map<const t_term_full*, std::optional<t_term_full_ref>, hrw::utils::hash_mixed<const t_term_full*>>; };
     using t_registry = typename t_registry_make<t_configuration::store_v>::type;
     t_registry m_applications;
+    std::size_t m_release_id;
+
+    auto find_nf(t_term_full_ref t) {
+      if constexpr(weak_cache_v) {
+        return this->m_applications.find(t_term_full::make_ptr_struct::to_ptr(t));
+      } else {
+        return this->m_applications.find(t);
+      }
+    }
+    template<typename It>
+    static t_term_full_ref get_nf(It it, t_term_full_ref t) {
+      if constexpr(weak_cache_v) {
+        return (it->second.has_value())?(*(it->second)):t;
+      } else {
+        return it->second;
+      }
+    }
+    void add_nf(t_term_full_ref t, t_term_full_ref nf) {
+      if constexpr(weak_cache_v) {
+        std::optional<t_term_full_ref> image;
+        if(t != nf) {
+          image.emplace(nf);
+        }
+        this->m_applications.insert(std::make_pair(t_term_full::make_ptr_struct::to_ptr(t), image));
+      } else {
+        this->m_applications.insert(std::make_pair(t, nf));
+      }
+    }
+    void release_nf(const t_term_full* t) {
+      auto it = this->m_applications.find(t);
+      if(it != this->m_applications.end()) {
+        std::optional<t_term_full_ref> image(it->second); // released after the erase, as it may release other terms
+        this->m_applications.erase(it);
+      }
+    }
 
 
     //////////////////////////
     // rewriting helpers
     unsigned int m_rw_count;
-    unsigned int m_rw_count_max;
+    const std::atomic<unsigned int>* m_rw_budget;
 
     using t_rw_result = typename t_configuration::t_result;
 
@@ -318,6 +388,7 @@ namespace hrw {
       if(rule_reg.size() <= constructor) {
         rule_reg.resize(constructor+1);
       }
+      this->m_has_guard = this->m_has_guard || static_cast<bool>(guard);
       rule_reg[constructor].emplace_back(std::make_tuple(pattern, image, guard));
     } else {
       throw hrw::exception::rw_pattern();
@@ -332,6 +403,7 @@ namespace hrw {
       throw hrw::exception::generic("ERROR: can only update a rewriting context with another one using the same term context");
     }
 
+    this->m_has_guard = this->m_has_guard || ctx_rw.m_has_guard;
     for(std::size_t idx = 0; idx < type::nb_alternative; ++idx) {
       if(this->m_rules[idx].size() < ctx_rw.m_rules[idx].size()) {
         this->m_rules[idx].resize(ctx_rw.m_rules[idx].size());
@@ -349,12 +421,41 @@ namespace hrw {
     for(std::size_t i = 0; i < t_term_full::nb_alternative - 1; ++i) {
       this->m_rules[i].clear(); // clear all the rules
     }
+    this->m_has_guard = false;
     this->clear_nf();
   }
 
   template<typename targ_ctx_term, template<typename ... Args> typename targ_map>
   void context_rw<targ_ctx_term, targ_map>::clear_nf() {
-    this->m_applications.clear(); // clear all the recorded rule application
+    if constexpr(weak_cache_v) {
+      // the released terms are removed from m_applications while tmp is destroyed
+      t_registry tmp;
+      tmp.swap(this->m_applications);
+    } else {
+      this->m_applications.clear(); // clear all the recorded rule application
+    }
+  }
+
+  //////////////////////////////////////////
+  // garbage collection
+
+  template<typename targ_ctx_term, template<typename ... Args> typename targ_map>
+  template<typename F>
+  void context_rw<targ_ctx_term, targ_map>::for_each_root(F&& f) const {
+    for(std::size_t idx = 0; idx < type::nb_alternative; ++idx) {
+      for(const auto& rules: this->m_rules[idx]) {
+        for(const t_rule& rule: rules) {
+          f(std::get<0>(rule));
+          f(std::get<1>(rule));
+        }
+      }
+    }
+    if constexpr(t_configuration::store_v && !weak_cache_v) {
+      for(const auto& application: this->m_applications) {
+        f(application.first);
+        f(application.second);
+      }
+    }
   }
 
   //////////////////////////////////////////
@@ -383,8 +484,15 @@ namespace hrw {
   template<typename targ_ctx_term, template<typename ... Args> typename targ_map>
   template<e_strategy stg>
   typename context_rw<targ_ctx_term, targ_map>::t_term_full_ref context_rw<targ_ctx_term, targ_map>::rewrite(t_term_full_ref t, unsigned int max_rw_cout) {
+    const std::atomic<unsigned int> budget(max_rw_cout);
+    return this->template rewrite<stg>(t, budget);
+  }
+
+  template<typename targ_ctx_term, template<typename ... Args> typename targ_map>
+  template<e_strategy stg>
+  typename context_rw<targ_ctx_term, targ_map>::t_term_full_ref context_rw<targ_ctx_term, targ_map>::rewrite(t_term_full_ref t, const std::atomic<unsigned int>& budget) {
     this->m_rw_count = 0;
-    this->m_rw_count_max = max_rw_cout;
+    this->m_rw_budget = &budget;
     static constexpr bool has_limit = true;
 
     // type::check_structured(t);
@@ -458,6 +566,11 @@ namespace hrw {
         }
         // std:: cout << "   matches: " << std::boolalpha << matched << std::endl;
         if(matched) {
+          if constexpr(has_limit) {
+            if(this->m_rw_count >= this->m_rw_budget->load(std::memory_order_relaxed)) {
+              throw hrw::exception::rw_limit();
+            }
+          }
           // std::cout << "   => match: substitution = " << ctx_print.print(this->m_substitution) << std::endl;
           t_term_full_ref t_new = this->m_ctx_term.instantiate(std::get<1>(rule), this->m_substitution);
           ++this->m_rw_count;
@@ -504,7 +617,7 @@ namespace hrw {
 
       while(true) {
         // std::cout << "  rewriting term: " << this->ctx_print.print(t) << std::endl;
-        auto it = this->m_applications.find(t);
+        auto it = this->find_nf(t);
         if(it == this->m_applications.end()) {
           // 1. rewrite subterms
           t_rewrite_inner obj(*this, t);
@@ -520,16 +633,16 @@ namespace hrw {
           } else { // we have a irreductible term => register
             // std::cout << "    => irreductible! " << std::endl;
             for(t_term_full_ref prev: previous_versions) {
-              this->m_applications.insert(std::make_pair(prev, t));
+              this->add_nf(prev, t);
             }
-            this->m_applications.insert(std::make_pair(t, t));
+            this->add_nf(t, t);
             return t;
           }
         } else { // we found the image of t -> need to associate the prevs to this image
-          t_term_full_ref irr = it->second;
+          t_term_full_ref irr = type::get_nf(it, t);
           // std::cout << "    already rewritten: " << ctx_print.print(irr) << std::endl;
           for(t_term_full_ref prev: previous_versions) {
-            this->m_applications.insert(std::make_pair(prev, irr));
+            this->add_nf(prev, irr);
           }
           return irr;
         }
@@ -0,0 +1,76 @@
+/*
+ * This file is part of the hrewrite library.
+ * Copyright (c) 2021 ONERA.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+ // Author: Michael Lienhardt
+ // Maintainer: Michael Lienhardt
+ // email: michael.lienhardt@onera.fr
+
+
+
+#ifndef __HREWRITE_C_RW_ASYNC_H__
+#define __HREWRITE_C_RW_ASYNC_H__
+
+#include <atomic>
+#include <future>
+#include <limits>
+#include <memory>
+#include <mutex>
+
+#include "hrewrite/utils/thread_pool.hpp"
+#include "hrewrite/context_rw.hpp"
+
+namespace hrw {
+
+  // a rewriting executed by a thread pool. Its step budget is shared with the rewriting,
+  // so that cancel() stops it at its next rule application, the future then holding rw_limit
+  template<typename t_term_full_ref>
+  class rewrite_job {
+  public:
+    using type = rewrite_job<t_term_full_ref>;
+    using t_budget = std::shared_ptr<std::atomic<unsigned int>>;
+
+    rewrite_job(std::future<t_term_full_ref>&& result, t_budget budget): m_result(std::move(result)), m_budget(std::move(budget)) {}
+
+    void cancel() { this->m_budget->store(0, std::memory_order_relaxed); }
+    std::future<t_term_full_ref>& future() { return this->m_result; }
+    t_term_full_ref get() { return this->m_result.get(); }
+
+  private:
+    std::future<t_term_full_ref> m_result;
+    t_budget m_budget;
+  };
+
+
+  // a context_rw and its term context are not thread-safe: the job rewrites t while holding mutex,
+  // which must be shared by all the users of the term context. Jobs on different term contexts run in parallel
+  template<e_strategy stg=e_strategy::STY_INNER, typename t_ctx_rw, typename t_mutex>
+  rewrite_job<typename t_ctx_rw::t_term_full_ref> rewrite_async(
+      hrw::utils::thread_pool& pool, t_ctx_rw& rw, t_mutex& mutex, typename t_ctx_rw::t_term_full_ref t,
+      unsigned int nb_steps=std::numeric_limits<unsigned int>::max()) {
+    using t_term_full_ref = typename t_ctx_rw::t_term_full_ref;
+    auto budget = std::make_shared<std::atomic<unsigned int>>(nb_steps);
+    std::future<t_term_full_ref> res = pool.submit([&rw, &mutex, t, budget]() {
+      std::lock_guard<t_mutex> lock(mutex);
+      return rw.template rewrite<stg>(t, *budget);
+    });
+    return rewrite_job<t_term_full_ref>(std::move(res), std::move(budget));
+  }
+
+}
+
+
+#endif // __HREWRITE_C_RW_ASYNC_H__
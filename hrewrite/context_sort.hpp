@@ -23,10 +23,13 @@
 #ifndef __HREWRITE_C_SORT_H__
 #define __HREWRITE_C_SORT_H__
 
-// #include <unordered_map> // TODO: remove hard dependency
+#include <unordered_map>
 #include <string>
+#include <string_view>
 #include <vector>
+#include <deque>
 #include <algorithm>
+#include <cstdint>
 
 #include "hrewrite/utils.hpp"
 #include "hrewrite/theory/core.hpp"
@@ -34,13 +37,15 @@
 
 namespace hrw {
 
-  // NOTE: this implementation supposes that there isn't a lot of sorts, which is true in 100% of the tested cases
+  // NOTE: sorts are stored in a deque so that their names can be indexed by std::string_view
+  // NOTE: with targ_dense, the subsort relation is also stored in a (number of sorts)^2 bit-matrix, rebuilt on the first test after a change.
 
-  template<typename targ_natset>
+  template<typename targ_natset, bool targ_dense=false>
   class context_sort {
   public:
-    using type = context_sort<targ_natset>;
+    using type = context_sort<targ_natset, targ_dense>;
     using natset = targ_natset;
+    static inline constexpr bool dense_v = targ_dense;
 
     //////////////////////////////////////////
     // 1. adding sorts
@@ -49,6 +54,8 @@ namespace hrw {
       if(it == this->end()) {
         t_sort_id res = this->m_sorts.size();
         this->m_sorts.emplace_back(container_sort(name));
+        this->m_sort_names.emplace(this->m_sorts.back().m_name, res);
+        this->m_matrix.m_valid = false;
         return res;
       } else {
         return (it - this->begin());
@@ -60,7 +67,8 @@ namespace hrw {
       if(it == this->end()) {
         t_sort_id res = this->m_sorts.size();
         this->m_sorts.emplace_back(container_sort(std::move(name)));
-        // this->m_sort_names[name] = res;
+        this->m_sort_names.emplace(this->m_sorts.back().m_name, res);
+        this->m_matrix.m_valid = false;
         return res;
       } else {
         return (it - this->begin());
@@ -88,11 +96,12 @@ namespace hrw {
             this->m_sorts[ssubsort].m_supsorts.insert(supsort);
             this->m_sorts[ssubsort].m_supsorts.insert(sup_data.m_supsorts);
           }
+          this->m_matrix.m_valid = false;
         }
       }
     }
 
-    void add_subsort(const std::string& subsort, const std::string& supsort) {
+    void add_subsort(std::string_view subsort, std::string_view supsort) {
       this->add_subsort(this->get_letter(subsort), this->get_letter(supsort));
     }
 
@@ -102,26 +111,44 @@ namespace hrw {
     natset const& get_subsorts(const t_sort_id sort)  const { return this->m_sorts[sort].m_subsorts; }
     natset const& get_supsorts(const t_sort_id sort)  const { return this->m_sorts[sort].m_supsorts; }
 
-    natset const& get_subsorts(const std::string& sort)  const {
+    natset const& get_subsorts(std::string_view sort)  const {
       auto it = this->ensure(sort);
       return it->m_subsorts;
     }
-    natset const& get_supsorts(const std::string& sort)  const {
+    natset const& get_supsorts(std::string_view sort)  const {
       auto it = this->ensure(sort);
       return it->m_supsorts;
     }
 
     //////////////////////////////////////////
     // 4. testing
-    bool contains(const std::string& sort) { return (this->find(sort) != this->end()); }
-    bool contains(const t_sort_id sort) { return (sort < this->m_sorts.size()); }
+    bool contains(std::string_view sort) const { return (this->find(sort) != this->end()); }
+    bool contains(const t_sort_id sort) const { return (sort < this->m_sorts.size()); }
 
-    bool is_subsort(const t_sort_id s1, const t_sort_id s2) const { return (s1 == s2) || (this->m_sorts[s2].m_subsorts.contains(s1)); }
-    bool is_subsort(const std::string& s1, const std::string& s2) const {
+    bool is_subsort(const t_sort_id s1, const t_sort_id s2) const {
+      if constexpr(dense_v) {
+        this->freeze();
+        return this->m_matrix.get(s1, s2);
+      } else {
+        return (s1 == s2) || (this->m_sorts[s2].m_subsorts.contains(s1));
+      }
+    }
+    bool is_subsort(std::string_view s1, std::string_view s2) const {
       return this->is_subsort(this->get_letter(s1), this->get_letter(s2));
     }
 
-    void clear() { this->m_sorts.clear(); }
+    void clear() {
+      this->m_sorts.clear();
+      this->m_sort_names.clear();
+      this->m_matrix.m_valid = false;
+    }
+
+    // computes the bit-matrix now, e.g., before using this context in a read-only manner
+    void freeze() const {
+      if constexpr(dense_v) {
+        if(!this->m_matrix.m_valid) { this->m_matrix.rebuild(this->m_sorts); }
+      }
+    }
 
 
     //////////////////////////////////////////
@@ -129,7 +156,7 @@ namespace hrw {
     using t_letter = t_sort_id;
     using t_letter_set = natset;
 
-    t_sort_id get_letter(const std::string& sort_name) const {
+    t_sort_id get_letter(std::string_view sort_name) const {
       auto it = this->ensure(sort_name);
       return (it - this->begin());
     }
@@ -146,18 +173,53 @@ namespace hrw {
       natset m_subsorts;
       natset m_supsorts;
     };
-    std::vector<container_sort> m_sorts;
-    using const_iterator = typename std::vector<container_sort>::const_iterator;
+    using t_sorts = std::deque<container_sort>;
+    using const_iterator = typename t_sorts::const_iterator;
+    t_sorts m_sorts;
+    std::unordered_map<std::string_view, t_sort_id> m_sort_names; // views on the names stored in m_sorts
+
+    // row s2 contains the bit s1 iff s1 is a subsort of s2 (the relation is stored reflexive)
+    struct container_matrix {
+      using t_word = std::uint64_t;
+      static constexpr std::size_t word_size = 64;
+
+      bool get(const t_sort_id s1, const t_sort_id s2) const {
+        return (this->m_content[(s2 * this->m_stride) + (s1 / word_size)] >> (s1 % word_size)) & 1;
+      }
+
+      void rebuild(const t_sorts& sorts) {
+        this->m_stride = (sorts.size() + word_size - 1) / word_size;
+        this->m_content.assign(this->m_stride * sorts.size(), 0);
+        for(t_sort_id s2 = 0; s2 < sorts.size(); ++s2) {
+          t_word* row = this->m_content.data() + (s2 * this->m_stride);
+          row[s2 / word_size] |= (t_word(1) << (s2 % word_size));
+          for(t_sort_id s1: sorts[s2].m_subsorts) {
+            row[s1 / word_size] |= (t_word(1) << (s1 % word_size));
+          }
+        }
+        this->m_valid = true;
+      }
+
+      std::vector<t_word> m_content;
+      std::size_t m_stride = 0;
+      bool m_valid = false;
+    };
+    mutable container_matrix m_matrix;
 
     const_iterator begin() const { return this->m_sorts.begin(); }
     const_iterator end() const { return this->m_sorts.end(); }
-    const_iterator find(const std::string& name) const {
-      return std::find_if(this->begin(), this->end(), [&name](auto& c) { return c.m_name == name; });
+    const_iterator find(std::string_view name) const {
+      auto it = this->m_sort_names.find(name);
+      if(it == this->m_sort_names.end()) {
+        return this->end();
+      } else {
+        return this->begin() + it->second;
+      }
     }
-    const_iterator ensure(const std::string& name) const {
+    const_iterator ensure(std::string_view name) const {
       auto it = this->find(name);
         if(it == this->end()) {
-        throw hrw::exception::ndeclared_sort(name); 
+        throw hrw::exception::ndeclared_sort(std::string(name)); 
       } else {
         return it;
       }
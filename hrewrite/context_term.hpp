@@ -23,6 +23,11 @@
 #ifndef __HREWRITE_C_TERM_H__
 #define __HREWRITE_C_TERM_H__
 
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
 #include "hrewrite/utils.hpp"
 #include "hrewrite/theory/core.hpp"
 #include "hrewrite/exceptions/parsing.hpp"
@@ -92,9 +97,9 @@ namespace hrw {
       t_sort_id s = ctx_theory::get_sort(c);
 
       if constexpr(has_spec_v<th>) { // the theory has a spec
-        return this->m_registry.add(std::get<tl_factory>(this->m_sfactories).template create_term<typename ctx_theory::t_spec_sequence>(ctx_theory::get_spec(c), s, c.id(), args ...));
+        return this->m_registry.add(std::get<tl_factory>(this->m_sfactories).template create_term<typename ctx_theory::t_spec_sequence>(ctx_theory::get_spec(c), s, c.id(), std::move(args) ...));
       } else {
-        return this->m_registry.add(std::get<tl_factory>(this->m_sfactories).create_term(s, c.id(), args ...));
+        return this->m_registry.add(std::get<tl_factory>(this->m_sfactories).create_term(s, c.id(), std::move(args) ...));
       }
     }
 
@@ -103,7 +108,7 @@ namespace hrw {
       static_assert(ctx_theory::template is_registered_stheory_v<th>);
       using tl_factory = th_factory<th>;
       t_sort_id s = ctx_theory::get_sort(c);
-      return this->m_registry.add(std::get<tl_factory>(this->m_sfactories).create_term(s, c.id(), args ...));
+      return this->m_registry.add(std::get<tl_factory>(this->m_sfactories).create_term(s, c.id(), std::move(args) ...));
     }
 
 
@@ -115,6 +120,17 @@ namespace hrw {
       return this->m_registry.add(std::move(std::get<tl_factory>(this->m_sfactories).create_term_from_diff(t, std::move(c))));
     }
 
+    // t is the content of ref: when c contains the same subterms as t, ref is returned without building a new term
+    template<typename t_term>
+    t_term_full_ref create_sterm_from_diff(t_term_full_ref ref, const t_term& t, typename t_term::t_container&& c) {
+      if constexpr(ensure_unique_v) {
+        if(std::equal(c.begin(), c.end(), t.begin(), t.end())) {
+          return ref;
+        }
+      }
+      return this->template create_sterm_from_diff<t_term>(t, std::move(c));
+    }
+
 
     //////////////////////////////////////////
     // useful wrapper on ctx_theory
@@ -192,7 +208,11 @@ namespace hrw {
     // useful methods
 
     bool contains(const t_term_full_ref t) const { return this->m_registry.contains(*t); }
-    void clear() { this->m_registry.clear(); }
+    void clear() {
+      this->m_registry.clear();
+      this->m_roots.clear();
+      this->m_collect_last = 0;
+    }
 
 
     using term_make_ref = typename t_registry::template make_ref<t_term_full, t_term_hash, t_term_eq>;
@@ -201,6 +221,78 @@ namespace hrw {
     using term_registry = typename t_registry::template make<t_term_full, t_term_hash, t_term_eq>;
     static_assert(std::is_same_v<t_term_full_ref, typename term_registry::t_ptr>);
 
+  public:
+    //////////////////////////////////////////
+    // garbage collection
+
+    // mark and sweep: the terms that are not reachable from a root are removed from the registry.
+    // The roots are the terms registered with add_root, and the ones given by the for_each_root method of the extra contexts (e.g., context_rw).
+    // Any other reference to a term of this context is invalid after a collection.
+    static inline constexpr bool collectable_v = hrw::utils::is_registry_collectable_v<term_registry>;
+
+    void add_root(t_term_full_ref t) { ++this->m_roots[term_make_ref::to_ptr(t)]; }
+    void remove_root(t_term_full_ref t) {
+      auto it = this->m_roots.find(term_make_ref::to_ptr(t));
+      if((it != this->m_roots.end()) && ((--(it->second)) == 0)) {
+        this->m_roots.erase(it);
+      }
+    }
+
+    template<typename ... Ts>
+    std::size_t collect(const Ts& ... ctxs) {
+      static_assert(collectable_v, "the term registry does not support garbage collection");
+      std::unordered_set<const t_term_full*> marked;
+      std::vector<const t_term_full*> stack;
+      auto mark = [&marked, &stack](t_term_full_ref t) {
+        const t_term_full* ptr = term_make_ref::to_ptr(t);
+        if(marked.insert(ptr).second) {
+          stack.push_back(ptr);
+        }
+      };
+      for(const auto& root: this->m_roots) {
+        if(marked.insert(root.first).second) {
+          stack.push_back(root.first);
+        }
+      }
+      (ctxs.for_each_root(mark), ...);
+      while(!stack.empty()) {
+        const t_term_full* t = stack.back();
+        stack.pop_back();
+        t->for_each_subterm(mark);
+      }
+      std::size_t res = this->m_registry.collect([&marked](const t_term_full& t) { return marked.find(&t) != marked.end(); });
+      this->m_collect_last = this->m_registry.size();
+      return res;
+    }
+
+    // collects when the registry grew by more than the threshold since the last collection (0 disables it).
+    // It must be called when all the terms in use are reachable from the roots, e.g., between two rewritings
+    void set_collect_threshold(std::size_t threshold) { this->m_collect_threshold = threshold; }
+
+    template<typename ... Ts>
+    std::size_t collect_if_needed(const Ts& ... ctxs) {
+      if((this->m_collect_threshold != 0) && (this->m_registry.size() >= this->m_collect_last + this->m_collect_threshold)) {
+        return this->collect(ctxs ...);
+      }
+      return 0;
+    }
+
+    std::size_t size() const { return this->m_registry.size(); }
+
+
+    //////////////////////////////////////////
+    // release callbacks, with reference counting
+
+    // f is called on each term just before it is released from the registry
+    template<typename F>
+    std::size_t add_release_callback(F&& f) { return this->m_registry.add_release_callback(std::forward<F>(f)); }
+    void remove_release_callback(std::size_t id) { this->m_registry.remove_release_callback(id); }
+
+  private:
+    std::unordered_map<const t_term_full*, unsigned int> m_roots;
+    std::size_t m_collect_threshold = 0;
+    std::size_t m_collect_last = 0;
+
     //////////////////////////////////////////
     // term registry
     term_registry m_registry;
@@ -120,6 +120,17 @@ namespace hrw {
       static_assert(is_registered_stheory_v<th>);
       return std::get<th_ctx_constructor<th>>(m_ctx_constructor).contains(c.id());
     }
+    template<typename th>
+    static bool contains_constructor(std::string_view name) {
+      static_assert(is_registered_stheory_v<th>);
+      return std::get<th_ctx_constructor<th>>(m_ctx_constructor).contains(name);
+    }
+
+    template<typename th>
+    static t_constructor_core<th> get_constructor(std::string_view name) {
+      static_assert(is_registered_stheory_v<th>);
+      return t_constructor_core<th>(std::get<th_ctx_constructor<th>>(m_ctx_constructor).get_id(name));
+    }
 
     template<typename th>
     static t_sort_id get_sort(const t_constructor_core<th> c) {
@@ -154,6 +165,9 @@ namespace hrw {
       std::apply([](auto& ... ctx_constructor) {
         (ctx_constructor.clear(), ...);
       }, m_ctx_constructor);
+      // the interned specs refer to the letters of m_ctx_sort
+      hrw::utils::spec_intern_tuple<t_specs>::clear();
+      hrw::utils::spec_intern<t_spec_sequence>::clear();
 
     }
 
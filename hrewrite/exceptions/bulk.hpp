@@ -0,0 +1,53 @@
+/*
+ * This file is part of the hrewrite library.
+ * Copyright (c) 2021 ONERA.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+ // Author: Michael Lienhardt
+ // Maintainer: Michael Lienhardt
+ // email: michael.lienhardt@onera.fr
+
+
+#ifndef __HREWRITE_EXCEPTION_BULK_H__
+#define __HREWRITE_EXCEPTION_BULK_H__
+
+#include <exception>
+#include <string>
+
+#include "hrewrite/exceptions/common.hpp"
+
+namespace hrw {
+  namespace exception {
+
+    ///////////////////////////////////////////
+    // Malformed bulk description of terms
+    class bulk_format: public abstract_error {
+    public:
+      bulk_format(std::size_t node, std::string const & reason): m_node(node), m_reason(reason) {}
+      std::size_t get_node() const { return this->m_node; }
+    private:
+      std::size_t m_node;
+      std::string m_reason;
+    protected:
+      virtual void ensure_msg() const {
+        if(not this->m_msg.has_value()) {
+          this->m_msg = "ERROR: invalid node " + std::to_string(this->m_node) + " in bulk term construction (" + this->m_reason + ")";
+        }
+      }
+    };
+
+}}
+
+#endif // __HREWRITE_EXCEPTION_BULK_H__
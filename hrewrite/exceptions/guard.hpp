@@ -0,0 +1,51 @@
+/*
+ * This file is part of the hrewrite library.
+ * Copyright (c) 2021 ONERA.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+ // Author: Michael Lienhardt
+ // Maintainer: Michael Lienhardt
+ // email: michael.lienhardt@onera.fr
+
+
+#ifndef __HREWRITE_EXCEPTION_GUARD_H__
+#define __HREWRITE_EXCEPTION_GUARD_H__
+
+#include <exception>
+#include <string>
+
+#include "hrewrite/exceptions/common.hpp"
+
+namespace hrw {
+  namespace exception {
+
+    ///////////////////////////////////////////
+    // Ill-formed native guard
+    class guard_invalid: public abstract_error {
+    public:
+      guard_invalid(std::string const & reason): m_reason(reason) {}
+    private:
+      std::string m_reason;
+    protected:
+      virtual void ensure_msg() const {
+        if(not this->m_msg.has_value()) {
+          this->m_msg = "ERROR: invalid native guard (" + this->m_reason + ")";
+        }
+      }
+    };
+
+}}
+
+#endif // __HREWRITE_EXCEPTION_GUARD_H__
@@ -53,6 +53,17 @@ namespace hrw {
     };
 
 
+    ///////////////////////////////////////////
+    // Step budget error
+    static char const * exception_limit_cstr = "ERROR: the step budget of the rewriting is exhausted";
+    class rw_limit: public std::exception {
+    public:
+      char const * what() const noexcept override {
+        return exception_limit_cstr;
+      }
+    };
+
+
     ///////////////////////////////////////////
     // Rewriting rule error
     template<typename t_term_full_ref>
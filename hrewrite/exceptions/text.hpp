@@ -0,0 +1,55 @@
+/*
+ * This file is part of the hrewrite library.
+ * Copyright (c) 2021 ONERA.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+ // Author: Michael Lienhardt
+ // Maintainer: Michael Lienhardt
+ // email: michael.lienhardt@onera.fr
+
+
+#ifndef __HREWRITE_EXCEPTION_TEXT_H__
+#define __HREWRITE_EXCEPTION_TEXT_H__
+
+#include <exception>
+#include <string>
+
+#include "hrewrite/exceptions/common.hpp"
+
+namespace hrw {
+  namespace exception {
+
+    ///////////////////////////////////////////
+    // Malformed textual description of terms
+    class text_format: public abstract_error {
+    public:
+      text_format(std::size_t line, std::size_t column, std::string const & reason): m_line(line), m_column(column), m_reason(reason) {}
+      std::size_t get_line() const { return this->m_line; }
+      std::size_t get_column() const { return this->m_column; }
+    private:
+      std::size_t m_line;
+      std::size_t m_column;
+      std::string m_reason;
+    protected:
+      virtual void ensure_msg() const {
+        if(not this->m_msg.has_value()) {
+          this->m_msg = "ERROR: " + std::to_string(this->m_line) + ":" + std::to_string(this->m_column) + ": " + this->m_reason;
+        }
+      }
+    };
+
+}}
+
+#endif // __HREWRITE_EXCEPTION_TEXT_H__
@@ -46,6 +46,21 @@ namespace hrw {
       }
     };
 
+    ///////////////////////////////////////////
+    // Constructor
+    class ndeclared_constructor: public abstract_error {
+    public:
+      ndeclared_constructor(std::string const & name): m_name(name) {}
+    private:
+      std::string m_name;
+    protected:
+      virtual void ensure_msg() const {
+        if(not this->m_msg.has_value()) {
+          this->m_msg = "ERROR: the constructor \"" + this->m_name + "\" is not declared";
+        }
+      }
+    };
+
 }}
 
 
@@ -39,6 +39,16 @@ namespace hrw {
       }
     };
 
+    ///////////////////////////////////////////
+    // arena
+    static char const * arena_full_cstr = "ERROR: arena cannot contain more than 2^32-1 elements";
+    class arena_full: public std::exception {
+    public:
+      const char* what() const noexcept override {
+        return arena_full_cstr;
+      }
+    };
+
     ///////////////////////////////////////////
     // iterator
     static char const * iterator_increment_cstr = "ERROR: cannot increment a dummy iterator";
@@ -40,11 +40,16 @@
 
 #include "hrewrite/hterm.hpp"
 #include "hrewrite/hterm_print.hpp"
+#include "hrewrite/hterm_binary.hpp"
+#include "hrewrite/hterm_bulk.hpp"
+#include "hrewrite/hterm_text.hpp"
+#include "hrewrite/hterm_guard.hpp"
 #include "hrewrite/context_sort.hpp"
 #include "hrewrite/context_constructor.hpp"
 #include "hrewrite/context_theory.hpp"
 #include "hrewrite/context_term.hpp"
 #include "hrewrite/context_rw.hpp"
+#include "hrewrite/context_rw_async.hpp"
 
 
 #endif // __HREWRITE_MAIN_H__
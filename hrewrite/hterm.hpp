@@ -61,7 +61,7 @@ namespace hrw {
       using make_ptr_struct = typename T::make_ptr_struct;
       hrw::utils::hash_value operator()(const value_type& t) const {
         // std::cout << "t_term_hash_ref<T, false>" << std::endl;
-        return std::hash<const T*>()(make_ptr_struct::to_ptr(t));
+        return hrw::utils::hash_mixed<const T*>()(make_ptr_struct::to_ptr(t));
       }
     };
 
@@ -163,21 +163,21 @@ namespace hrw {
     ///////////////////////
     // constructors
 
-    tt_term_full(const type& t): m_content(t.m_content), m_uid(0) {
+    tt_term_full(const type& t): m_content(t.m_content), m_hash(t.m_hash) {
       //std::cout << "constructor tt_term_full::copy : " << ((void*)&t) << " => " << ((void*)this) << std::endl;
       // nb_term += 1;
     }
 
-    tt_term_full(type&& t): m_content(std::move(t.m_content)), m_uid(0) {
+    tt_term_full(type&& t): m_content(std::move(t.m_content)), m_hash(t.m_hash) {
       //std::cout << "constructor tt_term_full::move : " << ((void*)&t) << " => " << ((void*)this) << std::endl;
       // nb_term += 1;
     }
 
-    template<typename T, std::enable_if_t<hrw::utils::tuple_contains_v<T, t_tuple_all_term>, bool> = true> tt_term_full(T&& t): m_content(std::move(t)), m_uid(-1) {
+    template<typename T, std::enable_if_t<hrw::utils::tuple_contains_v<T, t_tuple_all_term>, bool> = true> tt_term_full(T&& t): m_content(std::move(t)), m_hash(type::init_hash(this->m_content)) {
       //std::cout << "constructor tt_term_full<" << hrw::utils::type_name<T>() << "&&>" << " => " << ((void*)this) << std::endl;
       // nb_term += 1;
     }
-    template<typename T, std::enable_if_t<hrw::utils::tuple_contains_v<T, t_tuple_all_term>, bool> = true> tt_term_full(const T& t): m_content(t), m_uid(-1) {
+    template<typename T, std::enable_if_t<hrw::utils::tuple_contains_v<T, t_tuple_all_term>, bool> = true> tt_term_full(const T& t): m_content(t), m_hash(type::init_hash(this->m_content)) {
       //std::cout << "constructor tt_term_full<const " << hrw::utils::type_name<T>() << "&>" << " => " << ((void*)this) << std::endl;
       // nb_term += 1;
     }
@@ -198,6 +198,9 @@ namespace hrw {
       return VISIT_SINGLE(obj, this->m_content);
     }
 
+    // the structural hash of the term, equal to t_hash<true>
+    hrw::utils::hash_value get_hash() const { return t_hash<true>()(*this); }
+
     t_sort_id get_sort() const {
       get_sort_helper obj;
       return VISIT_SINGLE(obj, this->m_content);
@@ -241,6 +244,13 @@ namespace hrw {
     static constexpr std::size_t nb_alternative = std::variant_size_v<t_content>;
     std::size_t index() const { return this->m_content.index(); }
 
+    // applies f on the references to the direct subterms of the term
+    template<typename F>
+    void for_each_subterm(F&& f) const {
+      for_each_subterm_helper<F> obj{f};
+      VISIT_SINGLE(obj, this->m_content);
+    }
+
 
     template<typename t_visitor, typename t_result=hrw::utils::visit_get_result_t<t_visitor, t_content>>
     t_result visit(t_visitor&& visitor) {
@@ -306,11 +316,8 @@ namespace hrw {
       static_assert(std::is_same_v<typename value_type::t_content, typename hash_content::value_type>);
       hrw::utils::hash_value operator()(const value_type& t) const {
         // std::cout << "  t_hash<" << std::boolalpha << deep << ">" << std::endl;
-        if constexpr(deep) {
-          if(t.m_uid == 0) {
-            t.m_uid = hash_content()(t.m_content);
-          }
-          return t.m_uid;
+        if constexpr(is_const_v) {
+          return t.m_hash; // equal under the shallow equality implies equal structure
         } else {
           return hash_content()(t.m_content);
         }
@@ -325,6 +332,9 @@ namespace hrw {
       // MAYBE TODO: add a map to store the pairs we already tested, for the deep version
       constexpr bool operator()( const value_type& lhs, const value_type& rhs ) const {
         // std::cout << "  t_eq<" << std::boolalpha << deep << ">" << std::endl;
+        if constexpr(is_const_v) {
+          if(lhs.m_hash != rhs.m_hash) { return false; }
+        }
         return eq_content()(lhs.m_content, rhs.m_content);
       }
     };
@@ -337,7 +347,7 @@ namespace hrw {
 
     type& operator=(type const & t) {
       this->m_content = t.m_content;
-      this->m_uid = t.m_uid;
+      this->m_hash = t.m_hash;
       if constexpr(!is_const_v) {
         this->m_annex_data.status = t.m_annex_data.status;
       }
@@ -352,7 +362,7 @@ namespace hrw {
         throw hrw::exception::generic("ERROR: swap of constant term is not allowed");
       } else {
         t1.m_content.swap(t2.m_content);
-        std::swap(t1.m_uid, t2.m_uid);
+        std::swap(t1.m_hash, t2.m_hash);
         std::swap(t1.m_annex_data.status, t2.m_annex_data.status);
       }
     }
@@ -363,7 +373,15 @@ namespace hrw {
 
 
   private:
-    mutable std::size_t m_uid;
+    std::size_t m_hash; // structural hash, computed from the stored hash of the subterms when the term is constant
+
+    static std::size_t init_hash(const t_content& c) {
+      if constexpr(is_const_v) {
+        return typename t_hash<true>::hash_content()(c);
+      } else {
+        return 0;
+      }
+    }
     t_annex_data m_annex_data;
 
     ///////////////////////////////////////////////////////////////////////////////
@@ -377,6 +395,18 @@ namespace hrw {
       bool operator()(const T& t) { return t.is_ground(); }
     };
 
+    // class for for_each_subterm
+    template<typename F>
+    struct for_each_subterm_helper {
+      F& m_f;
+      template<typename T>
+      void operator()(const T& t) {
+        if constexpr(has_container_v<T>) {
+          for(const reference& s: t) { this->m_f(s); }
+        }
+      }
+    };
+
     // class for get_sort
     struct get_sort_helper {
       t_sort_id operator()(const t_variable& v) {
@@ -0,0 +1,442 @@
+/*
+ * This file is part of the hrewrite library.
+ * Copyright (c) 2021 ONERA.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+ // Author: Michael Lienhardt
+ // Maintainer: Michael Lienhardt
+ // email: michael.lienhardt@onera.fr
+
+
+#ifndef __HREWRITE_HTERM_BINARY_H__
+#define __HREWRITE_HTERM_BINARY_H__
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+
+#include "hrewrite/utils.hpp"
+#include "hrewrite/theory/core.hpp"
+#include "hrewrite/exceptions/binary.hpp"
+
+
+namespace hrw {
+
+
+  /////////////////////////////////////////////////////////////////////////////
+  // FORMAT
+  /////////////////////////////////////////////////////////////////////////////
+
+  // a term DAG is stored as (all integers are native 32-bit words):
+  //   header       : magic, version, number of constructors, number of nodes, number of roots
+  //   constructors : pairs (index of the alternative in t_term_full::t_content, constructor id)
+  //   nodes        : in topological order (subterms first), each being its constructor index followed by
+  //                    - variables  : the length and the characters of its spec
+  //                    - containers : the number of subterms and their node indices
+  //                    - literals   : the value, written by the codec
+  //                    - leaves     : nothing
+  //   roots        : node indices
+
+  namespace term_binary {
+    using t_word = std::uint32_t;
+    static inline constexpr t_word magic   = 0x42575248; // "HRWB"
+    static inline constexpr t_word version = 1;
+
+    class output {
+    public:
+      output(): m_content() {}
+      void write(t_word w) { this->write_raw(&w, sizeof(t_word)); }
+      void write_raw(const void* data, std::size_t size) {
+        const char* p = static_cast<const char*>(data);
+        this->m_content.append(p, size);
+      }
+      void reserve(std::size_t size) { this->m_content.reserve(size); }
+      std::size_t size() const { return this->m_content.size(); }
+      std::string& content() { return this->m_content; }
+    private:
+      std::string m_content;
+    };
+
+    class input {
+    public:
+      input(std::string_view data): m_data(data), m_pos(0) {}
+      t_word read() {
+        t_word res;
+        this->read_raw(&res, sizeof(t_word));
+        return res;
+      }
+      void read_raw(void* data, std::size_t size) {
+        this->ensure(size);
+        std::memcpy(data, this->m_data.data() + this->m_pos, size);
+        this->m_pos += size;
+      }
+      std::string_view read_view(std::size_t size) {
+        this->ensure(size);
+        std::string_view res = this->m_data.substr(this->m_pos, size);
+        this->m_pos += size;
+        return res;
+      }
+      std::size_t remaining() const { return this->m_data.size() - this->m_pos; }
+    private:
+      void ensure(std::size_t size) const {
+        if(size > this->remaining()) { throw hrw::exception::binary_format("truncated data"); }
+      }
+      std::string_view m_data;
+      std::size_t m_pos;
+    };
+
+    // default codec for the literal values: trivially copyable values are copied as is, strings are prefixed by their length
+    struct codec {
+      template<typename T>
+      void write(output& out, const T& v) {
+        if constexpr(std::is_same_v<T, std::string>) {
+          out.write(static_cast<t_word>(v.size()));
+          out.write_raw(v.data(), v.size());
+        } else if constexpr(std::is_same_v<T, hrw::utils::interned_string>) {
+          this->write(out, v.str());
+        } else {
+          static_assert(std::is_trivially_copyable_v<T>, "a codec is required for non trivially copyable literal values");
+          out.write_raw(&v, sizeof(T));
+        }
+      }
+      template<typename T>
+      T read(input& in) {
+        if constexpr(std::is_same_v<T, std::string>) {
+          t_word size = in.read();
+          return std::string(in.read_view(size));
+        } else if constexpr(std::is_same_v<T, hrw::utils::interned_string>) {
+          t_word size = in.read();
+          return hrw::utils::interned_string(in.read_view(size));
+        } else {
+          T res;
+          in.read_raw(&res, sizeof(T));
+          return res;
+        }
+      }
+    };
+  }
+
+
+  /////////////////////////////////////////////////////////////////////////////
+  // WRITER
+  /////////////////////////////////////////////////////////////////////////////
+
+  template<typename t_ctx_term, typename t_codec=term_binary::codec>
+  class term_binary_writer {
+  public:
+    using type = term_binary_writer<t_ctx_term, t_codec>;
+    using t_term_full = typename t_ctx_term::t_term_full;
+    using t_term_full_ref = typename t_ctx_term::t_term_full_ref;
+    using t_variable = typename t_term_full::t_variable;
+    using t_word = term_binary::t_word;
+
+    term_binary_writer(t_codec codec=t_codec()): m_codec(std::move(codec)), m_nodes(), m_constructors(), m_nb_nodes(0), m_indices(), m_constructor_indices(), m_roots() {}
+    term_binary_writer(const type&) = delete;
+
+    // adds t and its subterms not already written, and returns the index of its node
+    t_word add(t_term_full_ref t) {
+      t_word res = this->add_dag(t);
+      this->m_roots.push_back(res);
+      return res;
+    }
+
+    std::string bytes() {
+      term_binary::output out;
+      out.reserve(5 * sizeof(t_word) + this->m_constructors.size() + this->m_nodes.size() + this->m_roots.size() * sizeof(t_word));
+      out.write(term_binary::magic);
+      out.write(term_binary::version);
+      out.write(static_cast<t_word>(this->m_constructors.size() / (2 * sizeof(t_word))));
+      out.write(this->m_nb_nodes);
+      out.write(static_cast<t_word>(this->m_roots.size()));
+      out.write_raw(this->m_constructors.content().data(), this->m_constructors.size());
+      out.write_raw(this->m_nodes.content().data(), this->m_nodes.size());
+      for(t_word r: this->m_roots) { out.write(r); }
+      return std::move(out.content());
+    }
+
+    t_codec& codec() { return this->m_codec; }
+
+  private:
+    t_codec m_codec;
+    term_binary::output m_nodes;
+    term_binary::output m_constructors;
+    t_word m_nb_nodes;
+    hrw::utils::flat_hash_map<const t_term_full*, t_word, hrw::utils::hash_mixed<const t_term_full*>> m_indices;
+    hrw::utils::flat_hash_map<std::uint64_t, t_word, hrw::utils::hash_mixed<std::uint64_t>> m_constructor_indices;
+    std::vector<t_word> m_roots;
+
+    static const t_term_full* to_ptr(const t_term_full_ref& t) { return t_term_full::make_ptr_struct::to_ptr(t); }
+
+    // iterative depth-first traversal, so that deep terms do not overflow the stack.
+    // As the terms form a DAG, a term reached again is already written: each edge costs one lookup, and each node one insertion
+    struct t_frame {
+      const t_term_full* m_term;
+      std::size_t m_begin;   // the subterms of m_term are m_children[m_begin, m_end)
+      std::size_t m_next;
+      std::size_t m_end;
+      std::size_t m_indices; // the indices of the subterms already written start at m_child_indices[m_indices]
+    };
+
+    t_word add_dag(t_term_full_ref root) {
+      std::vector<t_frame> stack;
+      std::vector<const t_term_full*> children;
+      std::vector<t_word> child_indices;
+      auto enter = [&](const t_term_full* t) {
+        auto it = this->m_indices.find(t);
+        if(it != this->m_indices.end()) {
+          child_indices.push_back(it->second);
+        } else {
+          std::size_t begin = children.size();
+          t->for_each_subterm([&children](const t_term_full_ref& s) { children.push_back(type::to_ptr(s)); });
+          stack.push_back(t_frame{t, begin, begin, children.size(), child_indices.size()});
+        }
+      };
+
+      enter(type::to_ptr(root));
+      while(!stack.empty()) {
+        t_frame& frame = stack.back();
+        if(frame.m_next != frame.m_end) {
+          enter(children[frame.m_next++]);
+        } else {
+          t_frame f = frame;
+          stack.pop_back();
+          t_word idx = this->write_node(*f.m_term, child_indices.data() + f.m_indices);
+          children.resize(f.m_begin);
+          child_indices.resize(f.m_indices);
+          child_indices.push_back(idx);
+        }
+      }
+      return child_indices.back();
+    }
+
+    t_word get_constructor_index(std::size_t alternative, t_constructor_id c) {
+      std::uint64_t key = (static_cast<std::uint64_t>(alternative) << 32) | static_cast<std::uint64_t>(c);
+      auto it = this->m_constructor_indices.find(key);
+      if(it == this->m_constructor_indices.end()) {
+        t_word res = static_cast<t_word>(this->m_constructor_indices.size());
+        this->m_constructor_indices.emplace(key, res);
+        this->m_constructors.write(static_cast<t_word>(alternative));
+        this->m_constructors.write(static_cast<t_word>(c));
+        return res;
+      } else {
+        return it->second;
+      }
+    }
+
+    t_word write_node(const t_term_full& t, const t_word* child_indices) {
+      write_helper obj{*this, t.index(), child_indices};
+      VISIT_SINGLE(obj, t.m_content);
+      t_word res = this->m_nb_nodes++;
+      this->m_indices.emplace(&t, res);
+      return res;
+    }
+
+    struct write_helper {
+      type& m_writer;
+      std::size_t m_alternative;
+      const t_word* m_child_indices;
+
+      template<typename T>
+      void operator()(const T& t) {
+        term_binary::output& out = this->m_writer.m_nodes;
+        if constexpr(std::is_same_v<T, t_variable>) {
+          const std::string& spec = t.get_spec().get_regexp();
+          out.write(this->m_writer.get_constructor_index(this->m_alternative, 0));
+          out.write(static_cast<t_word>(spec.size()));
+          out.write_raw(spec.data(), spec.size());
+        } else {
+          out.write(this->m_writer.get_constructor_index(this->m_alternative, t.get_constructor()));
+          if constexpr(has_container_v<T>) {
+            std::size_t size = t.get_subterms().size();
+            out.write(static_cast<t_word>(size));
+            out.write_raw(this->m_child_indices, size * sizeof(t_word));
+          } else if constexpr(has_value_v<T>) {
+            this->m_writer.m_codec.write(out, t.get_value());
+          }
+        }
+      }
+    };
+  };
+
+
+  /////////////////////////////////////////////////////////////////////////////
+  // READER
+  /////////////////////////////////////////////////////////////////////////////
+
+  // when check is false, the terms are created without validating their subterms against the constructor spec
+  template<typename t_ctx_term, typename t_codec=term_binary::codec>
+  class term_binary_reader {
+  public:
+    using type = term_binary_reader<t_ctx_term, t_codec>;
+    using ctx_theory = typename t_ctx_term::ctx_theory;
+    using t_term_full = typename t_ctx_term::t_term_full;
+    using t_term_full_ref = typename t_ctx_term::t_term_full_ref;
+    using t_word = term_binary::t_word;
+
+    term_binary_reader(t_ctx_term& ctx, std::string_view data, bool check=true, t_codec codec=t_codec()):
+        m_ctx(ctx), m_in(data), m_check(check), m_codec(std::move(codec)), m_constructors(), m_nodes(), m_roots() {
+      this->read_all();
+    }
+    term_binary_reader(const type&) = delete;
+
+    const std::vector<t_term_full_ref>& roots() const { return this->m_roots; }
+
+  private:
+    using t_read_fun = t_term_full_ref (type::*)(t_constructor_id);
+    static inline constexpr std::size_t nb_alternative = t_term_full::nb_alternative;
+
+    t_ctx_term& m_ctx;
+    term_binary::input m_in;
+    bool m_check;
+    t_codec m_codec;
+    std::vector<std::pair<t_read_fun, t_constructor_id>> m_constructors;
+    std::vector<t_term_full_ref> m_nodes;
+    std::vector<t_term_full_ref> m_roots;
+
+    void read_all() {
+      if((this->m_in.read() != term_binary::magic) || (this->m_in.read() != term_binary::version)) {
+        throw hrw::exception::binary_format("wrong header");
+      }
+      t_word nb_constructors = this->m_in.read();
+      t_word nb_nodes = this->m_in.read();
+      t_word nb_roots = this->m_in.read();
+      if(nb_nodes > (this->m_in.remaining() / sizeof(t_word))) {
+        throw hrw::exception::binary_format("truncated data");
+      }
+
+      this->m_constructors.reserve(nb_constructors);
+      for(t_word i = 0; i < nb_constructors; ++i) {
+        t_word alternative = this->m_in.read();
+        t_constructor_id c = this->m_in.read();
+        this->m_constructors.emplace_back(type::get_read_fun(alternative, c), c);
+      }
+
+      this->m_nodes.reserve(nb_nodes);
+      for(t_word i = 0; i < nb_nodes; ++i) {
+        t_word idx = this->m_in.read();
+        if(idx >= this->m_constructors.size()) {
+          throw hrw::exception::binary_format("wrong constructor index");
+        }
+        auto [fun, c] = this->m_constructors[idx];
+        this->m_nodes.push_back((this->*fun)(c));
+      }
+
+      this->m_roots.reserve(nb_roots);
+      for(t_word i = 0; i < nb_roots; ++i) {
+        this->m_roots.push_back(this->get_node(this->m_in.read()));
+      }
+      if(this->m_in.remaining() != 0) {
+        throw hrw::exception::binary_format("trailing data");
+      }
+    }
+
+    t_term_full_ref get_node(t_word idx) const {
+      if(idx >= this->m_nodes.size()) {
+        throw hrw::exception::binary_format("wrong node index");
+      }
+      return this->m_nodes[idx];
+    }
+
+    static t_read_fun get_read_fun(t_word alternative, t_constructor_id c) {
+      if(alternative >= nb_alternative) {
+        throw hrw::exception::binary_format("wrong theory index");
+      }
+      return type::get_read_fun_impl(alternative, c, std::make_index_sequence<nb_alternative>());
+    }
+    template<std::size_t ... Is>
+    static t_read_fun get_read_fun_impl(t_word alternative, t_constructor_id c, std::index_sequence<Is...>) {
+      t_read_fun res = nullptr;
+      ((res = ((Is == alternative) ? type::template get_read_fun_single<Is>(c) : res)), ...);
+      return res;
+    }
+    template<std::size_t I>
+    static t_read_fun get_read_fun_single(t_constructor_id c) {
+      using t_term = std::variant_alternative_t<I, typename t_term_full::t_content>;
+      if constexpr(std::is_same_v<t_term, typename t_term_full::t_variable>) {
+        return &type::read_variable;
+      } else {
+        using th = typename t_term::t_theory;
+        if(!ctx_theory::contains_constructor(t_constructor_core<th>(c))) {
+          throw hrw::exception::binary_format("undeclared constructor");
+        }
+        return &type::template read_sterm<t_term>;
+      }
+    }
+
+    t_term_full_ref read_variable(t_constructor_id) {
+      t_word size = this->m_in.read();
+      return this->m_ctx.create_vterm(std::string(this->m_in.read_view(size)));
+    }
+
+    template<typename t_term>
+    t_term_full_ref read_sterm(t_constructor_id c_id) {
+      using th = typename t_term::t_theory;
+      t_constructor_core<th> c(c_id);
+      if constexpr(has_container_v<t_term>) {
+        t_word size = this->m_in.read();
+        if(size > (this->m_in.remaining() / sizeof(t_word))) {
+          throw hrw::exception::binary_format("truncated data");
+        }
+        get_container_t<t_term> subterms;
+        for(t_word i = 0; i < size; ++i) {
+          subterms.push_back(this->get_node(this->m_in.read()));
+        }
+        return this->create(c, std::move(subterms));
+      } else if constexpr(has_value_v<t_term>) {
+        return this->create(c, this->m_codec.template read<get_value_t<t_term>>(this->m_in));
+      } else {
+        return this->create(c);
+      }
+    }
+
+    template<typename th, typename ... Args>
+    t_term_full_ref create(const t_constructor_core<th> c, Args&& ... args) {
+      if(this->m_check) {
+        return this->m_ctx.create_sterm(c, std::forward<Args>(args)...);
+      } else {
+        return this->m_ctx.create_sterm_no_check(c, std::forward<Args>(args)...);
+      }
+    }
+  };
+
+
+  /////////////////////////////////////////////////////////////////////////////
+  // SHORTCUTS
+  /////////////////////////////////////////////////////////////////////////////
+
+  template<typename t_ctx_term>
+  std::string term_to_bytes(typename t_ctx_term::t_term_full_ref t) {
+    term_binary_writer<t_ctx_term> writer;
+    writer.add(t);
+    return writer.bytes();
+  }
+
+  template<typename t_ctx_term>
+  typename t_ctx_term::t_term_full_ref term_from_bytes(t_ctx_term& ctx, std::string_view data, bool check=true) {
+    term_binary_reader<t_ctx_term> reader(ctx, data, check);
+    if(reader.roots().size() != 1) {
+      throw hrw::exception::binary_format("expected a single root");
+    }
+    return reader.roots().front();
+  }
+
+}
+
+
+#endif // __HREWRITE_HTERM_BINARY_H__
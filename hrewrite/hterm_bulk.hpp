@@ -0,0 +1,418 @@
+/*
+ * This file is part of the hrewrite library.
+ * Copyright (c) 2021 ONERA.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+ // Author: Michael Lienhardt
+ // Maintainer: Michael Lienhardt
+ // email: michael.lienhardt@onera.fr
+
+
+#ifndef __HREWRITE_HTERM_BULK_H__
+#define __HREWRITE_HTERM_BULK_H__
+
+#include <string>
+#include <vector>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+
+#include "hrewrite/utils.hpp"
+#include "hrewrite/parsing.hpp"
+#include "hrewrite/theory/core.hpp"
+#include "hrewrite/exceptions/bulk.hpp"
+#include "hrewrite/exceptions/theory_free.hpp"
+
+
+namespace hrw {
+
+
+  /////////////////////////////////////////////////////////////////////////////
+  // DESCRIPTION
+  /////////////////////////////////////////////////////////////////////////////
+
+  // a DAG of terms in compressed sparse row form: node i has the constructor (theories[i], constructors[i])
+  // and the subterms children[offsets[i]], ..., children[offsets[i+1]-1], which are nodes preceding i.
+  // A node whose theory is `external` is the term externals[constructors[i]] given with the description
+  struct term_bulk {
+    using t_index = std::uint32_t;
+    static inline constexpr t_index external = std::numeric_limits<t_index>::max();
+
+    std::size_t nb_nodes;
+    std::size_t nb_children;
+    const t_index* theories;
+    const t_index* constructors;
+    const t_index* offsets;
+    const t_index* children;
+  };
+
+  // source of the literal values: get<T>(k) returns the value of the k-th literal node
+  struct term_bulk_no_values {
+    template<typename T> T get(std::size_t) {
+      throw hrw::exception::generic("ERROR: no value given for the literals of a bulk term construction");
+    }
+  };
+
+
+  /////////////////////////////////////////////////////////////////////////////
+  // BUILDER
+  /////////////////////////////////////////////////////////////////////////////
+
+  // the whole description is validated, and type-checked when check is true, before any term is created.
+  // The type-checking of a constructor is cached for each sequence of subterm sorts
+  template<typename t_ctx_term>
+  class term_bulk_builder {
+  public:
+    using type = term_bulk_builder<t_ctx_term>;
+    using ctx_theory = typename t_ctx_term::ctx_theory;
+    using t_term_full = typename t_ctx_term::t_term_full;
+    using t_term_full_ref = typename t_ctx_term::t_term_full_ref;
+    using t_index = term_bulk::t_index;
+
+    static inline constexpr std::size_t nb_theories = std::tuple_size_v<typename ctx_theory::theories_structured>;
+
+    // shape of the nodes of a theory, used to translate nested structures into a term_bulk
+    static bool has_subterms(std::size_t theory) { return (theory < nb_theories) && type::shapes()[theory].first; }
+    static bool has_value(std::size_t theory) { return (theory < nb_theories) && type::shapes()[theory].second; }
+
+    term_bulk_builder(t_ctx_term& ctx): m_ctx(ctx), m_codes(), m_variable_specs(), m_variable_codes(), m_checked(), m_key(), m_nodes(), m_nb_values(0) {}
+    term_bulk_builder(const type&) = delete;
+
+    // returns the terms of all the nodes of desc
+    template<typename t_values=term_bulk_no_values>
+    std::vector<t_term_full_ref> build(const term_bulk& desc, const std::vector<t_term_full_ref>& externals, t_values&& values=t_values(), bool check=true) {
+      this->validate(desc, externals, check);
+      using t_values_core = std::remove_reference_t<t_values>;
+      static const auto creators = type::make_table<t_create_fun<t_values_core>>(
+        [](auto th) { return &type::template create_sterm<typename decltype(th)::type, t_values_core>; });
+
+      this->m_nodes.clear();
+      this->m_nodes.reserve(desc.nb_nodes);
+      this->m_nb_values = 0;
+      for(std::size_t i = 0; i < desc.nb_nodes; ++i) {
+        t_index th = desc.theories[i];
+        if(th == term_bulk::external) {
+          this->m_nodes.push_back(externals[desc.constructors[i]]);
+        } else {
+          this->m_nodes.push_back((this->*(creators[th]))(values, desc, i));
+        }
+      }
+      return std::move(this->m_nodes);
+    }
+
+  private:
+    template<typename T> struct t_tag { using type = T; };
+    template<std::size_t I> using theory_t = typename ctx_theory::template theory_element_t<I>;
+    template<typename th> using term_t = typename th::template tt_term<t_term_full>;
+
+    using t_validate_fun = void (type::*)(const term_bulk&, std::size_t, bool);
+    template<typename t_values> using t_create_fun = t_term_full_ref (type::*)(t_values&, const term_bulk&, std::size_t);
+
+    template<typename t_fun, typename F, std::size_t ... Is>
+    static std::array<t_fun, nb_theories> make_table_impl(F&& f, std::index_sequence<Is...>) {
+      return {{ f(t_tag<theory_t<Is>>())... }};
+    }
+    template<typename t_fun, typename F>
+    static std::array<t_fun, nb_theories> make_table(F&& f) {
+      return type::make_table_impl<t_fun>(std::forward<F>(f), std::make_index_sequence<nb_theories>());
+    }
+
+    static const std::array<std::pair<bool, bool>, nb_theories>& shapes() {
+      static const auto res = type::make_table<std::pair<bool, bool>>([](auto th) {
+        using t_term = term_t<typename decltype(th)::type>;
+        return std::make_pair(has_container_v<t_term>, has_value_v<t_term>);
+      });
+      return res;
+    }
+
+    //////////////////////////////////////////
+    // validation
+
+    // the code of a node is its sort, or the interned spec of a variable with its highest bit set
+    static inline constexpr t_index variable_code = t_index(1) << 31;
+
+    struct t_key_hash {
+      std::size_t operator()(const std::vector<t_index>& v) const {
+        hrw::utils::hash_value res(v.size());
+        for(t_index i: v) { res << i; }
+        return res;
+      }
+    };
+
+    t_ctx_term& m_ctx;
+    std::vector<t_index> m_codes;
+    std::vector<std::string> m_variable_specs;
+    std::unordered_map<std::string, t_index> m_variable_codes;
+    std::unordered_set<std::vector<t_index>, t_key_hash> m_checked; // (theory, constructor, codes of the subterms) already type-checked
+    std::vector<t_index> m_key;
+    std::vector<t_term_full_ref> m_nodes;
+    std::size_t m_nb_values;
+
+    void validate(const term_bulk& desc, const std::vector<t_term_full_ref>& externals, bool check) {
+      static const auto validators = type::make_table<t_validate_fun>(
+        [](auto th) { return &type::template validate_sterm<typename decltype(th)::type>; });
+
+      if((desc.nb_nodes > 0) && (desc.offsets[0] != 0)) {
+        throw hrw::exception::bulk_format(0, "the offsets do not start at 0");
+      }
+      this->m_codes.clear();
+      this->m_codes.reserve(desc.nb_nodes);
+      for(std::size_t i = 0; i < desc.nb_nodes; ++i) {
+        t_index begin = desc.offsets[i];
+        t_index end = desc.offsets[i+1];
+        if((end < begin) || (end > desc.nb_children)) {
+          throw hrw::exception::bulk_format(i, "wrong offsets");
+        }
+        for(t_index j = begin; j < end; ++j) {
+          if(desc.children[j] >= i) {
+            throw hrw::exception::bulk_format(i, "a subterm does not precede its term");
+          }
+        }
+
+        t_index th = desc.theories[i];
+        if(th == term_bulk::external) {
+          if(desc.constructors[i] >= externals.size()) {
+            throw hrw::exception::bulk_format(i, "wrong external term index");
+          }
+          if(end != begin) {
+            throw hrw::exception::bulk_format(i, "an external term has subterms");
+          }
+          this->m_codes.push_back(this->get_code(externals[desc.constructors[i]]));
+        } else if(th >= nb_theories) {
+          throw hrw::exception::bulk_format(i, "wrong theory index");
+        } else {
+          (this->*(validators[th]))(desc, i, check);
+        }
+      }
+    }
+
+    t_index get_code(const t_term_full_ref& t) {
+      if(t->is_structured()) {
+        return t->get_sort();
+      } else {
+        const std::string& spec = t->get_spec();
+        auto it = this->m_variable_codes.find(spec);
+        if(it == this->m_variable_codes.end()) {
+          t_index res = variable_code | static_cast<t_index>(this->m_variable_specs.size());
+          this->m_variable_specs.push_back(spec);
+          this->m_variable_codes.emplace(spec, res);
+          return res;
+        } else {
+          return it->second;
+        }
+      }
+    }
+
+    const std::string& get_code_spec(t_index code) const {
+      if(code & variable_code) {
+        return this->m_variable_specs[code & ~variable_code];
+      } else {
+        return ctx_theory::get_sort_name(code);
+      }
+    }
+
+    template<typename th>
+    void validate_sterm(const term_bulk& desc, std::size_t i, bool check) {
+      using t_term = term_t<th>;
+      t_constructor_core<th> c(desc.constructors[i]);
+      if(!ctx_theory::contains_constructor(c)) {
+        throw hrw::exception::bulk_format(i, "undeclared constructor");
+      }
+      t_index begin = desc.offsets[i];
+      t_index end = desc.offsets[i+1];
+      if constexpr(!has_container_v<t_term>) {
+        if(end != begin) {
+          throw hrw::exception::bulk_format(i, "the constructor does not have subterms");
+        }
+      } else if constexpr(has_spec_v<th>) {
+        if(check) {
+          this->m_key.clear();
+          this->m_key.push_back(static_cast<t_index>(ctx_theory::template theory_index_v<th>));
+          this->m_key.push_back(c.id());
+          for(t_index j = begin; j < end; ++j) { this->m_key.push_back(this->m_codes[desc.children[j]]); }
+          if(this->m_checked.find(this->m_key) == this->m_checked.end()) {
+            // same check as the factory of the theory
+            std::string regexp = "";
+            for(t_index j = begin; j < end; ++j) { regexp = regexp + " " + this->get_code_spec(this->m_codes[desc.children[j]]); }
+            const auto& spec = ctx_theory::get_spec(c);
+            auto check_spec = hrw::utils::spec_intern<typename ctx_theory::t_spec_sequence>::get(regexp);
+            if(!hrw::utils::inclusion(*check_spec, spec)) {
+              throw hrw::exception::th_free_construct<t_term_full_ref>(c.id(), spec.get_regexp(), regexp);
+            }
+            this->m_checked.insert(this->m_key);
+          }
+        }
+      }
+      this->m_codes.push_back(ctx_theory::get_sort(c));
+    }
+
+    //////////////////////////////////////////
+    // creation
+
+    template<typename th, typename t_values>
+    t_term_full_ref create_sterm(t_values& values, const term_bulk& desc, std::size_t i) {
+      using t_term = term_t<th>;
+      t_constructor_core<th> c(desc.constructors[i]);
+      if constexpr(has_container_v<t_term>) {
+        get_container_t<t_term> subterms;
+        for(t_index j = desc.offsets[i]; j < desc.offsets[i+1]; ++j) {
+          subterms.push_back(this->m_nodes[desc.children[j]]);
+        }
+        return this->m_ctx.create_sterm_no_check(c, std::move(subterms));
+      } else if constexpr(has_value_v<t_term>) {
+        return this->m_ctx.create_sterm_no_check(c, values.template get<get_value_t<t_term>>(this->m_nb_values++));
+      } else {
+        return this->m_ctx.create_sterm_no_check(c);
+      }
+    }
+  };
+
+
+  /////////////////////////////////////////////////////////////////////////////
+  // EXPORT
+  /////////////////////////////////////////////////////////////////////////////
+
+  // the arrays of a DAG of terms in the form of term_bulk, with the sort of each node, and the index of its literal value (or `external`).
+  // A variable is exported as an external node of sort `external`
+  struct term_bulk_data {
+    using t_index = term_bulk::t_index;
+
+    std::vector<t_index> theories;
+    std::vector<t_index> constructors;
+    std::vector<t_index> sorts;
+    std::vector<t_index> offsets;
+    std::vector<t_index> children;
+    std::vector<t_index> literals;
+    std::vector<t_index> roots;
+
+    term_bulk description() const {
+      return term_bulk{this->theories.size(), this->children.size(), this->theories.data(), this->constructors.data(), this->offsets.data(), this->children.data()};
+    }
+  };
+
+  // walks the terms once, each shared subterm being exported in a single node placed after its subterms
+  template<typename t_ctx_term>
+  class term_bulk_exporter {
+  public:
+    using type = term_bulk_exporter<t_ctx_term>;
+    using t_term_full = typename t_ctx_term::t_term_full;
+    using t_term_full_ref = typename t_ctx_term::t_term_full_ref;
+    using t_variable = typename t_term_full::t_variable;
+    using t_index = term_bulk::t_index;
+
+    term_bulk_exporter(): m_data(), m_externals(), m_indices(), m_nb_values(0) { this->m_data.offsets.push_back(0); }
+    term_bulk_exporter(const type&) = delete;
+
+    // adds t and its subterms not already exported, and returns the index of its node.
+    // on_value is called on the value of each new literal, in the order of the literal indices
+    template<typename F>
+    t_index add(t_term_full_ref t, F&& on_value) {
+      t_index res = this->add_dag(t, on_value);
+      this->m_data.roots.push_back(res);
+      return res;
+    }
+
+    term_bulk_data& data() { return this->m_data; }
+    std::vector<t_term_full_ref>& externals() { return this->m_externals; }
+
+  private:
+    term_bulk_data m_data;
+    std::vector<t_term_full_ref> m_externals;
+    hrw::utils::flat_hash_map<const t_term_full*, t_index, hrw::utils::hash_mixed<const t_term_full*>> m_indices;
+    t_index m_nb_values;
+
+    static const t_term_full* to_ptr(const t_term_full_ref& t) { return t_term_full::make_ptr_struct::to_ptr(t); }
+
+    // same iterative traversal as term_binary_writer, on the references stored in the terms, that live as long as their root
+    struct t_frame {
+      const t_term_full_ref* m_term;
+      std::size_t m_begin;
+      std::size_t m_next;
+      std::size_t m_end;
+      std::size_t m_indices;
+    };
+
+    template<typename F>
+    t_index add_dag(t_term_full_ref root, F& on_value) {
+      std::vector<t_frame> stack;
+      std::vector<const t_term_full_ref*> children;
+      std::vector<t_index> child_indices;
+      auto enter = [&](const t_term_full_ref* t) {
+        auto it = this->m_indices.find(type::to_ptr(*t));
+        if(it != this->m_indices.end()) {
+          child_indices.push_back(it->second);
+        } else {
+          std::size_t begin = children.size();
+          (*t)->for_each_subterm([&children](const t_term_full_ref& s) { children.push_back(&s); });
+          stack.push_back(t_frame{t, begin, begin, children.size(), child_indices.size()});
+        }
+      };
+
+      enter(&root);
+      while(!stack.empty()) {
+        t_frame& frame = stack.back();
+        if(frame.m_next != frame.m_end) {
+          enter(children[frame.m_next++]);
+        } else {
+          t_frame f = frame;
+          stack.pop_back();
+          std::size_t nb_children = child_indices.size() - f.m_indices;
+          t_index idx = this->add_node(*f.m_term, child_indices.data() + f.m_indices, nb_children, on_value);
+          children.resize(f.m_begin);
+          child_indices.resize(f.m_indices);
+          child_indices.push_back(idx);
+        }
+      }
+      return child_indices.back();
+    }
+
+    template<typename F>
+    t_index add_node(const t_term_full_ref& t, const t_index* child_indices, std::size_t nb_children, F& on_value) {
+      term_bulk_data& data = this->m_data;
+      t_index res = static_cast<t_index>(data.theories.size());
+      VISIT_SINGLE([&](const auto& content) {
+        using T = std::decay_t<decltype(content)>;
+        if constexpr(std::is_same_v<T, t_variable>) {
+          data.theories.push_back(term_bulk::external);
+          data.constructors.push_back(static_cast<t_index>(this->m_externals.size()));
+          data.sorts.push_back(term_bulk::external);
+          this->m_externals.push_back(t);
+        } else {
+          data.theories.push_back(static_cast<t_index>(t->index() - 1));
+          data.constructors.push_back(content.get_constructor());
+          data.sorts.push_back(t->get_sort());
+        }
+        if constexpr(has_value_v<T>) {
+          data.literals.push_back(this->m_nb_values++);
+          on_value(content.get_value());
+        } else {
+          data.literals.push_back(term_bulk::external);
+        }
+      }, t->m_content);
+      data.children.insert(data.children.end(), child_indices, child_indices + nb_children);
+      data.offsets.push_back(static_cast<t_index>(data.children.size()));
+      this->m_indices.emplace(type::to_ptr(t), res);
+      return res;
+    }
+  };
+
+}
+
+
+#endif // __HREWRITE_HTERM_BULK_H__
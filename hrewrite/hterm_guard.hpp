@@ -0,0 +1,551 @@
+/*
+ * This file is part of the hrewrite library.
+ * Copyright (c) 2021 ONERA.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+ // Author: Michael Lienhardt
+ // Maintainer: Michael Lienhardt
+ // email: michael.lienhardt@onera.fr
+
+
+#ifndef __HREWRITE_HTERM_GUARD_H__
+#define __HREWRITE_HTERM_GUARD_H__
+
+#include <string>
+#include <vector>
+#include <array>
+#include <memory>
+#include <optional>
+#include <variant>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <utility>
+
+#include "hrewrite/utils.hpp"
+#include "hrewrite/parsing.hpp"
+#include "hrewrite/theory/core.hpp"
+#include "hrewrite/exceptions/guard.hpp"
+
+
+namespace hrw {
+  namespace guard {
+
+
+    /////////////////////////////////////////////////////////////////////////////
+    // 1. VALUES
+    /////////////////////////////////////////////////////////////////////////////
+
+    // the values computed by a native guard. std::monostate is the undefined value (e.g., the value of a term that is not a literal),
+    // and a guard whose condition is undefined fails
+    using t_value = std::variant<std::monostate, bool, std::int64_t, double, std::string>;
+
+    // conversion between the values of the literal terms and the values of the guards, to specialise for other literal types
+    template<typename T, typename=void> struct value_traits {
+      static t_value to_value(const T&) { return t_value(); }
+      static std::optional<T> from_value(const t_value&) { return std::nullopt; }
+    };
+
+    template<> struct value_traits<bool> {
+      static t_value to_value(const bool v) { return t_value(v); }
+      static std::optional<bool> from_value(const t_value& v) {
+        if(const bool* b = std::get_if<bool>(&v)) { return *b; }
+        return std::nullopt;
+      }
+    };
+
+    template<typename T> struct value_traits<T, std::enable_if_t<std::is_integral_v<T> && (!std::is_same_v<T, bool>)>> {
+      static t_value to_value(const T v) { return t_value(static_cast<std::int64_t>(v)); }
+      static std::optional<T> from_value(const t_value& v) {
+        if(const std::int64_t* i = std::get_if<std::int64_t>(&v)) {
+          T res = static_cast<T>(*i);
+          if((static_cast<std::int64_t>(res) == *i) && ((res < T(0)) == (*i < 0))) { return res; }
+        }
+        return std::nullopt;
+      }
+    };
+
+    template<typename T> struct value_traits<T, std::enable_if_t<std::is_floating_point_v<T>>> {
+      static t_value to_value(const T v) { return t_value(static_cast<double>(v)); }
+      static std::optional<T> from_value(const t_value& v) {
+        if(const double* d = std::get_if<double>(&v)) { return static_cast<T>(*d); }
+        if(const std::int64_t* i = std::get_if<std::int64_t>(&v)) { return static_cast<T>(*i); }
+        return std::nullopt;
+      }
+    };
+
+    template<> struct value_traits<std::string> {
+      static t_value to_value(const std::string& v) { return t_value(v); }
+      static std::optional<std::string> from_value(const t_value& v) {
+        if(const std::string* s = std::get_if<std::string>(&v)) { return *s; }
+        return std::nullopt;
+      }
+    };
+
+    template<> struct value_traits<hrw::utils::interned_string> {
+      static t_value to_value(const hrw::utils::interned_string& v) { return t_value(v.str()); }
+      static std::optional<hrw::utils::interned_string> from_value(const t_value& v) {
+        if(const std::string* s = std::get_if<std::string>(&v)) { return hrw::utils::interned_string(*s); }
+        return std::nullopt;
+      }
+    };
+
+
+    /////////////////////////////////////////////////////////////////////////////
+    // 2. EXPRESSIONS
+    /////////////////////////////////////////////////////////////////////////////
+
+    enum class e_op {
+      VALUE, VARIABLE,
+      ADD, SUB, MUL, DIV, MOD, NEG,
+      EQ, NE, LT, LE, GT, GE,
+      AND, OR, NOT,
+      LENGTH, CONTAINS, STARTS_WITH, ENDS_WITH,
+      TO_INT, TO_FLOAT, TO_STRING,
+      IS_SORT
+    };
+
+    inline std::size_t arity(const e_op op) {
+      switch(op) {
+        case e_op::VALUE: case e_op::VARIABLE:
+          return 0;
+        case e_op::NEG: case e_op::NOT: case e_op::LENGTH: case e_op::TO_INT: case e_op::TO_FLOAT: case e_op::TO_STRING: case e_op::IS_SORT:
+          return 1;
+        default:
+          return 2;
+      }
+    }
+
+    // an immutable expression tree, that can be shared between guards.
+    // A variable evaluates to the value of its image in the substitution when this image is a literal, and is undefined otherwise
+    template<typename t_term_full_ref>
+    class expr {
+    public:
+      using type = expr<t_term_full_ref>;
+
+      expr(t_value v): m_node(std::make_shared<const t_node>(t_node{e_op::VALUE, std::move(v), std::nullopt, 0, {}})) {}
+      template<typename T, std::enable_if_t<std::is_arithmetic_v<T>, bool> = true>
+      expr(const T v): expr(type::make_value(v)) {}
+      expr(const char* v): expr(t_value(std::string(v))) {}
+      expr(const std::string& v): expr(t_value(v)) {}
+
+      static type variable(t_term_full_ref var) {
+        if(var->is_structured()) {
+          throw hrw::exception::guard_invalid("a guard expression can only refer to variables");
+        }
+        return type(std::make_shared<const t_node>(t_node{e_op::VARIABLE, t_value(), var, 0, {}}));
+      }
+
+      static type apply(const e_op op, std::vector<type> args) {
+        if((op == e_op::VALUE) || (op == e_op::VARIABLE) || (op == e_op::IS_SORT) || (args.size() != arity(op))) {
+          throw hrw::exception::guard_invalid("wrong number of arguments for an operator");
+        }
+        return type(std::make_shared<const t_node>(t_node{op, t_value(), std::nullopt, 0, std::move(args)}));
+      }
+
+      // true if the image of the variable var is a term whose sort is a subsort of sort
+      static type is_sort(type var, const t_sort_id sort) {
+        if(var.get_op() != e_op::VARIABLE) {
+          throw hrw::exception::guard_invalid("a sort test can only be applied to a variable");
+        }
+        return type(std::make_shared<const t_node>(t_node{e_op::IS_SORT, t_value(), std::nullopt, sort, {var}}));
+      }
+
+      e_op get_op() const { return this->m_node->m_op; }
+      const t_value& get_value() const { return this->m_node->m_value; }
+      const t_term_full_ref& get_variable() const { return this->m_node->m_variable.value(); }
+      t_sort_id get_sort() const { return this->m_node->m_sort; }
+      const std::vector<type>& get_args() const { return this->m_node->m_args; }
+
+      friend type operator+(type l, type r) { return type::apply(e_op::ADD, {std::move(l), std::move(r)}); }
+      friend type operator-(type l, type r) { return type::apply(e_op::SUB, {std::move(l), std::move(r)}); }
+      friend type operator*(type l, type r) { return type::apply(e_op::MUL, {std::move(l), std::move(r)}); }
+      friend type operator/(type l, type r) { return type::apply(e_op::DIV, {std::move(l), std::move(r)}); }
+      friend type operator%(type l, type r) { return type::apply(e_op::MOD, {std::move(l), std::move(r)}); }
+      friend type operator-(type e) { return type::apply(e_op::NEG, {std::move(e)}); }
+      friend type operator==(type l, type r) { return type::apply(e_op::EQ, {std::move(l), std::move(r)}); }
+      friend type operator!=(type l, type r) { return type::apply(e_op::NE, {std::move(l), std::move(r)}); }
+      friend type operator< (type l, type r) { return type::apply(e_op::LT, {std::move(l), std::move(r)}); }
+      friend type operator<=(type l, type r) { return type::apply(e_op::LE, {std::move(l), std::move(r)}); }
+      friend type operator> (type l, type r) { return type::apply(e_op::GT, {std::move(l), std::move(r)}); }
+      friend type operator>=(type l, type r) { return type::apply(e_op::GE, {std::move(l), std::move(r)}); }
+      friend type operator&&(type l, type r) { return type::apply(e_op::AND, {std::move(l), std::move(r)}); }
+      friend type operator||(type l, type r) { return type::apply(e_op::OR, {std::move(l), std::move(r)}); }
+      friend type operator!(type e) { return type::apply(e_op::NOT, {std::move(e)}); }
+
+    private:
+      struct t_node {
+        e_op m_op;
+        t_value m_value;
+        std::optional<t_term_full_ref> m_variable;
+        t_sort_id m_sort;
+        std::vector<type> m_args;
+      };
+      std::shared_ptr<const t_node> m_node;
+
+      expr(std::shared_ptr<const t_node> node): m_node(std::move(node)) {}
+
+      template<typename T>
+      static t_value make_value(const T v) {
+        if constexpr(std::is_same_v<T, bool>) {
+          return t_value(v);
+        } else if constexpr(std::is_integral_v<T>) {
+          return t_value(static_cast<std::int64_t>(v));
+        } else {
+          return t_value(static_cast<double>(v));
+        }
+      }
+    };
+
+    template<typename R> expr<R> length(expr<R> e) { return expr<R>::apply(e_op::LENGTH, {std::move(e)}); }
+    template<typename R> expr<R> contains(expr<R> l, typename expr<R>::type r) { return expr<R>::apply(e_op::CONTAINS, {std::move(l), std::move(r)}); }
+    template<typename R> expr<R> starts_with(expr<R> l, typename expr<R>::type r) { return expr<R>::apply(e_op::STARTS_WITH, {std::move(l), std::move(r)}); }
+    template<typename R> expr<R> ends_with(expr<R> l, typename expr<R>::type r) { return expr<R>::apply(e_op::ENDS_WITH, {std::move(l), std::move(r)}); }
+    template<typename R> expr<R> to_int(expr<R> e) { return expr<R>::apply(e_op::TO_INT, {std::move(e)}); }
+    template<typename R> expr<R> to_float(expr<R> e) { return expr<R>::apply(e_op::TO_FLOAT, {std::move(e)}); }
+    template<typename R> expr<R> to_str(expr<R> e) { return expr<R>::apply(e_op::TO_STRING, {std::move(e)}); }
+
+
+    /////////////////////////////////////////////////////////////////////////////
+    // 3. OPERATORS ON VALUES
+    /////////////////////////////////////////////////////////////////////////////
+
+    // integers are 64-bit and wrap around; an integer division by zero is undefined
+    namespace _detail {
+      inline bool is_number(const t_value& v) { return std::holds_alternative<std::int64_t>(v) || std::holds_alternative<double>(v); }
+      inline double to_double(const t_value& v) {
+        const std::int64_t* i = std::get_if<std::int64_t>(&v);
+        return (i != nullptr) ? static_cast<double>(*i) : std::get<double>(v);
+      }
+      template<typename T> int sign(const T& l, const T& r) { return (l < r) ? -1 : ((r < l) ? 1 : 0); }
+
+      // the order between two values, or nothing when they are not comparable
+      inline std::optional<int> compare(const t_value& l, const t_value& r) {
+        if(std::holds_alternative<std::int64_t>(l) && std::holds_alternative<std::int64_t>(r)) {
+          return sign(std::get<std::int64_t>(l), std::get<std::int64_t>(r));
+        } else if(is_number(l) && is_number(r)) {
+          double dl = to_double(l), dr = to_double(r);
+          if(std::isnan(dl) || std::isnan(dr)) { return std::nullopt; }
+          return sign(dl, dr);
+        } else if(std::holds_alternative<std::string>(l) && std::holds_alternative<std::string>(r)) {
+          return sign(std::get<std::string>(l), std::get<std::string>(r));
+        } else if(std::holds_alternative<bool>(l) && std::holds_alternative<bool>(r)) {
+          return sign(std::get<bool>(l), std::get<bool>(r));
+        } else {
+          return std::nullopt;
+        }
+      }
+
+      inline t_value arithmetic(const e_op op, const t_value& l, const t_value& r) {
+        if(std::holds_alternative<std::int64_t>(l) && std::holds_alternative<std::int64_t>(r)) {
+          std::int64_t il = std::get<std::int64_t>(l), ir = std::get<std::int64_t>(r);
+          std::uint64_t ul = static_cast<std::uint64_t>(il), ur = static_cast<std::uint64_t>(ir);
+          switch(op) {
+            case e_op::ADD: return static_cast<std::int64_t>(ul + ur);
+            case e_op::SUB: return static_cast<std::int64_t>(ul - ur);
+            case e_op::MUL: return static_cast<std::int64_t>(ul * ur);
+            default:
+              if((ir == 0) || ((il == std::numeric_limits<std::int64_t>::min()) && (ir == -1))) { return t_value(); }
+              return (op == e_op::DIV) ? (il / ir) : (il % ir);
+          }
+        } else if(is_number(l) && is_number(r)) {
+          double dl = to_double(l), dr = to_double(r);
+          switch(op) {
+            case e_op::ADD: return dl + dr;
+            case e_op::SUB: return dl - dr;
+            case e_op::MUL: return dl * dr;
+            case e_op::DIV: return dl / dr;
+            default: return std::fmod(dl, dr);
+          }
+        } else if((op == e_op::ADD) && std::holds_alternative<std::string>(l) && std::holds_alternative<std::string>(r)) {
+          return std::get<std::string>(l) + std::get<std::string>(r);
+        } else {
+          return t_value();
+        }
+      }
+
+      inline t_value strings(const e_op op, const t_value& l, const t_value& r) {
+        const std::string* sl = std::get_if<std::string>(&l);
+        const std::string* sr = std::get_if<std::string>(&r);
+        if((sl == nullptr) || (sr == nullptr)) { return t_value(); }
+        switch(op) {
+          case e_op::CONTAINS: return sl->find(*sr) != std::string::npos;
+          case e_op::STARTS_WITH: return sl->compare(0, sr->size(), *sr) == 0;
+          default: return (sl->size() >= sr->size()) && (sl->compare(sl->size() - sr->size(), sr->size(), *sr) == 0);
+        }
+      }
+
+      inline t_value convert(const e_op op, const t_value& v) {
+        if(std::holds_alternative<std::monostate>(v)) { return v; }
+        const std::string* s = std::get_if<std::string>(&v);
+        switch(op) {
+          case e_op::TO_INT:
+            if(s != nullptr) {
+              std::int64_t res;
+              auto [end, ec] = std::from_chars(s->data(), s->data() + s->size(), res);
+              if((ec == std::errc()) && (end == s->data() + s->size())) { return res; }
+              return t_value();
+            } else if(const double* d = std::get_if<double>(&v)) {
+              if(std::isfinite(*d) && (std::abs(*d) < 9.2e18)) { return static_cast<std::int64_t>(*d); }
+              return t_value();
+            } else if(const bool* b = std::get_if<bool>(&v)) {
+              return static_cast<std::int64_t>(*b);
+            } else {
+              return v;
+            }
+          case e_op::TO_FLOAT:
+            if(s != nullptr) {
+              double res;
+              auto [end, ec] = std::from_chars(s->data(), s->data() + s->size(), res);
+              if((ec == std::errc()) && (end == s->data() + s->size())) { return res; }
+              return t_value();
+            } else if(const bool* b = std::get_if<bool>(&v)) {
+              return static_cast<double>(*b);
+            } else {
+              return to_double(v);
+            }
+          default:
+            if(s != nullptr) {
+              return v;
+            } else if(const bool* b = std::get_if<bool>(&v)) {
+              return std::string(*b ? "true" : "false");
+            } else {
+              char buffer[32];
+              auto res = std::holds_alternative<double>(v)
+                ? std::to_chars(buffer, buffer + sizeof(buffer), std::get<double>(v))
+                : std::to_chars(buffer, buffer + sizeof(buffer), std::get<std::int64_t>(v));
+              return std::string(buffer, res.ptr);
+            }
+        }
+      }
+    }
+
+  }
+
+
+  /////////////////////////////////////////////////////////////////////////////
+  // NATIVE GUARD
+  /////////////////////////////////////////////////////////////////////////////
+
+  // a guard that runs without calling back into a foreign language: it checks a list of conditions,
+  // and then binds variables to new literals, in order, whose values are computed from the substitution
+  template<typename t_ctx_rw>
+  class native_guard {
+  public:
+    using type = native_guard<t_ctx_rw>;
+    using t_ctx_term = typename t_ctx_rw::t_ctx_term;
+    using ctx_theory = typename t_ctx_term::ctx_theory;
+    using t_term_full = typename t_ctx_term::t_term_full;
+    using t_term_full_ref = typename t_ctx_term::t_term_full_ref;
+    using t_substitution = typename t_ctx_term::t_substitution;
+    using t_variable = typename t_term_full::t_variable;
+    using t_value = guard::t_value;
+    using t_expr = guard::expr<t_term_full_ref>;
+    using e_op = guard::e_op;
+
+    static inline constexpr std::size_t nb_theories = std::tuple_size_v<typename ctx_theory::theories_structured>;
+
+    native_guard(): m_conditions(), m_bindings() {}
+
+    type& when(t_expr cond) {
+      this->m_conditions.push_back(std::move(cond));
+      return *this;
+    }
+
+    type& bind(t_term_full_ref var, const t_constructor_key key, t_expr value) {
+      if(var->is_structured()) {
+        throw hrw::exception::guard_invalid("a guard can only bind variables");
+      }
+      if((key.first >= nb_theories) || (type::creators()[key.first] == nullptr)) {
+        throw hrw::exception::guard_invalid("a guard can only create literals");
+      }
+      if(!type::containers()[key.first](key.second)) {
+        throw hrw::exception::guard_invalid("undeclared constructor");
+      }
+      this->m_bindings.push_back(t_binding{var, key.first, key.second, std::move(value)});
+      return *this;
+    }
+    template<typename th>
+    type& bind(t_term_full_ref var, const t_constructor_core<th> c, t_expr value) {
+      return this->bind(var, ctx_theory::get_key(c), std::move(value));
+    }
+
+    bool operator()(t_ctx_rw* rw, t_substitution* s) const {
+      t_ctx_term& ctx = rw->get_ctx_term();
+      for(const t_expr& cond: this->m_conditions) {
+        t_value v = type::eval(ctx, cond, *s);
+        const bool* b = std::get_if<bool>(&v);
+        if((b == nullptr) || (!(*b))) { return false; }
+      }
+      for(const t_binding& binding: this->m_bindings) {
+        std::optional<t_term_full_ref> t = type::creators()[binding.m_theory](ctx, binding.m_constructor, type::eval(ctx, binding.m_value, *s));
+        if(!t.has_value()) { return false; }
+        type::insert(*s, binding.m_variable, t.value());
+      }
+      return true;
+    }
+
+    static t_value eval(t_ctx_term& ctx, const t_expr& e, t_substitution& s) {
+      const e_op op = e.get_op();
+      const auto& args = e.get_args();
+      switch(op) {
+        case e_op::VALUE:
+          return e.get_value();
+        case e_op::VARIABLE: {
+          std::optional<t_term_full_ref> t = type::image_of(e.get_variable(), s);
+          return t.has_value() ? type::value_of(*t) : t_value();
+        }
+        case e_op::IS_SORT: {
+          std::optional<t_term_full_ref> t = type::image_of(args[0].get_variable(), s);
+          return t.has_value() && (*t)->is_structured() && ctx_theory::is_subsort((*t)->get_sort(), e.get_sort());
+        }
+        case e_op::AND: case e_op::OR: {
+          t_value l = type::eval(ctx, args[0], s);
+          const bool* bl = std::get_if<bool>(&l);
+          if(bl == nullptr) { return t_value(); }
+          if((*bl) == (op == e_op::OR)) { return l; }
+          t_value r = type::eval(ctx, args[1], s);
+          return std::holds_alternative<bool>(r) ? r : t_value();
+        }
+        case e_op::NOT: {
+          t_value v = type::eval(ctx, args[0], s);
+          const bool* b = std::get_if<bool>(&v);
+          return (b != nullptr) ? t_value(!(*b)) : t_value();
+        }
+        case e_op::NEG: {
+          t_value v = type::eval(ctx, args[0], s);
+          if(const std::int64_t* i = std::get_if<std::int64_t>(&v)) { return static_cast<std::int64_t>(0 - static_cast<std::uint64_t>(*i)); }
+          if(const double* d = std::get_if<double>(&v)) { return -(*d); }
+          return t_value();
+        }
+        case e_op::LENGTH: {
+          t_value v = type::eval(ctx, args[0], s);
+          const std::string* str = std::get_if<std::string>(&v);
+          return (str != nullptr) ? t_value(static_cast<std::int64_t>(str->size())) : t_value();
+        }
+        case e_op::TO_INT: case e_op::TO_FLOAT: case e_op::TO_STRING:
+          return guard::_detail::convert(op, type::eval(ctx, args[0], s));
+        default:
+          break;
+      }
+
+      t_value l = type::eval(ctx, args[0], s);
+      t_value r = type::eval(ctx, args[1], s);
+      if(std::holds_alternative<std::monostate>(l) || std::holds_alternative<std::monostate>(r)) { return t_value(); }
+      switch(op) {
+        case e_op::ADD: case e_op::SUB: case e_op::MUL: case e_op::DIV: case e_op::MOD:
+          return guard::_detail::arithmetic(op, l, r);
+        case e_op::CONTAINS: case e_op::STARTS_WITH: case e_op::ENDS_WITH:
+          return guard::_detail::strings(op, l, r);
+        default: {
+          std::optional<int> cmp = guard::_detail::compare(l, r);
+          if(op == e_op::EQ) { return cmp.has_value() && (cmp.value() == 0); }
+          if(op == e_op::NE) { return !(cmp.has_value() && (cmp.value() == 0)); }
+          if(!cmp.has_value()) { return t_value(); }
+          switch(op) {
+            case e_op::LT: return cmp.value() < 0;
+            case e_op::LE: return cmp.value() <= 0;
+            case e_op::GT: return cmp.value() > 0;
+            default: return cmp.value() >= 0;
+          }
+        }
+      }
+    }
+
+  private:
+    struct t_binding {
+      t_term_full_ref m_variable;
+      std::size_t m_theory;
+      t_constructor_id m_constructor;
+      t_expr m_value;
+    };
+
+    std::vector<t_expr> m_conditions;
+    std::vector<t_binding> m_bindings;
+
+    template<std::size_t I> using theory_t = typename ctx_theory::template theory_element_t<I>;
+    template<typename th> using term_t = typename th::template tt_term<t_term_full>;
+
+    using t_create_fun = std::optional<t_term_full_ref> (*)(t_ctx_term&, t_constructor_id, const t_value&);
+    using t_contains_fun = bool (*)(t_constructor_id);
+
+    template<typename th>
+    static std::optional<t_term_full_ref> create_literal(t_ctx_term& ctx, const t_constructor_id c, const t_value& v) {
+      using t_data = get_value_t<term_t<th>>;
+      std::optional<t_data> data = guard::value_traits<t_data>::from_value(v);
+      if(data.has_value()) {
+        return ctx.create_sterm(t_constructor_core<th>(c), std::move(data.value()));
+      } else {
+        return std::nullopt;
+      }
+    }
+
+    template<std::size_t ... Is>
+    static std::array<t_create_fun, nb_theories> make_creators(std::index_sequence<Is...>) {
+      return {{ [](){
+        if constexpr(has_value_v<term_t<theory_t<Is>>>) {
+          return &type::template create_literal<theory_t<Is>>;
+        } else {
+          return static_cast<t_create_fun>(nullptr);
+        }
+      }()... }};
+    }
+    static const std::array<t_create_fun, nb_theories>& creators() {
+      static const auto res = type::make_creators(std::make_index_sequence<nb_theories>());
+      return res;
+    }
+
+    template<std::size_t ... Is>
+    static std::array<t_contains_fun, nb_theories> make_containers(std::index_sequence<Is...>) {
+      return {{ [](const t_constructor_id c) { return ctx_theory::contains_constructor(t_constructor_core<theory_t<Is>>(c)); }... }};
+    }
+    static const std::array<t_contains_fun, nb_theories>& containers() {
+      static const auto res = type::make_containers(std::make_index_sequence<nb_theories>());
+      return res;
+    }
+
+    // the image of a variable bound to a single term, read without instantiating the variable
+    static std::optional<t_term_full_ref> image_of(const t_term_full_ref& var, const t_substitution& s) {
+      return s.get_single(var->template get_if<t_variable>());
+    }
+
+    static t_value value_of(t_term_full_ref t) {
+      return t->visit([](const auto& st) {
+        using T = std::decay_t<decltype(st)>;
+        if constexpr(has_value_v<T>) {
+          return guard::value_traits<get_value_t<T>>::to_value(st.get_value());
+        } else {
+          return t_value();
+        }
+      });
+    }
+
+    static void insert(t_substitution& s, t_term_full_ref var, t_term_full_ref t) {
+      const t_variable* v = var->template get_if<t_variable>();
+      if constexpr(t_variable::t_spec::complexity >= hrw::utils::parsing_complexity::SEQUENCE) {
+        using single_iterator = typename t_term_full::single_iterator;
+        s.insert(v, single_iterator(t), single_iterator());
+      } else {
+        s.insert(v, t);
+      }
+    }
+  };
+
+}
+
+
+#endif // __HREWRITE_HTERM_GUARD_H__
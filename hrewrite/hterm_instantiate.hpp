@@ -85,7 +85,7 @@ namespace hrw {
             instantiate_helper<t_ctx_term> obj(this->m_rweng, s, this->m_subst);
             container.push_back(VISIT_SINGLE(obj, s->m_content));
           }
-          return this->m_rweng.template create_sterm_from_diff<T>(t, std::move(container));
+          return this->m_rweng.template create_sterm_from_diff<T>(this->m_t, t, std::move(container));
         } else {
           return this->m_t;
         }
@@ -150,7 +150,7 @@ namespace hrw {
             instantiate_helper<t_ctx_term, t_container_other> obj(this->m_rweng, s, this->m_subst, container);
             VISIT_SINGLE(obj, s->m_content);
           }
-          this->m_container.push_back(this->m_rweng.template create_sterm_from_diff<T>(t, std::move(container)));
+          this->m_container.push_back(this->m_rweng.template create_sterm_from_diff<T>(this->m_t, t, std::move(container)));
         } else {
           this->m_container.push_back(this->m_t);
         }
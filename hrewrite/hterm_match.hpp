@@ -44,14 +44,26 @@ namespace hrw {
     using reference = t_sort_id&;
     using type = tt_term_full_match_helper_iterator<termIt>;
 
-    tt_term_full_match_helper_iterator(termIt it): m_it(it) {}
-    t_sort_id operator*() { return (*this->m_it)->get_sort(); }
-    tt_term_full_match_helper_iterator& operator++() { ++(this->m_it); return *this; }
+    tt_term_full_match_helper_iterator(termIt it, const t_sort_id* sorts=nullptr): m_it(it), m_sorts(sorts) {}
+    t_sort_id operator*() { return (this->m_sorts != nullptr)?(*this->m_sorts):((*this->m_it)->get_sort()); }
+    tt_term_full_match_helper_iterator& operator++() {
+      ++(this->m_it);
+      if(this->m_sorts != nullptr) { ++(this->m_sorts); }
+      return *this;
+    }
     bool operator==(const tt_term_full_match_helper_iterator& other) const { return this->m_it == other.m_it; }
 
     termIt m_it;
+    const t_sort_id* m_sorts; // sorts of the terms starting at m_it, when the parent term caches them (nullptr otherwise)
   };
 
+  // the sorts cached in a term are only valid if the terms cannot be modified in place
+  template<bool is_const_v>
+  inline const t_sort_id* match_sorts(const t_sort_id* sorts) {
+    if constexpr(is_const_v) { return sorts; }
+    else { return nullptr; }
+  }
+
 
   struct t_match_data_empty {};
 
@@ -110,6 +122,11 @@ namespace hrw {
       return (tg_current == tg_end);
     }
 
+    template<typename termIt1, typename termIt2>
+    bool match_term(termIt1 p_current, termIt1 p_end, termIt2 tg_current, termIt2 tg_end, const t_sort_id*, t_substitution& subst) {
+      return this->match_term(p_current, p_end, tg_current, tg_end, subst);
+    }
+
   private: 
     struct match_term_helper {
       match_term_helper(reference tg, t_substitution& subst, type& m): m_tg(tg), m_subst(subst), m_match(m) {}
@@ -201,16 +218,23 @@ namespace hrw {
 
     template<typename termIt1, typename termIt2>
     bool match_term(termIt1 p_current, termIt1 p_end, termIt2 tg_current, termIt2 tg_end, t_substitution& subst) {
+      return this->match_term(p_current, p_end, tg_current, tg_end, nullptr, subst);
+    }
+
+    template<typename termIt1, typename termIt2>
+    bool match_term(termIt1 p_current, termIt1 p_end, termIt2 tg_current, termIt2 tg_end, const t_sort_id* tg_sorts, t_substitution& subst) {
+      tg_sorts = match_sorts<is_const_v>(tg_sorts);
       while(p_current != p_end) {
         if(tg_current == tg_end) {
           return false;
         } else {
           reference pattern = *p_current;
-          match_term_helper<termIt2> obj(tg_current, tg_end, subst, *this);
+          match_term_helper<termIt2> obj(tg_current, tg_end, tg_sorts, subst, *this);
           bool success = VISIT_SINGLE(obj, pattern->m_content);
           if(!success) { return false; }
           ++p_current;
           tg_current = obj.m_res;
+          tg_sorts = obj.m_res_sorts;
         }
       }
       return (tg_current == tg_end);
@@ -219,8 +243,8 @@ namespace hrw {
   private:
     template<typename termIt>
     struct match_term_helper {
-      match_term_helper(termIt tg_current, termIt tg_end, t_substitution& subst, type& m):
-        m_tg_current(tg_current), m_tg_end(tg_end), m_res(tg_end), m_subst(subst), m_match(m) {}
+      match_term_helper(termIt tg_current, termIt tg_end, const t_sort_id* tg_sorts, t_substitution& subst, type& m):
+        m_tg_current(tg_current), m_tg_end(tg_end), m_tg_sorts(tg_sorts), m_match(m), m_subst(subst), m_res(tg_end), m_res_sorts(nullptr) {}
       template<typename T>
       bool operator()(T& p) {
         using t_term_core = std::decay_t<T>; // the type stored in the t_content variant
@@ -228,13 +252,14 @@ namespace hrw {
         if constexpr(std::is_same_v<t_term_core, t_variable>) {
           auto m = hrw::utils::match(
             p.get_spec(),
-            tt_term_full_match_helper_iterator<termIt>(this->m_tg_current),
+            tt_term_full_match_helper_iterator<termIt>(this->m_tg_current, this->m_tg_sorts),
             tt_term_full_match_helper_iterator<termIt>(this->m_tg_end)
           );
           auto res = m.begin();
           if(res != m.end()) {
             this->m_subst.insert(&p, this->m_tg_current, (*res).m_it);
             this->m_res = (*res).m_it;
+            this->m_res_sorts = (*res).m_sorts;
             return true;
           } else {
             return false;
@@ -243,6 +268,7 @@ namespace hrw {
           t_term_cv* tt = std::get_if<t_term_core>(&((*this->m_tg_current)->m_content));
           if(tt != nullptr) {
             this->m_res = this->m_tg_current+1;
+            this->m_res_sorts = (this->m_tg_sorts != nullptr)?(this->m_tg_sorts+1):nullptr;
             return ((&p == tt) || (p.template match<t_substitution, type>(*tt, this->m_subst, this->m_match)));
           } else {
             return false;
@@ -253,10 +279,12 @@ namespace hrw {
     private:
       termIt m_tg_current;
       termIt m_tg_end;
+      const t_sort_id* m_tg_sorts;
       type& m_match;
       t_substitution& m_subst;
     public:
       termIt m_res;
+      const t_sort_id* m_res_sorts;
     };
 
   private:
@@ -330,20 +358,26 @@ namespace hrw {
 
     template<typename termIt1, typename termIt2>
     bool match_term(termIt1 p_current, termIt1 p_end, termIt2 tg_current, termIt2 tg_end, t_substitution& subst) {
+      return this->match_term(p_current, p_end, tg_current, tg_end, nullptr, subst);
+    }
+
+    template<typename termIt1, typename termIt2>
+    bool match_term(termIt1 p_current, termIt1 p_end, termIt2 tg_current, termIt2 tg_end, const t_sort_id* tg_sorts, t_substitution& subst) {
+      tg_sorts = match_sorts<is_const_v>(tg_sorts);
       if(p_current != p_end) {
         auto t = *p_current;
-        match_term_helper<termIt1, termIt2> obj(p_current+1, p_end, tg_current, tg_end, subst, *this);
+        match_term_helper<termIt1, termIt2> obj(p_current+1, p_end, tg_current, tg_end, tg_sorts, subst, *this);
         return VISIT_SINGLE(obj, t->m_content); // direct access to term content
       } else if(tg_current == tg_end) {
         if(this->m_stack.size() == 0) {
           if constexpr(not std::is_same_v<t_rw, void>) { return this->m_content.m_guard(this->m_content.m_rw, &subst); }
           else { return true; }
         } else {
-          auto pair_el = this->m_stack.back();
+          auto stack_el = this->m_stack.back();
           this->m_stack.pop_back();
-          match_term_wrapper obj(subst, *this);
-          if(not VISIT_SINGLE(obj, pair_el.first, pair_el.second)) {
-            this->m_stack.push_back(pair_el);
+          match_term_wrapper obj(std::get<2>(stack_el), subst, *this);
+          if(not VISIT_SINGLE(obj, std::get<0>(stack_el), std::get<1>(stack_el))) {
+            this->m_stack.push_back(stack_el);
             return false;  
           }
           return true;
@@ -355,8 +389,8 @@ namespace hrw {
   private:
     template<typename termIt1, typename termIt2>
     struct match_term_helper {
-      match_term_helper(termIt1 p_next, termIt1 p_end, termIt2 tg_current, termIt2 tg_end, t_substitution& subst, type& m):
-        m_p_next(p_next), m_p_end(p_end), m_tg_current(tg_current), m_tg_end(tg_end), m_subst(subst), m_match(m) {}
+      match_term_helper(termIt1 p_next, termIt1 p_end, termIt2 tg_current, termIt2 tg_end, const t_sort_id* tg_sorts, t_substitution& subst, type& m):
+        m_p_next(p_next), m_p_end(p_end), m_tg_current(tg_current), m_tg_end(tg_end), m_tg_sorts(tg_sorts), m_subst(subst), m_match(m) {}
 
       template<typename T>
       bool operator()(T& pattern) {
@@ -365,24 +399,26 @@ namespace hrw {
         if constexpr(std::is_same_v<t_term_core, t_variable>) {
           auto m = hrw::utils::match(
             pattern.get_spec(),
-            tt_term_full_match_helper_iterator<termIt2>(this->m_tg_current),
+            tt_term_full_match_helper_iterator<termIt2>(this->m_tg_current, this->m_tg_sorts),
             tt_term_full_match_helper_iterator<termIt2>(this->m_tg_end)
           );
           for(auto it: m) {
             // std::cout << "  found solution" << std::endl;
             this->m_subst.insert(&pattern, this->m_tg_current, it.m_it);
-            if(this->m_match.match_term(this->m_p_next, this->m_p_end, it.m_it, this->m_tg_end, this->m_subst)) { return true; }
+            if(this->m_match.match_term(this->m_p_next, this->m_p_end, it.m_it, this->m_tg_end, it.m_sorts, this->m_subst)) { return true; }
           }
           return false;
         } else {
           if(this->m_tg_current != this->m_tg_end) {
             t_term_cv* tt = std::get_if<t_term_core>(&((*(this->m_tg_current))->m_content));
             if(tt != nullptr) {
-              if(&pattern == tt) { return this->m_match.match_term(this->m_p_next, this->m_p_end, this->m_tg_current+1, this->m_tg_end, this->m_subst); }
+              const t_sort_id* tg_sorts_next = (this->m_tg_sorts != nullptr)?(this->m_tg_sorts+1):nullptr;
+              if(&pattern == tt) { return this->m_match.match_term(this->m_p_next, this->m_p_end, this->m_tg_current+1, this->m_tg_end, tg_sorts_next, this->m_subst); }
               if constexpr(hrw::has_container_v<t_term_core>) {
-                this->m_match.m_stack.push_back(std::make_pair(
-                  t_stack_el(std::make_pair(this->m_p_next, this->m_p_end)),
-                  t_stack_el(std::make_pair(this->m_tg_current+1, this->m_tg_end))
+                this->m_match.m_stack.push_back(std::make_tuple(
+                  t_pattern_stack_el(std::make_pair(this->m_p_next, this->m_p_end)),
+                  t_stack_el(std::make_pair(this->m_tg_current+1, this->m_tg_end)),
+                  tg_sorts_next
                 ));
                 if(not pattern.template match<t_substitution, type>(*tt, this->m_subst, this->m_match)) {
                   this->m_match.m_stack.pop_back();
@@ -391,7 +427,7 @@ namespace hrw {
                 return true;
               } else {
                 if(pattern.template match<t_substitution, type>(*tt, this->m_subst, this->m_match)) {
-                  return this->m_match.match_term(this->m_p_next, this->m_p_end, this->m_tg_current+1, this->m_tg_end, this->m_subst);
+                  return this->m_match.match_term(this->m_p_next, this->m_p_end, this->m_tg_current+1, this->m_tg_end, tg_sorts_next, this->m_subst);
                 } else {
                   return false;
                 }
@@ -407,19 +443,21 @@ namespace hrw {
       termIt1 m_p_end;
       termIt2 m_tg_current;
       termIt2 m_tg_end;
+      const t_sort_id* m_tg_sorts;
       t_substitution& m_subst;
       type& m_match;
 
     };
 
   struct match_term_wrapper {
-    match_term_wrapper(t_substitution& subst, type& m): m_subst(subst), m_match(m) {}
+    match_term_wrapper(const t_sort_id* tg_sorts, t_substitution& subst, type& m): m_tg_sorts(tg_sorts), m_subst(subst), m_match(m) {}
     template<typename termIt1, typename termIt2>
     bool operator()(std::pair<termIt1, termIt1> p, std::pair<termIt2, termIt2> tg) {
-      return this->m_match.match_term(p.first, p.second, tg.first, tg.second, this->m_subst);
+      return this->m_match.match_term(p.first, p.second, tg.first, tg.second, this->m_tg_sorts, this->m_subst);
     }
 
     private:
+      const t_sort_id* m_tg_sorts;
       t_substitution& m_subst;
       type& m_match;
   };
@@ -429,10 +467,13 @@ namespace hrw {
     t_content m_content;
 
     // construct the type form the stack, which may contain any pairs or pairs of iterators in a term
+    // the root pattern is iterated with a raw pointer, which differs from reference when the registry does not use pointers
     template<typename T> using to_pairs = std::pair<T, T>;
     using t_iterator_pairs = hrw::utils::tuple_map_t<to_pairs, typename t_substitution::t_iterators>;
     using t_stack_el = hrw::utils::tuple_convert_t<std::variant, t_iterator_pairs>;
-    std::vector<std::pair<t_stack_el, t_stack_el>> m_stack;
+    using t_pattern_iterator = hrw::utils::iterator_single<std::conditional_t<is_const_v, const tt_term_full*, tt_term_full*>, true>;
+    using t_pattern_stack_el = hrw::utils::tuple_convert_t<std::variant, hrw::utils::tuple_toset_t<hrw::utils::tuple_add_t<to_pairs<t_pattern_iterator>, t_iterator_pairs>>>;
+    std::vector<std::tuple<t_pattern_stack_el, t_stack_el, const t_sort_id*>> m_stack;
   };
 
 
@@ -0,0 +1,456 @@
+/*
+ * This file is part of the hrewrite library.
+ * Copyright (c) 2021 ONERA.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+ // Author: Michael Lienhardt
+ // Maintainer: Michael Lienhardt
+ // email: michael.lienhardt@onera.fr
+
+
+#ifndef __HREWRITE_HTERM_TEXT_H__
+#define __HREWRITE_HTERM_TEXT_H__
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <charconv>
+#include <cstdint>
+#include <optional>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+
+#include "hrewrite/utils.hpp"
+#include "hrewrite/theory/core.hpp"
+#include "hrewrite/hterm_bulk.hpp"
+#include "hrewrite/exceptions/bulk.hpp"
+#include "hrewrite/exceptions/text.hpp"
+
+
+namespace hrw {
+
+
+  /////////////////////////////////////////////////////////////////////////////
+  // LITERAL VALUES
+  /////////////////////////////////////////////////////////////////////////////
+
+  // the escapes \" \\ \n and \t of a quoted string
+  inline std::string text_unescape(std::string_view s) {
+    std::string res;
+    res.reserve(s.size());
+    for(std::size_t i = 0; i < s.size(); ++i) {
+      char c = s[i];
+      if((c == '\\') && (i + 1 < s.size())) {
+        c = s[++i];
+        if(c == 'n') { c = '\n'; }
+        else if(c == 't') { c = '\t'; }
+      }
+      res.push_back(c);
+    }
+    return res;
+  }
+
+  // conversion of the text of a literal into the value of a literal theory: nullopt when the text is not a valid value
+  template<typename T, typename=void> struct text_value_traits;
+
+  template<typename T> struct text_value_traits<T, std::enable_if_t<std::is_arithmetic_v<T> && !std::is_same_v<T, bool>>> {
+    static std::optional<T> from_text(std::string_view s, bool quoted) {
+      T res;
+      auto [end, ec] = std::from_chars(s.data(), s.data() + s.size(), res);
+      if(quoted || (ec != std::errc()) || (end != s.data() + s.size())) { return std::nullopt; }
+      return res;
+    }
+  };
+
+  template<> struct text_value_traits<bool> {
+    static std::optional<bool> from_text(std::string_view s, bool quoted) {
+      if(!quoted && (s == "true")) { return true; }
+      if(!quoted && (s == "false")) { return false; }
+      return std::nullopt;
+    }
+  };
+
+  template<> struct text_value_traits<std::string> {
+    static std::optional<std::string> from_text(std::string_view s, bool quoted) {
+      return quoted ? text_unescape(s) : std::string(s);
+    }
+  };
+
+  template<> struct text_value_traits<hrw::utils::interned_string> {
+    static std::optional<hrw::utils::interned_string> from_text(std::string_view s, bool quoted) {
+      if(quoted && (s.find('\\') != std::string_view::npos)) { return hrw::utils::interned_string(text_unescape(s)); }
+      return hrw::utils::interned_string(s);
+    }
+  };
+
+
+  /////////////////////////////////////////////////////////////////////////////
+  // PARSER
+  /////////////////////////////////////////////////////////////////////////////
+
+  // reads a sequence of terms and rules written over the declared constructors:
+  //   term := name | (name term*) | (name literal) | ?var:spec | ?var
+  //   rule := (=> term term)
+  // where a literal is a number, a word or a "quoted string", and the spec of a variable is a word or a "quoted string".
+  // A variable is given its spec at its first occurrence, and is shared by all its occurrences in the same term or rule.
+  // Comments start with ';' and end with the line.
+  // The text is read in place: the items are accumulated in a term_bulk, which is built (hash-consed and type-checked) once
+  // every batch_size nodes, so the type-checking cache of the builder is shared by all the items of the text
+  template<typename t_ctx_term>
+  class term_text_parser {
+  public:
+    using type = term_text_parser<t_ctx_term>;
+    using ctx_theory = typename t_ctx_term::ctx_theory;
+    using t_term_full_ref = typename t_ctx_term::t_term_full_ref;
+    using t_builder = term_bulk_builder<t_ctx_term>;
+    using t_index = term_bulk::t_index;
+
+    static inline constexpr std::size_t batch_size = std::size_t(1) << 16;
+
+    term_text_parser(t_ctx_term& ctx, bool check=true): m_ctx(ctx), m_builder(ctx), m_check(check), m_signature(), m_text(), m_pos(0),
+      m_theories(), m_constructors(), m_offsets({0}), m_children(), m_positions(), m_literals(), m_externals(), m_items(),
+      m_variables(), m_stack(), m_pending() {}
+    term_text_parser(const type&) = delete;
+
+    // the constructors usable in the text. A name declared several times denotes its last declaration
+    template<typename th>
+    void declare(const t_constructor_core<th> c) {
+      static_assert(ctx_theory::template is_registered_stheory_v<th>);
+      this->m_signature[ctx_theory::get_name(c)] = std::make_pair(static_cast<t_index>(ctx_theory::template theory_index_v<th>), c.id());
+    }
+    void declare(t_index theory, t_index c) {
+      const std::string* name = type::get_name(theory, c, std::make_index_sequence<t_builder::nb_theories>());
+      if(name == nullptr) {
+        throw hrw::exception::generic("ERROR: cannot declare the undeclared constructor (" + std::to_string(theory) + ", " + std::to_string(c) + ")");
+      }
+      this->m_signature[*name] = std::make_pair(theory, c);
+    }
+
+    // on_term(t) is called on each term of the text, and on_rule(pattern, image) on each rule, in order
+    template<typename F_term, typename F_rule>
+    void parse(std::string_view text, F_term&& on_term, F_rule&& on_rule) {
+      this->m_text = text;
+      this->m_pos = 0;
+      this->clear();
+      try {
+        while(this->parse_item()) {
+          if(this->m_theories.size() >= batch_size) { this->flush(on_term, on_rule); }
+        }
+        this->flush(on_term, on_rule);
+      } catch(...) {
+        this->clear();
+        throw;
+      }
+    }
+
+    template<typename F_term, typename F_rule>
+    void parse_file(const std::string& path, F_term&& on_term, F_rule&& on_rule) {
+      hrw::utils::mapped_file file(path);
+      this->parse(file.content(), on_term, on_rule);
+    }
+
+  private:
+    template<std::size_t I> using theory_t = typename ctx_theory::template theory_element_t<I>;
+
+    template<std::size_t ... Is>
+    static const std::string* get_name(t_index theory, t_index c, std::index_sequence<Is...>) {
+      const std::string* res = nullptr;
+      ((((Is == theory) && ctx_theory::contains_constructor(t_constructor_core<theory_t<Is>>(c)))
+        ? (res = &ctx_theory::get_name(t_constructor_core<theory_t<Is>>(c)), true) : false) || ...);
+      return res;
+    }
+
+    enum class e_token { OPEN, CLOSE, WORD, STRING, VARIABLE, END };
+    struct t_token {
+      e_token m_kind;
+      std::string_view m_text;
+      std::string_view m_spec; // for the variables
+      bool m_spec_quoted;
+      std::size_t m_pos;
+    };
+    struct t_literal {
+      std::string_view m_text;
+      bool m_quoted;
+      std::size_t m_pos;
+    };
+    struct t_item {
+      t_index m_term;
+      t_index m_image; // term_bulk::external for a term
+    };
+    struct t_frame {
+      t_index m_theory; // term_bulk::external for a rule
+      t_index m_constructor;
+      std::size_t m_children;
+      std::size_t m_pos;
+    };
+    struct t_variable {
+      t_index m_node;
+      std::string_view m_spec;
+    };
+
+    // the values of the literals of a batch, in the order of their nodes
+    struct t_values {
+      type& m_parser;
+      template<typename T> T get(std::size_t k) {
+        const t_literal& l = this->m_parser.m_literals[k];
+        std::optional<T> res = text_value_traits<T>::from_text(l.m_text, l.m_quoted);
+        if(!res.has_value()) { this->m_parser.error(l.m_pos, "invalid literal \"" + std::string(l.m_text) + "\""); }
+        return std::move(res.value());
+      }
+    };
+
+    t_ctx_term& m_ctx;
+    t_builder m_builder;
+    bool m_check;
+    std::unordered_map<std::string_view, std::pair<t_index, t_index>> m_signature; // views on the names stored in the theory context
+
+    std::string_view m_text;
+    std::size_t m_pos;
+
+    // the current batch
+    std::vector<t_index> m_theories;
+    std::vector<t_index> m_constructors;
+    std::vector<t_index> m_offsets;
+    std::vector<t_index> m_children;
+    std::vector<std::size_t> m_positions;
+    std::vector<t_literal> m_literals;
+    std::vector<t_term_full_ref> m_externals;
+    std::vector<t_item> m_items;
+
+    // the current item
+    std::unordered_map<std::string_view, t_variable> m_variables;
+    std::vector<t_frame> m_stack;
+    std::vector<t_index> m_pending;
+
+    void clear() {
+      this->m_theories.clear();
+      this->m_constructors.clear();
+      this->m_offsets.resize(1);
+      this->m_children.clear();
+      this->m_positions.clear();
+      this->m_literals.clear();
+      this->m_externals.clear();
+      this->m_items.clear();
+    }
+
+    [[noreturn]] void error(std::size_t pos, const std::string& reason) const {
+      std::size_t line = 1, column = 1;
+      for(std::size_t i = 0; (i < pos) && (i < this->m_text.size()); ++i) {
+        if(this->m_text[i] == '\n') { ++line; column = 1; } else { ++column; }
+      }
+      throw hrw::exception::text_format(line, column, reason);
+    }
+
+    template<typename F_term, typename F_rule>
+    void flush(F_term& on_term, F_rule& on_rule) {
+      if(this->m_items.empty()) { return; }
+      term_bulk desc{this->m_theories.size(), this->m_children.size(),
+        this->m_theories.data(), this->m_constructors.data(), this->m_offsets.data(), this->m_children.data()};
+      std::vector<t_term_full_ref> nodes;
+      try {
+        nodes = this->m_builder.build(desc, this->m_externals, t_values{*this}, this->m_check);
+      } catch(hrw::exception::bulk_format const& e) {
+        this->error(this->m_positions[e.get_node()], "invalid term");
+      }
+      for(const t_item& item: this->m_items) {
+        if(item.m_image == term_bulk::external) {
+          on_term(nodes[item.m_term]);
+        } else {
+          on_rule(nodes[item.m_term], nodes[item.m_image]);
+        }
+      }
+      this->clear();
+    }
+
+    //////////////////////////////////////////
+    // lexer
+
+    static bool is_delimiter(char c) {
+      switch(c) {
+        case ' ': case '\t': case '\n': case '\r': case '(': case ')': case '"': case ';': return true;
+        default: return false;
+      }
+    }
+
+    void skip_blanks() {
+      const std::size_t size = this->m_text.size();
+      while(this->m_pos < size) {
+        char c = this->m_text[this->m_pos];
+        if((c == ' ') || (c == '\t') || (c == '\n') || (c == '\r')) {
+          ++this->m_pos;
+        } else if(c == ';') {
+          std::size_t end = this->m_text.find('\n', this->m_pos);
+          this->m_pos = (end == std::string_view::npos) ? size : end;
+        } else {
+          return;
+        }
+      }
+    }
+
+    std::string_view read_word(std::size_t begin, bool variable) {
+      std::size_t end = begin;
+      while((end < this->m_text.size()) && !type::is_delimiter(this->m_text[end]) && !(variable && (this->m_text[end] == ':'))) { ++end; }
+      this->m_pos = end;
+      return this->m_text.substr(begin, end - begin);
+    }
+
+    // the content of the string starting at m_pos, without its quotes and with its escapes
+    std::string_view read_string() {
+      std::size_t begin = this->m_pos + 1;
+      std::size_t end = begin;
+      while(true) {
+        end = this->m_text.find_first_of("\"\\", end);
+        if(end == std::string_view::npos) { this->error(this->m_pos, "unterminated string"); }
+        if(this->m_text[end] == '"') { break; }
+        end += 2;
+      }
+      this->m_pos = end + 1;
+      return this->m_text.substr(begin, end - begin);
+    }
+
+    t_token next() {
+      this->skip_blanks();
+      t_token res{e_token::END, std::string_view(), std::string_view(), false, this->m_pos};
+      if(this->m_pos == this->m_text.size()) { return res; }
+      switch(this->m_text[this->m_pos]) {
+        case '(': res.m_kind = e_token::OPEN; ++this->m_pos; break;
+        case ')': res.m_kind = e_token::CLOSE; ++this->m_pos; break;
+        case '"': res.m_kind = e_token::STRING; res.m_text = this->read_string(); break;
+        case '?':
+          res.m_kind = e_token::VARIABLE;
+          res.m_text = this->read_word(this->m_pos + 1, true);
+          if(res.m_text.empty()) { this->error(res.m_pos, "a variable has no name"); }
+          if((this->m_pos < this->m_text.size()) && (this->m_text[this->m_pos] == ':')) {
+            ++this->m_pos;
+            if((this->m_pos < this->m_text.size()) && (this->m_text[this->m_pos] == '"')) {
+              res.m_spec = this->read_string();
+              res.m_spec_quoted = true;
+            } else {
+              res.m_spec = this->read_word(this->m_pos, false);
+            }
+            if(res.m_spec.empty()) { this->error(res.m_pos, "empty variable spec"); }
+          }
+          break;
+        default: res.m_kind = e_token::WORD; res.m_text = this->read_word(this->m_pos, false);
+      }
+      return res;
+    }
+
+    //////////////////////////////////////////
+    // items
+
+    t_index add_node(t_index theory, t_index c, std::size_t children, std::size_t pos) {
+      t_index res = static_cast<t_index>(this->m_theories.size());
+      this->m_theories.push_back(theory);
+      this->m_constructors.push_back(c);
+      this->m_children.insert(this->m_children.end(), this->m_pending.begin() + children, this->m_pending.end());
+      this->m_offsets.push_back(static_cast<t_index>(this->m_children.size()));
+      this->m_positions.push_back(pos);
+      this->m_pending.resize(children);
+      return res;
+    }
+
+    std::pair<t_index, t_index> get_constructor(const t_token& token) {
+      auto it = this->m_signature.find(token.m_text);
+      if(it == this->m_signature.end()) { this->error(token.m_pos, "undeclared constructor \"" + std::string(token.m_text) + "\""); }
+      return it->second;
+    }
+
+    t_index get_variable(const t_token& token) {
+      auto it = this->m_variables.find(token.m_text);
+      if(it != this->m_variables.end()) {
+        if((!token.m_spec.empty()) && (token.m_spec != it->second.m_spec)) {
+          this->error(token.m_pos, "the variable \"" + std::string(token.m_text) + "\" is given another spec");
+        }
+        return it->second.m_node;
+      }
+      if(token.m_spec.empty()) {
+        this->error(token.m_pos, "the variable \"" + std::string(token.m_text) + "\" has no spec");
+      }
+      std::string spec = token.m_spec_quoted ? text_unescape(token.m_spec) : std::string(token.m_spec);
+      this->m_externals.push_back(this->m_ctx.create_vterm(spec));
+      t_index res = this->add_node(term_bulk::external, static_cast<t_index>(this->m_externals.size() - 1), this->m_pending.size(), token.m_pos);
+      this->m_variables.emplace(token.m_text, t_variable{res, token.m_spec});
+      return res;
+    }
+
+    // reads the next term or rule of the text, returns false at the end of the text
+    bool parse_item() {
+      this->m_variables.clear();
+      this->m_stack.clear();
+      this->m_pending.clear();
+      do {
+        t_token token = this->next();
+        switch(token.m_kind) {
+          case e_token::END:
+            if(!this->m_stack.empty()) { this->error(this->m_stack.back().m_pos, "unbalanced parenthesis"); }
+            return false;
+          case e_token::OPEN: {
+            t_token head = this->next();
+            if(head.m_kind != e_token::WORD) { this->error(head.m_pos, "expected a constructor"); }
+            if(this->m_stack.empty() && this->m_pending.empty() && (head.m_text == "=>")) {
+              this->m_stack.push_back(t_frame{term_bulk::external, 0, 0, token.m_pos});
+              break;
+            }
+            auto [theory, c] = this->get_constructor(head);
+            if(t_builder::has_value(theory)) {
+              t_token value = this->next();
+              if((value.m_kind != e_token::WORD) && (value.m_kind != e_token::STRING)) { this->error(value.m_pos, "expected a literal"); }
+              if(this->next().m_kind != e_token::CLOSE) { this->error(token.m_pos, "a literal has a single value"); }
+              this->m_literals.push_back(t_literal{value.m_text, value.m_kind == e_token::STRING, value.m_pos});
+              this->m_pending.push_back(this->add_node(theory, c, this->m_pending.size(), token.m_pos));
+            } else {
+              this->m_stack.push_back(t_frame{theory, c, this->m_pending.size(), token.m_pos});
+            }
+            break;
+          }
+          case e_token::CLOSE: {
+            if(this->m_stack.empty()) { this->error(token.m_pos, "unbalanced parenthesis"); }
+            t_frame frame = this->m_stack.back();
+            this->m_stack.pop_back();
+            if(frame.m_theory == term_bulk::external) {
+              if(this->m_pending.size() != 2) { this->error(frame.m_pos, "a rule has a pattern and an image"); }
+              this->m_items.push_back(t_item{this->m_pending[0], this->m_pending[1]});
+              return true;
+            }
+            if((!t_builder::has_subterms(frame.m_theory)) && (this->m_pending.size() != frame.m_children)) {
+              this->error(frame.m_pos, "the constructor does not have subterms");
+            }
+            this->m_pending.push_back(this->add_node(frame.m_theory, frame.m_constructor, frame.m_children, frame.m_pos));
+            break;
+          }
+          case e_token::WORD: {
+            auto [theory, c] = this->get_constructor(token);
+            if(t_builder::has_value(theory)) { this->error(token.m_pos, "a literal constructor expects a value"); }
+            this->m_pending.push_back(this->add_node(theory, c, this->m_pending.size(), token.m_pos));
+            break;
+          }
+          case e_token::STRING:
+            this->error(token.m_pos, "unexpected string");
+          case e_token::VARIABLE:
+            this->m_pending.push_back(this->get_variable(token));
+            break;
+        }
+      } while(!this->m_stack.empty());
+      this->m_items.push_back(t_item{this->m_pending.back(), term_bulk::external});
+      return true;
+    }
+  };
+
+}
+
+
+#endif // __HREWRITE_HTERM_TEXT_H__
@@ -30,6 +30,7 @@
 #include "hrewrite/parsing/combine.hpp"
 #include "hrewrite/parsing/match.hpp"
 #include "hrewrite/parsing/inclusion.hpp"
+#include "hrewrite/parsing/intern.hpp"
 
 
 
@@ -0,0 +1,122 @@
+/*
+ * This file is part of the hrewrite library.
+ * Copyright (c) 2021 ONERA.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+ // Author: Michael Lienhardt
+ // Maintainer: Michael Lienhardt
+ // email: michael.lienhardt@onera.fr
+
+
+#ifndef __HREWRITE_PARSING_INTERN_H__
+#define __HREWRITE_PARSING_INTERN_H__
+
+#include <string>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <unordered_map>
+
+#include "hrewrite/parsing/core.hpp"
+
+
+namespace hrw {
+  namespace utils {
+
+
+    /////////////////////////////////////////////////////////////////////////////
+    // 1. NORMALISATION
+    /////////////////////////////////////////////////////////////////////////////
+
+    // removes the blanks that are not needed to separate two words
+    inline std::string normalize_regexp(const std::string& s) {
+      std::string res;
+      res.reserve(s.length());
+      bool blank = false;
+      for(const char c: s) {
+        if(is_char_separator(c)) {
+          blank = !res.empty();
+        } else {
+          if(blank && (!is_char_special(c)) && (!is_char_special(res.back()))) {
+            res.push_back(space);
+          }
+          res.push_back(c);
+          blank = false;
+        }
+      }
+      return res;
+    }
+
+
+    /////////////////////////////////////////////////////////////////////////////
+    // 2. INTERNING TABLE
+    /////////////////////////////////////////////////////////////////////////////
+
+    // one table per parser type, and so per alphabet: all the specs with the same normalised regexp share the same immutable parser.
+    // Letters are resolved when a parser is constructed, so the table must be cleared together with its alphabet.
+    // The table is shared by all the term universes, and so is protected by a lock.
+
+    template<typename P>
+    class spec_intern {
+    public:
+      using type = spec_intern<P>;
+      using t_spec = P;
+      using reference = std::shared_ptr<const t_spec>;
+
+      static reference get(const std::string& s) {
+        std::string key = normalize_regexp(s);
+        std::lock_guard<std::mutex> lock(type::mutex());
+        auto it = type::content().find(key);
+        if(it == type::content().end()) {
+          reference res = std::make_shared<const t_spec>(key);
+          type::content().emplace(std::move(key), res);
+          return res;
+        } else {
+          return it->second;
+        }
+      }
+
+      static std::size_t size() {
+        std::lock_guard<std::mutex> lock(type::mutex());
+        return type::content().size();
+      }
+      static void clear() {
+        std::lock_guard<std::mutex> lock(type::mutex());
+        type::content().clear();
+      }
+
+    private:
+      using t_content = std::unordered_map<std::string, reference>;
+      static t_content& content() {
+        static t_content res;
+        return res;
+      }
+      static std::mutex& mutex() {
+        static std::mutex res;
+        return res;
+      }
+    };
+
+
+    template<typename T> struct spec_intern_tuple;
+    template<typename ... Ps> struct spec_intern_tuple<std::tuple<Ps...>> {
+      static void clear() { (spec_intern<Ps>::clear(), ...); }
+    };
+
+  }
+} // end namespace
+
+
+#endif // __HREWRITE_PARSING_INTERN_H__
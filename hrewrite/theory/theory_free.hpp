@@ -50,9 +50,9 @@ namespace theory {
       using t_iterator = typename t_container::iterator;
       using t_const_iterator = typename t_container::const_iterator;
 
-      tt_theory_free_term(const t_sort_id sort, const t_constructor_id c, const t_container& subs) : m_sort(sort), m_c(c), m_subs(subs) {}
-      tt_theory_free_term(const t_sort_id sort, const t_constructor_id c, t_container&& subs) : m_sort(sort), m_c(c), m_subs(subs) {}
-      tt_theory_free_term(type const & t) : m_sort(t.m_sort), m_c(t.m_c), m_subs(t.m_subs) {}
+      tt_theory_free_term(const t_sort_id sort, const t_constructor_id c, const t_container& subs) : m_sort(sort), m_c(c), m_subs(subs) { this->init_sorts(); }
+      tt_theory_free_term(const t_sort_id sort, const t_constructor_id c, t_container&& subs) : m_sort(sort), m_c(c), m_subs(std::move(subs)) { this->init_sorts(); }
+      tt_theory_free_term(type const & t) : m_sort(t.m_sort), m_c(t.m_c), m_subs(t.m_subs), m_sorts(t.m_sorts) {}
 
       bool is_ground() const { return std::all_of(this->begin(), this->end(), [](auto it) { return it->is_ground(); }); }
 
@@ -69,6 +69,11 @@ namespace theory {
       const t_container& get_subterms() const { return this->m_subs; }
       std::size_t size() const { return this->m_subs.size(); }
 
+      // the sorts of the subterms, in one contiguous array, or nullptr if one subterm is a variable
+      const t_sort_id* get_subterm_sorts() const {
+        return (this->m_sorts.size() == this->m_subs.size())?(this->m_sorts.data()):nullptr;
+      }
+
       // printing
       template<typename t_context_print>
       void print(std::ostream& os, t_context_print& c) const {
@@ -127,7 +132,7 @@ namespace theory {
         using H = hrw::utils::hash_combine<std::tuple<
           // hrw::utils::hash<t_sort_id>,
           hrw::utils::hash<t_constructor_id>,
-          hrw::utils::hash_combine<std::vector<typename t_term_full::template t_hash_ref<deep>>>
+          hrw::utils::hash_combine<tt_container<typename t_term_full::template t_hash_ref<deep>>>
         >>;
         hrw::utils::hash_value operator()(const value_type& t) {
           // return H()(std::make_tuple(t.m_sort, t.m_c, t.m_subs));
@@ -160,6 +165,7 @@ namespace theory {
         this->m_sort = t.m_sort;
         this->m_c = t.m_c;
         this->m_subs = t.m_subs;
+        this->m_sorts = t.m_sorts;
         return *this;
       }
 
@@ -168,12 +174,25 @@ namespace theory {
         swap(t1.m_sort, t2.m_sort);
         swap(t1.m_c, t2.m_c);
         swap(t1.m_subs, t2.m_subs);
+        swap(t1.m_sorts, t2.m_sorts);
       }
 
     private:
       t_sort_id m_sort;
       t_constructor_id m_c;
       t_container m_subs;
+      tt_container<t_sort_id> m_sorts; // cache of the sorts of m_subs, used by the matching of sequences
+
+      void init_sorts() {
+        this->m_sorts.reserve(this->m_subs.size());
+        for(const auto& st: this->m_subs) {
+          if(!st->is_structured()) {
+            this->m_sorts.clear();
+            return;
+          }
+          this->m_sorts.push_back(st->get_sort());
+        }
+      }
     };
 
 
@@ -207,8 +226,8 @@ namespace theory {
         t_term_full create_term(const t_spec& spec, const t_sort_id s, const t_constructor_id c, t_container& subs) {
           std::string regexp = "";
           for(const auto& st: subs) { regexp = regexp + " " + (st->get_spec()); }
-          t_spec_sequence check(regexp);
-          if(hrw::utils::inclusion(check, spec)) {
+          auto check = hrw::utils::spec_intern<t_spec_sequence>::get(regexp);
+          if(hrw::utils::inclusion(*check, spec)) {
             return t_term_full(t_term(s, c, subs));
           } else {
             throw hrw::exception::th_free_construct<typename t_term_full::reference>(c, spec.get_regexp(), regexp);
@@ -218,8 +237,8 @@ namespace theory {
         t_term_full create_term(const t_spec& spec, const t_sort_id s, const t_constructor_id c, t_container&& subs) {
           std::string regexp = "";
           for(const auto& st: subs) { regexp = regexp + " " + (st->get_spec()); }
-          t_spec_sequence check(regexp);
-          if(hrw::utils::inclusion(check, spec)) {
+          auto check = hrw::utils::spec_intern<t_spec_sequence>::get(regexp);
+          if(hrw::utils::inclusion(*check, spec)) {
             return t_term_full(t_term(s, c, std::move(subs)));
           } else {
             throw hrw::exception::th_free_construct<typename t_term_full::reference>(c, spec.get_regexp(), regexp);
@@ -257,7 +276,7 @@ namespace theory {
           auto t_begin = t.begin();
           auto t_end   = t.end();
 
-          return m.match_term(p_begin, p_end, t_begin, t_end, subst);          
+          return m.match_term(p_begin, p_end, t_begin, t_end, t.get_subterm_sorts(), subst);
         }
 
 
@@ -61,12 +61,12 @@ namespace theory {
 
       struct t_hash_core {
         using value_type = type;
-        using H = hrw::utils::hash_combine<std::tuple<
-          hrw::utils::hash<t_constructor_id>,
-          typename t_theory::t_content_hash
-        >>;
+        using H = typename t_theory::t_content_hash;
+        // same as hash_combine on the tuple (m_c, m_content), without copying m_content
         hrw::utils::hash_value operator()(const value_type& t) {
-          return H()(std::make_tuple(t.m_c, t.m_content));
+          hrw::utils::hash_value res(0);
+          res << hrw::utils::hash<t_constructor_id>()(t.m_c) << H()(t.m_content);
+          return res;
         }
       };
       struct t_eq_core {
@@ -28,10 +28,13 @@
 #include <vector>
 #include <optional>
 #include <iostream>
+#include <memory>
+#include <atomic>
 
 
 #include "hrewrite/utils.hpp"
 #include "hrewrite/parsing/core.hpp"
+#include "hrewrite/parsing/intern.hpp"
 #include "hrewrite/theory/core.hpp"
 
 
@@ -46,13 +49,15 @@ namespace theory {
     class theory_variable_term_no_id {
     public:
       using t_spec = targ_spec;
+      using t_spec_ref = typename hrw::utils::spec_intern<t_spec>::reference;
       using type = theory_variable_term_no_id<t_spec>;
 
-      theory_variable_term_no_id(t_spec&& spec): m_spec(spec) { } // std::cout << "variable&& = " << this->m_spec << std::endl; }
-      theory_variable_term_no_id(const t_spec& spec): m_spec(spec) { } // std::cout << "variable& = " << this->m_spec << std::endl; }
+      theory_variable_term_no_id(t_spec&& spec): m_spec(std::make_shared<const t_spec>(std::move(spec))) { } // std::cout << "variable&& = " << this->m_spec << std::endl; }
+      theory_variable_term_no_id(const t_spec& spec): m_spec(std::make_shared<const t_spec>(spec)) { } // std::cout << "variable& = " << this->m_spec << std::endl; }
+      theory_variable_term_no_id(t_spec_ref spec): m_spec(spec) { }
       theory_variable_term_no_id(type const & t): m_spec(t.m_spec){ } // std::cout << "variable& = " << this->m_spec << std::endl; }
 
-      const t_spec& get_spec() const { return this->m_spec; }
+      const t_spec& get_spec() const { return *(this->m_spec); }
 
       template<typename t_context_print>
       void print(std::ostream& os, t_context_print& c) const {
@@ -91,7 +96,7 @@ namespace theory {
       friend void swap(type& v1, type& v2) { using std::swap; swap(v1.m_spec, v2.m_spec); }
 
     private:
-       const t_spec m_spec;
+       t_spec_ref m_spec;
     };
 
 
@@ -103,14 +108,16 @@ namespace theory {
     class theory_variable_term_id {
     public:
       using t_spec = targ_spec;
+      using t_spec_ref = typename hrw::utils::spec_intern<t_spec>::reference;
       using type = theory_variable_term_id<t_spec>;
       using t_id = unsigned int;
 
-      theory_variable_term_id(t_spec&& spec): m_spec(spec), m_id(type::counter++) { } // std::cout << "variable&& = " << this->m_spec << std::endl; }
-      theory_variable_term_id(const t_spec& spec): m_spec(spec), m_id(type::counter++) { } // std::cout << "variable& = " << this->m_spec << std::endl; }
+      theory_variable_term_id(t_spec&& spec): m_spec(std::make_shared<const t_spec>(std::move(spec))), m_id(type::counter++) { } // std::cout << "variable&& = " << this->m_spec << std::endl; }
+      theory_variable_term_id(const t_spec& spec): m_spec(std::make_shared<const t_spec>(spec)), m_id(type::counter++) { } // std::cout << "variable& = " << this->m_spec << std::endl; }
+      theory_variable_term_id(t_spec_ref spec): m_spec(spec), m_id(type::counter++) { }
       theory_variable_term_id(type const & t): m_spec(t.m_spec), m_id(t.m_id) { } // std::cout << "variable& = " << this->m_spec << std::endl; }
 
-      const t_spec& get_spec() const { return this->m_spec; }
+      const t_spec& get_spec() const { return *(this->m_spec); }
       t_id get_id() const { return this->m_id; }
 
       template<typename t_context_print>
@@ -153,17 +160,17 @@ namespace theory {
         swap(v1.m_id, v2.m_id);
       }
 
-      static t_id get_counter() { return type::counter; }
+      static t_id get_counter() { return type::counter.load(); }
 
     private:
-       t_spec m_spec;
+       t_spec_ref m_spec;
        t_id m_id;
 
-       static t_id counter;
+       static std::atomic<t_id> counter; // variables may be created from several threads
     };
 
     template<typename targ_spec>
-    typename theory_variable_term_id<targ_spec>::t_id theory_variable_term_id<targ_spec>::counter = 0;
+    std::atomic<typename theory_variable_term_id<targ_spec>::t_id> theory_variable_term_id<targ_spec>::counter(0);
 
 
     /////////////////////////////////////////////////////////////////////////////
@@ -199,6 +206,7 @@ namespace theory {
             return false;
           }
         }
+        std::optional<reference> retrieve_single() const { return this->m_content; }
         template<typename t_context_print>
         void print(std::ostream& os, t_context_print& c) const { this->m_content->print(os, c); }
 
@@ -265,6 +273,17 @@ namespace theory {
               return true;
           } }, this->m_content);
         }
+        // the image when it is a single term
+        std::optional<targ_reference> retrieve_single() const {
+          return VISIT_SINGLE(hrw::utils::visit_helper {
+            [](const std::monostate&) { return std::optional<targ_reference>(); },
+            [](auto& inner) {
+              auto it = inner.begin;
+              if(it == inner.end) { return std::optional<targ_reference>(); }
+              std::optional<targ_reference> res(*it);
+              return (++it == inner.end) ? res : std::optional<targ_reference>();
+          } }, this->m_content);
+        }
         template<typename t_context_print>
         void print(std::ostream& os, t_context_print& c) const {
           VISIT_SINGLE(hrw::utils::visit_helper {
@@ -536,6 +555,15 @@ namespace theory {
         return false;
       }
 
+      // the image of v when it is a single term, without allocating a container
+      std::optional<reference> get_single(const t_variable* v) const {
+        auto it = this->m_content.get(v);
+        if(it != this->m_content.m_content.end()) {
+          return t_content::get_value(it).retrieve_single();
+        }
+        return std::nullopt;
+      }
+
       iterator begin() { return this->m_content.begin(); }
       iterator end() { return this->m_content.end(); }
       const_iterator begin() const { return this->m_content.begin(); }
@@ -588,10 +616,7 @@ namespace theory {
         factory() = default;
 
         t_term_full create_term(const std::string& spec) {
-          return t_term_full(t_term(t_spec(spec)));
-        }
-        t_term_full create_term(std::string&& spec) {
-          return t_term_full(t_term(t_spec(std::move(spec))));
+          return t_term_full(t_term(hrw::utils::spec_intern<t_spec>::get(spec)));
         }
       };
 
@@ -31,11 +31,15 @@
 #include "hrewrite/utils/type_traits.hpp"
 #include "hrewrite/utils/print.hpp"
 #include "hrewrite/utils/hash.hpp"
+#include "hrewrite/utils/intern.hpp"
 #include "hrewrite/utils/natset.hpp"
 #include "hrewrite/utils/iterator.hpp"
 #include "hrewrite/utils/container.hpp"
+#include "hrewrite/utils/flat_hash.hpp"
 #include "hrewrite/utils/graph.hpp"
 #include "hrewrite/utils/variant.hpp"
+#include "hrewrite/utils/thread_pool.hpp"
+#include "hrewrite/utils/mapped_file.hpp"
 
 
 
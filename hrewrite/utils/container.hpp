@@ -27,6 +27,16 @@
 #include <optional>
 #include <memory>
 #include <iostream>
+#include <vector>
+#include <limits>
+#include <cstdint>
+#include <new>
+#include <algorithm>
+#include <initializer_list>
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <functional>
 
 #include "hrewrite/utils/iterator.hpp"
 #include "hrewrite/utils/hash.hpp"
@@ -119,6 +129,343 @@ namespace hrw {
 
 
 
+    /////////////////////////////////////////////////////////////////////////////
+    // SMALL VECTOR
+    /////////////////////////////////////////////////////////////////////////////
+
+    // vector storing up to N elements inline, and moving them to the heap when it grows beyond.
+    // Iterators are plain pointers and, as with std::vector, they are invalidated by a reallocation or a move
+
+    template<typename T, std::size_t N=4, typename Allocator=std::allocator<T>>
+    class small_vector {
+      static_assert(N > 0);
+    public:
+      using type = small_vector<T, N, Allocator>;
+      using value_type = T;
+      using allocator_type = Allocator;
+      using size_type = std::size_t;
+      using difference_type = std::ptrdiff_t;
+      using reference = value_type&;
+      using const_reference = const value_type&;
+      using pointer = value_type*;
+      using const_pointer = const value_type*;
+      using iterator = pointer;
+      using const_iterator = const_pointer;
+
+      static inline constexpr size_type inline_capacity = N;
+
+      //////////////////////////////////////////
+      // constructors / destructors
+      small_vector(): m_data(this->inline_data()), m_size(0), m_capacity(N), m_alloc() {}
+      small_vector(std::initializer_list<value_type> l): small_vector() { this->insert(this->end(), l.begin(), l.end()); }
+      small_vector(const type& v): small_vector() {
+        this->reserve(v.m_size);
+        for(const_reference el: v) { this->push_back_no_check(el); }
+      }
+      small_vector(type&& v): small_vector() { this->steal(std::move(v)); }
+      ~small_vector() { this->release(); }
+
+      type& operator=(const type& v) {
+        if(this != &v) {
+          this->clear();
+          this->reserve(v.m_size);
+          for(const_reference el: v) { this->push_back_no_check(el); }
+        }
+        return *this;
+      }
+      type& operator=(type&& v) {
+        if(this != &v) {
+          this->release();
+          this->m_data = this->inline_data();
+          this->m_capacity = N;
+          this->steal(std::move(v));
+        }
+        return *this;
+      }
+
+      //////////////////////////////////////////
+      // access
+      iterator begin() { return this->m_data; }
+      iterator end() { return this->m_data + this->m_size; }
+      const_iterator begin() const { return this->m_data; }
+      const_iterator end() const { return this->m_data + this->m_size; }
+      const_iterator cbegin() const { return this->m_data; }
+      const_iterator cend() const { return this->m_data + this->m_size; }
+
+      reference operator[](size_type i) { return this->m_data[i]; }
+      const_reference operator[](size_type i) const { return this->m_data[i]; }
+      reference front() { return this->m_data[0]; }
+      const_reference front() const { return this->m_data[0]; }
+      reference back() { return this->m_data[this->m_size - 1]; }
+      const_reference back() const { return this->m_data[this->m_size - 1]; }
+      pointer data() { return this->m_data; }
+      const_pointer data() const { return this->m_data; }
+
+      size_type size() const { return this->m_size; }
+      size_type capacity() const { return this->m_capacity; }
+      bool empty() const { return this->m_size == 0; }
+      bool is_inline() const { return this->m_data == this->inline_data(); }
+
+      //////////////////////////////////////////
+      // modification
+      void reserve(size_type n) {
+        if(n > this->m_capacity) {
+          pointer data = traits_t::allocate(this->m_alloc, n);
+          for(size_type i = 0; i < this->m_size; ++i) {
+            traits_t::construct(this->m_alloc, data + i, std::move(this->m_data[i]));
+            traits_t::destroy(this->m_alloc, this->m_data + i);
+          }
+          this->free_data();
+          this->m_data = data;
+          this->m_capacity = n;
+        }
+      }
+
+      void push_back(const_reference v) { this->emplace_back(v); }
+      void push_back(value_type&& v) { this->emplace_back(std::move(v)); }
+
+      template<typename ... Args>
+      reference emplace_back(Args&& ... args) {
+        if(this->m_size == this->m_capacity) {
+          // args may refer to an element of this vector
+          value_type tmp(std::forward<Args>(args)...);
+          this->reserve(2 * this->m_capacity);
+          return this->push_back_no_check(std::move(tmp));
+        } else {
+          return this->push_back_no_check(std::forward<Args>(args)...);
+        }
+      }
+
+      template<typename inputIt>
+      iterator insert(const_iterator pos, inputIt first, inputIt last) {
+        size_type offset = pos - this->cbegin();
+        size_type old_size = this->m_size;
+        for(; first != last; ++first) { this->emplace_back(*first); }
+        std::rotate(this->begin() + offset, this->begin() + old_size, this->end());
+        return this->begin() + offset;
+      }
+
+      void pop_back() { traits_t::destroy(this->m_alloc, this->m_data + (--this->m_size)); }
+
+      void clear() {
+        for(size_type i = 0; i < this->m_size; ++i) { traits_t::destroy(this->m_alloc, this->m_data + i); }
+        this->m_size = 0;
+      }
+
+      friend void swap(type& v1, type& v2) {
+        type tmp(std::move(v1));
+        v1 = std::move(v2);
+        v2 = std::move(tmp);
+      }
+
+      friend bool operator==(const type& v1, const type& v2) { return (v1.m_size == v2.m_size) && std::equal(v1.begin(), v1.end(), v2.begin()); }
+      friend bool operator!=(const type& v1, const type& v2) { return !(v1 == v2); }
+
+    private:
+      using traits_t = std::allocator_traits<allocator_type>;
+      using t_cell = std::aligned_storage_t<sizeof(value_type), alignof(value_type)>;
+
+      pointer inline_data() { return reinterpret_cast<pointer>(this->m_inline); }
+      const_pointer inline_data() const { return reinterpret_cast<const_pointer>(this->m_inline); }
+
+      template<typename ... Args>
+      reference push_back_no_check(Args&& ... args) {
+        traits_t::construct(this->m_alloc, this->m_data + this->m_size, std::forward<Args>(args)...);
+        return this->m_data[this->m_size++];
+      }
+
+      // takes the content of v, leaving it empty: this must be empty
+      void steal(type&& v) {
+        if(v.is_inline()) {
+          for(size_type i = 0; i < v.m_size; ++i) { this->push_back_no_check(std::move(v.m_data[i])); }
+          v.clear();
+        } else {
+          this->m_data = v.m_data;
+          this->m_size = v.m_size;
+          this->m_capacity = v.m_capacity;
+          v.m_data = v.inline_data();
+          v.m_size = 0;
+          v.m_capacity = N;
+        }
+      }
+
+      void free_data() {
+        if(!this->is_inline()) { traits_t::deallocate(this->m_alloc, this->m_data, this->m_capacity); }
+      }
+      void release() {
+        this->clear();
+        this->free_data();
+      }
+
+      t_cell m_inline[N];
+      pointer m_data;
+      size_type m_size;
+      size_type m_capacity;
+      allocator_type m_alloc;
+    };
+
+    // the small_vector with the default inline capacity, to be used as container template parameter (e.g., in theory_free)
+    template<typename T, typename Allocator=std::allocator<T>> using small_vector_default = small_vector<T, 4, Allocator>;
+
+
+    template<typename T, std::size_t N, typename Allocator>
+    struct hash_combine<small_vector<T, N, Allocator>> {
+      using value_type = small_vector<get_value_type<T>, N>;
+      hash_value operator()(const value_type& v) const {
+        hash_value res{0};
+        for(get_value_type<T> el: v) {
+          res << T()(el);
+        }
+        return res;
+      }
+    };
+
+    template<typename T, std::size_t N, typename Allocator>
+    struct eq_combine<small_vector<T, N, Allocator>> {
+      using value_type = small_vector<get_value_type<T>, N>;
+      bool operator()(const value_type& lhs, const value_type& rhs) const {
+        if(lhs.size() == rhs.size()) {
+          T comp;
+          for(std::size_t i = 0; i < lhs.size(); ++i) {
+            if(not comp(lhs[i], rhs[i])) {
+              return false;
+            }
+          }
+          return true;
+        } else {
+          return false;
+        }
+      }
+    };
+
+
+
+    /////////////////////////////////////////////////////////////////////////////
+    // POOL ALLOCATOR
+    /////////////////////////////////////////////////////////////////////////////
+
+    // single-object allocations are served from blocks of cells of the same size class (a multiple of 16 bytes),
+    // and freed cells are kept in a free list. A pool whose cells are all freed can be released in one go, one block at a time.
+    // Not thread-safe: it must not be used with registry_concurrent
+
+    class pool_allocator_store {
+    public:
+      static inline constexpr std::size_t class_size = 16;
+      static inline constexpr std::size_t nb_classes = 32; // up to 512 bytes
+      static inline constexpr std::size_t block_size = 4096; // in cells
+
+      // never destroyed, so that values in static registries can be freed at exit
+      static pool_allocator_store& instance() {
+        static pool_allocator_store& res = *(new pool_allocator_store());
+        return res;
+      }
+
+      // returns the size class of an allocation, or nb_classes if it is too large for the pools
+      static constexpr std::size_t size_class(std::size_t size, std::size_t align) {
+        return ((align <= class_size) && (size <= class_size * nb_classes) && (size > 0))?((size - 1) / class_size):nb_classes;
+      }
+
+      void* allocate(std::size_t c) { return this->m_pools[c].allocate(c); }
+      void deallocate(void* p, std::size_t c) { this->m_pools[c].deallocate(p); }
+
+      // number of cells currently allocated
+      std::size_t live() const {
+        std::size_t res = 0;
+        for(const t_pool& pool: this->m_pools) { res += pool.m_live; }
+        return res;
+      }
+
+      // frees the blocks of the pools that have no allocated cell
+      void release() {
+        for(t_pool& pool: this->m_pools) {
+          if(pool.m_live == 0) { pool.release(); }
+        }
+      }
+
+      pool_allocator_store(const pool_allocator_store&) = delete;
+
+    private:
+      pool_allocator_store() = default;
+
+      struct t_free { t_free* m_next; };
+      struct t_pool {
+        std::vector<void*> m_blocks;
+        t_free* m_free = nullptr;
+        std::size_t m_next = block_size; // next unused cell in the last block
+        std::size_t m_live = 0;
+
+        void* allocate(std::size_t c) {
+          ++this->m_live;
+          if(this->m_free != nullptr) {
+            t_free* res = this->m_free;
+            this->m_free = res->m_next;
+            return res;
+          }
+          const std::size_t cell_size = (c + 1) * class_size;
+          if(this->m_next == block_size) {
+            this->m_blocks.push_back(::operator new(cell_size * block_size));
+            this->m_next = 0;
+          }
+          return static_cast<char*>(this->m_blocks.back()) + (cell_size * (this->m_next++));
+        }
+        void deallocate(void* p) {
+          --this->m_live;
+          t_free* cell = static_cast<t_free*>(p);
+          cell->m_next = this->m_free;
+          this->m_free = cell;
+        }
+        void release() {
+          for(void* block: this->m_blocks) { ::operator delete(block); }
+          this->m_blocks.clear();
+          this->m_free = nullptr;
+          this->m_next = block_size;
+        }
+      };
+
+      std::array<t_pool, nb_classes> m_pools;
+    };
+
+
+    template<typename T>
+    class pool_allocator {
+    public:
+      using value_type = T;
+      template<typename U> struct rebind { using other = pool_allocator<U>; };
+
+      pool_allocator() noexcept {}
+      template<typename U> pool_allocator(const pool_allocator<U>&) noexcept {}
+
+      T* allocate(std::size_t n) {
+        if(n == 1) {
+          constexpr std::size_t c = pool_allocator_store::size_class(sizeof(T), alignof(T));
+          if constexpr(c < pool_allocator_store::nb_classes) {
+            return static_cast<T*>(pool_allocator_store::instance().allocate(c));
+          }
+        }
+        return std::allocator<T>().allocate(n);
+      }
+
+      void deallocate(T* p, std::size_t n) {
+        if(n == 1) {
+          constexpr std::size_t c = pool_allocator_store::size_class(sizeof(T), alignof(T));
+          if constexpr(c < pool_allocator_store::nb_classes) {
+            pool_allocator_store::instance().deallocate(p, c);
+            return;
+          }
+        }
+        std::allocator<T>().deallocate(p, n);
+      }
+
+      friend bool operator==(const pool_allocator&, const pool_allocator&) { return true; }
+      friend bool operator!=(const pool_allocator&, const pool_allocator&) { return false; }
+    };
+
+    // called by the registries when they are cleared: releases the memory of the allocator, if it is pooled
+    template<template<typename> typename A> struct allocator_release { static void run() {} };
+    template<> struct allocator_release<pool_allocator> { static void run() { pool_allocator_store::instance().release(); } };
+
+
+
     /////////////////////////////////////////////////////////////////////////////
     // REGISTERY
     /////////////////////////////////////////////////////////////////////////////
@@ -287,7 +634,7 @@ namespace hrw {
       using value_type = T;
       using value_const = const T;
 
-      t_count_wrapper(type&& t): m_content(t.m_content), m_reg(t.m_reg), m_count(t.m_count) {}
+      t_count_wrapper(type&& t): m_content(t.m_content), m_reg(t.m_reg), m_count(t.m_count.load()) {}
       t_count_wrapper(t_reg& m, T&& c): m_content(c), m_reg(m), m_count(0) {}
       template<typename ... Args>
       t_count_wrapper(t_reg& m, Args&& ... args): m_content(args...), m_reg(m), m_count(0) {}
@@ -298,7 +645,7 @@ namespace hrw {
 
       T m_content;
       t_reg& m_reg;
-      mutable unsigned int m_count;
+      mutable std::atomic<unsigned int> m_count;
     };
 
     template<typename T, typename H, typename E, typename t_reg>
@@ -435,10 +782,10 @@ namespace hrw {
           }
         } else {
           if(this->m_ptr != nullptr) {
-            --this->m_ptr->m_count;
-            if((this->m_ptr->m_count) == 1) {
+            unsigned int count = --this->m_ptr->m_count;
+            if(count == 1) {
               this->m_ptr->m_reg.clear(*this);              
-            } else if((this->m_ptr->m_count) == 0) {
+            } else if(count == 0) {
               using traits_t = std::allocator_traits<allocator_type>;
               traits_t::destroy(type::m_alloc, this->m_ptr);
               traits_t::deallocate(type::m_alloc, this->m_ptr, 1);
@@ -480,6 +827,37 @@ namespace hrw {
     // PB: t_count_ptr is a template on the type of map: t_make_ref depends on the kind of map!!!
 
 
+    // functions called by a registry with reference counting on each value just before it is released
+    template<typename T>
+    class release_callbacks {
+    public:
+      using t_callback = std::function<void(const T*)>;
+      using t_callback_id = std::size_t;
+
+      t_callback_id add_release_callback(t_callback f) {
+        this->m_callbacks.emplace_back(this->m_next_id, std::move(f));
+        return this->m_next_id++;
+      }
+      void remove_release_callback(t_callback_id id) {
+        auto it = std::find_if(this->m_callbacks.begin(), this->m_callbacks.end(), [id](const auto& c) { return c.first == id; });
+        if(it != this->m_callbacks.end()) {
+          this->m_callbacks.erase(it);
+        }
+      }
+
+    protected:
+      void on_release(const T* v) {
+        for(auto& c: this->m_callbacks) { c.second(v); }
+      }
+
+    private:
+      std::vector<std::pair<t_callback_id, t_callback>> m_callbacks;
+      t_callback_id m_next_id = 0;
+    };
+
+    struct no_release_callbacks {};
+
+
     template<template<typename ... Args> typename tt_set, bool arg_safe_reference, bool count_ptr=false>
     struct registry_unique {
 
@@ -519,13 +897,13 @@ namespace hrw {
         using cell_allocator = Allocator<cell_type_core>;
 
         using cell_ptr_type  = std::conditional_t<count_ptr, _tmp_count_ptr, std::conditional_t<!arg_safe_reference, _tmp_basic_ptr, value_type*>>;
-        using cell_ptr_hash  = std::conditional_t<count_ptr || !arg_safe_reference, tt_hash_fwd_get<cell_ptr_type>, std::hash<value_type *>>;
+        using cell_ptr_hash  = std::conditional_t<count_ptr || !arg_safe_reference, tt_hash_fwd_get<cell_ptr_type>, hash_mixed<value_type *>>;
         using cell_ptr_equal = std::conditional_t<count_ptr || !arg_safe_reference, tt_eq_fwd_get<cell_ptr_type>, std::equal_to<value_type *>>;
         using cell_ptr_allocator = Allocator<cell_ptr_type>;
 
         using ptr_type = std::conditional_t<count_ptr, _tmp_count_ptr, value_const *>;
         using ptr_const = std::add_const_t<ptr_type>;
-        using ptr_hash = std::conditional_t<count_ptr, tt_hash_get<ptr_type>, std::hash<value_const *>>;
+        using ptr_hash = std::conditional_t<count_ptr, tt_hash_get<ptr_type>, hash_mixed<value_const *>>;
         using ptr_equal = std::conditional_t<count_ptr, tt_eq_get<ptr_type>, std::equal_to<value_const *>>;
 
         static inline constexpr ptr_type from_cell(cell_type& v) {
@@ -578,7 +956,7 @@ namespace hrw {
 
 
       template<typename T, typename Hash, typename KeyEqual, template<typename> typename Allocator>
-      class make<T, Hash, KeyEqual, Allocator, true> {
+      class make<T, Hash, KeyEqual, Allocator, true>: public std::conditional_t<count_ptr, release_callbacks<T>, no_release_callbacks> {
       public:
         using type = make<T, Hash, KeyEqual, Allocator>;
         using value_type = T;
@@ -598,6 +976,7 @@ namespace hrw {
 
         static inline constexpr bool safe_reference = arg_safe_reference;
         static inline constexpr bool ref_counting = count_ptr;
+        static inline constexpr bool collectable = !count_ptr;
 
         //////////////////////////////////////////
         // constructors
@@ -613,25 +992,47 @@ namespace hrw {
         // api
         t_ptr add(value_type&& t) {
           // std::cout << "registry_unique::add() -> " << std::boolalpha << (this->m_content.find(t) != this->m_content.end()) << std::endl;
-          auto it = [&](){
-            if constexpr(count_ptr) {
-              return this->m_content.emplace(*this, std::move(t));
-            } else {
-              return this->m_content.emplace(std::move(t));
+          if constexpr(count_ptr) {
+            auto it = this->m_content.emplace(*this, std::move(t));
+            return ref_struct::from_cell((*it.first));
+          } else {
+            // look up before emplacing, so that no node is allocated when the value is already present
+            auto it = this->m_content.find(t);
+            if(it == this->m_content.end()) {
+              it = this->m_content.emplace(std::move(t)).first;
             }
-          }();
-          // static_assert(std::is_same_v<decltype(it), t_cell>);
-          return ref_struct::from_cell((*it.first));
+            return ref_struct::from_cell(*it);
+          }
         }
 
         const_iterator begin() { return ref_struct::make_iterator(this->m_content.cbegin()); }
         const_iterator end() { return ref_struct::make_iterator(this->m_content.cend()); }
+        size_type size() const { return this->m_content.size(); }
 
-        void clear() noexcept { this->m_content.clear(); }
+        void clear() noexcept {
+          this->m_content.clear();
+          allocator_release<Allocator>::run();
+        }
         template<bool b=count_ptr, std::enable_if_t<b, bool> = true>
         void clear(t_ptr& ref) {
+          this->on_release(ref.get_ptr());
           this->m_content.erase(ref.get_content());
         }
+
+        // removes all the values v for which is_alive(v) is false, returns the number of removed values
+        template<typename F, bool b=!count_ptr, std::enable_if_t<b, bool> = true>
+        size_type collect(F&& is_alive) {
+          size_type res = 0;
+          for(auto it = this->m_content.begin(); it != this->m_content.end();) {
+            if(is_alive(*it)) {
+              ++it;
+            } else {
+              it = this->m_content.erase(it);
+              ++res;
+            }
+          }
+          return res;
+        }
       private:
         t_content m_content;
       };
@@ -639,7 +1040,7 @@ namespace hrw {
 
 
       template<typename T, typename Hash, typename KeyEqual, template<typename> typename Allocator>
-      class make<T, Hash, KeyEqual, Allocator, false> {
+      class make<T, Hash, KeyEqual, Allocator, false>: public std::conditional_t<count_ptr, release_callbacks<T>, no_release_callbacks> {
       public:
         using type = make<T, Hash, KeyEqual, Allocator>;
         using value_type = T;
@@ -661,6 +1062,7 @@ namespace hrw {
 
         static inline constexpr bool safe_reference = arg_safe_reference;
         static inline constexpr bool ref_counting = count_ptr;
+        static inline constexpr bool collectable = !count_ptr;
 
         //////////////////////////////////////////
         // constructors / destructors
@@ -672,19 +1074,20 @@ namespace hrw {
         ~make() {}
 
         t_ptr add(value_type&& t) {
-          // create dummy cell_ptr
+          // create dummy cell_ptr: without reference counting, it directly points to t, which is thus not copied
           using t_cell = typename t_cell_ptr::content_core;
-          t_cell dummy_c = [&]() {
+          std::optional<t_cell> dummy_c;
+          if constexpr(count_ptr) {
+            dummy_c.emplace(*this, t);
+            dummy_c->m_count = 9001;
+          }
+          t_cell_ptr dummy([&]() {
             if constexpr(count_ptr) {
-              return t_cell(*this, t);
+              return &(*dummy_c);
             } else {
-              return t_cell(t);
+              return &t;
             }
-          }();
-          if constexpr(count_ptr) {
-            dummy_c.m_count = 9001;
-          }
-          t_cell_ptr dummy(&dummy_c);
+          }());
           // static_assert(std::is_same_v<typename value_type_wrap::t_hash, typename t_content::hasher>);
           // static_assert(std::is_same_v<typename value_type_wrap::t_eq, typename t_content::key_equal>);
           // std::cout << "registry_unique::add() -> " << std::boolalpha << (this->m_content.find(t) != this->m_content.end()) << std::endl;
@@ -704,23 +1107,45 @@ namespace hrw {
 
         const_iterator begin() { return ref_struct::make_iterator(this->m_content.cbegin()); }
         const_iterator end() { return ref_struct::make_iterator(this->m_content.cend()); }
+        size_type size() const { return this->m_content.size(); }
 
 
         void clear() noexcept {
-          using traits_t = std::allocator_traits<allocator_type>;
-          for(auto& cell: this->m_content) {
-            traits_t::destroy(this->m_alloc, cell.m_ptr);
-            traits_t::deallocate(this->m_alloc, cell.m_ptr, 1);
+          if constexpr(count_ptr) {
+            using traits_t = std::allocator_traits<allocator_type>;
+            for(auto& cell: this->m_content) {
+              traits_t::destroy(this->m_alloc, cell.m_ptr);
+              traits_t::deallocate(this->m_alloc, cell.m_ptr, 1);
+            }
+            this->m_content.clear();
+          } else {
+            this->m_content.clear(); // the cells own their value
           }
-          this->m_content.clear();
+          allocator_release<Allocator>::run();
         }
 
         template<bool b=count_ptr, std::enable_if_t<b, bool> = true>
         void clear(t_ptr& ref) {
+          this->on_release(ref.get_ptr());
           this->m_content.erase(ref);          
           // ref.destroy_value();
         }
 
+        // removes all the values v for which is_alive(v) is false, returns the number of removed values
+        template<typename F, bool b=!count_ptr, std::enable_if_t<b, bool> = true>
+        size_type collect(F&& is_alive) {
+          size_type res = 0;
+          for(auto it = this->m_content.begin(); it != this->m_content.end();) {
+            if(is_alive(*(it->get_ptr()))) {
+              ++it;
+            } else {
+              it = this->m_content.erase(it); // the cell owns its value
+              ++res;
+            }
+          }
+          return res;
+        }
+
       private:
         t_content m_content;
         allocator_type m_alloc;
@@ -778,6 +1203,355 @@ namespace hrw {
 
 
 
+    /////////////////////////////////////////////////////////////////////////////
+    // CONCURRENT REGISTERY
+    /////////////////////////////////////////////////////////////////////////////
+
+    // unique registry that can be used from several threads at the same time: the values are distributed in nb_shards sets,
+    // each protected by its own mutex, so that the lookup and the insertion of a value are atomic.
+    // References are plain pointers without reference counting: values are only removed with clear, which, like iteration, must not run concurrently with add
+
+    template<template<typename ... Args> typename tt_set, std::size_t nb_shards=64>
+    struct registry_concurrent {
+      static_assert(nb_shards > 0);
+
+      template<
+        typename T,
+        typename Hash = std::hash<T>,
+        typename KeyEqual = std::equal_to<T>,
+        template<typename> typename Allocator = std::allocator
+      > struct make_ref {
+        using type = make_ref<T, Hash, KeyEqual, Allocator>;
+
+        using value_type  = T;
+        using value_const = const value_type;
+        using value_hash  = Hash;
+        using value_equal = KeyEqual;
+        using value_allocator = Allocator<value_type>;
+
+        using ptr_type = value_const *;
+        using ptr_const = std::add_const_t<ptr_type>;
+        using ptr_hash = hash_mixed<value_const *>;
+        using ptr_equal = std::equal_to<value_const *>;
+
+        static inline constexpr value_const * to_ptr(ptr_const& v) { return v; }
+      };
+
+      static inline constexpr bool ensure_unique_v = true;
+      static inline constexpr bool ref_counting = false;
+
+      template<
+        typename T,
+        typename Hash = std::hash<T>,
+        typename KeyEqual = std::equal_to<T>,
+        template<typename> typename Allocator = std::allocator
+      > class make {
+      public:
+        using type = make<T, Hash, KeyEqual, Allocator>;
+        using value_type = T;
+
+        using ref_struct = make_ref<T, Hash, KeyEqual, Allocator>;
+        using t_ptr  = typename ref_struct::ptr_type;
+
+        using t_content = tt_set<value_type, Hash, KeyEqual, Allocator<value_type>>;
+        using size_type = std::size_t;
+
+        static inline constexpr bool safe_reference = true;
+        static inline constexpr bool ref_counting = false;
+
+        class const_iterator {
+        public:
+          using iterator_category = std::forward_iterator_tag;
+          using value_type = typename ref_struct::value_const;
+          using difference_type = std::ptrdiff_t;
+          using pointer = value_type*;
+          using reference = value_type&;
+
+          const_iterator(const type& reg, std::size_t shard): m_reg(&reg), m_shard(shard), m_it() {
+            if(this->m_shard < nb_shards) {
+              this->m_it = this->m_reg->m_shards[this->m_shard].m_content.cbegin();
+              this->skip();
+            }
+          }
+
+          const_iterator& operator++() { ++this->m_it; this->skip(); return *this; }
+          reference operator*() const { return *this->m_it; }
+          pointer operator->() const { return &(*this->m_it); }
+          friend bool operator==(const const_iterator& it1, const const_iterator& it2) { return (it1.m_shard == it2.m_shard) && ((it1.m_shard == nb_shards) || (it1.m_it == it2.m_it)); }
+          friend bool operator!=(const const_iterator& it1, const const_iterator& it2) { return !(it1 == it2); }
+
+        private:
+          const type* m_reg;
+          std::size_t m_shard;
+          typename t_content::const_iterator m_it;
+
+          // moves to the next value, possibly in a following shard
+          void skip() {
+            while(this->m_it == this->m_reg->m_shards[this->m_shard].m_content.cend()) {
+              if((++this->m_shard) == nb_shards) { return; }
+              this->m_it = this->m_reg->m_shards[this->m_shard].m_content.cbegin();
+            }
+          }
+        };
+
+        //////////////////////////////////////////
+        // constructors / destructors
+        make(): m_shards() {}
+        make(const type&) = delete;
+
+        //////////////////////////////////////////
+        // api
+        t_ptr add(value_type&& t) {
+          t_shard& shard = this->m_shards[type::shard_index(Hash()(t))];
+          std::lock_guard<std::mutex> lock(shard.m_mutex);
+          auto it = shard.m_content.find(t);
+          if(it == shard.m_content.end()) {
+            it = shard.m_content.emplace(std::move(t)).first;
+          }
+          return &(*it);
+        }
+
+        const_iterator begin() const { return const_iterator(*this, 0); }
+        const_iterator end() const { return const_iterator(*this, nb_shards); }
+
+        size_type size() const {
+          size_type res = 0;
+          for(const t_shard& shard: this->m_shards) {
+            std::lock_guard<std::mutex> lock(shard.m_mutex);
+            res += shard.m_content.size();
+          }
+          return res;
+        }
+
+        void clear() noexcept {
+          for(t_shard& shard: this->m_shards) {
+            std::lock_guard<std::mutex> lock(shard.m_mutex);
+            shard.m_content.clear();
+          }
+        }
+
+      private:
+        struct alignas(64) t_shard {
+          mutable std::mutex m_mutex;
+          t_content m_content;
+        };
+
+        // the low bits of the hash are also used by the shard's buckets
+        static std::size_t shard_index(std::size_t h) { return (h ^ (h >> 29) ^ (h >> 47)) % nb_shards; }
+
+        std::array<t_shard, nb_shards> m_shards;
+      };
+    };
+
+
+
+    /////////////////////////////////////////////////////////////////////////////
+    // ARENA REGISTERY
+    /////////////////////////////////////////////////////////////////////////////
+
+    // values are stored in chunks of 2^chunk_bits cells that are never moved: a value is identified by its 32-bit index in the store.
+    // There is one store per value type, so that a reference can be resolved without a pointer to its registry
+    template<typename T, template<typename> typename Allocator=std::allocator, unsigned int chunk_bits=12>
+    class arena_store {
+    public:
+      using type = arena_store<T, Allocator, chunk_bits>;
+      using value_type = T;
+      using index_type = std::uint32_t;
+      using t_cell = std::aligned_storage_t<sizeof(T), alignof(T)>;
+      using allocator_type = Allocator<t_cell>;
+
+      static inline constexpr index_type chunk_size = index_type(1) << chunk_bits;
+      static inline constexpr index_type chunk_mask = chunk_size - 1;
+      static inline constexpr index_type null_index = std::numeric_limits<index_type>::max();
+
+      static type& instance() {
+        static type res;
+        return res;
+      }
+
+      arena_store(): m_chunks(), m_size(0), m_users(0), m_alloc() {}
+      arena_store(const type&) = delete;
+      ~arena_store() { this->clear(); }
+
+      index_type emplace(value_type&& v) {
+        if(this->m_size == null_index) {
+          throw hrw::exception::arena_full();
+        }
+        if((this->m_size >> chunk_bits) == this->m_chunks.size()) {
+          this->m_chunks.push_back(traits_t::allocate(this->m_alloc, chunk_size));
+        }
+        ::new(static_cast<void*>(this->cell(this->m_size))) value_type(std::move(v));
+        return this->m_size++;
+      }
+
+      // removes the last value, used when a value is already present in a registry
+      void pop_back() {
+        --this->m_size;
+        this->get_ptr(this->m_size)->~value_type();
+      }
+
+      value_type* get_ptr(index_type i) { return std::launder(reinterpret_cast<value_type*>(this->cell(i))); }
+      index_type size() const { return this->m_size; }
+
+      void clear() {
+        for(index_type i = 0; i < this->m_size; ++i) {
+          this->get_ptr(i)->~value_type();
+        }
+        for(t_cell* chunk: this->m_chunks) {
+          traits_t::deallocate(this->m_alloc, chunk, chunk_size);
+        }
+        this->m_chunks.clear();
+        this->m_size = 0;
+      }
+
+      // number of registries currently using the store
+      unsigned int& users() { return this->m_users; }
+
+    private:
+      using traits_t = std::allocator_traits<allocator_type>;
+      t_cell* cell(index_type i) { return this->m_chunks[i >> chunk_bits] + (i & chunk_mask); }
+
+      std::vector<t_cell*> m_chunks;
+      index_type m_size;
+      unsigned int m_users;
+      allocator_type m_alloc;
+    };
+
+
+    template<typename T, typename t_store>
+    class t_arena_ptr {
+    public:
+      using type = t_arena_ptr<T, t_store>;
+      using value_type = T;
+      using value_const = std::add_const_t<value_type>;
+      using value_const_ptr = value_const*;
+      using element_type = value_const;
+      using index_type = std::uint32_t;
+
+      t_arena_ptr(): m_id(t_store::null_index) {}
+      explicit t_arena_ptr(index_type id): m_id(id) {}
+
+      value_const& operator*() const { return *this->get_ptr(); }
+      value_const& get()       const { return *this->get_ptr(); }
+      value_const_ptr operator->() const { return this->get_ptr(); }
+      value_const_ptr get_ptr()    const { return t_store::instance().get_ptr(this->m_id); }
+
+      index_type id() const { return this->m_id; }
+
+      friend bool operator==(type const & c1, type const & c2) { return c1.m_id == c2.m_id; }
+      friend bool operator!=(type const & c1, type const & c2) { return c1.m_id != c2.m_id; }
+
+      struct t_hash {
+        hrw::utils::hash_value operator()(const type& t) const { return std::hash<index_type>()(t.m_id); }
+      };
+
+    private:
+      index_type m_id;
+    };
+
+
+    // unique registry storing its values in an arena_store: references are 32-bit indices instead of pointers.
+    // The values are only destroyed when the last registry of their type is cleared or destroyed.
+    template<template<typename ... Args> typename tt_set>
+    struct registry_arena {
+
+      template<
+        typename T,
+        typename Hash = std::hash<T>,
+        typename KeyEqual = std::equal_to<T>,
+        template<typename> typename Allocator = std::allocator
+      > struct make_ref {
+        using type = make_ref<T, Hash, KeyEqual, Allocator>;
+
+        using value_type  = T;
+        using value_const = const value_type;
+        using value_hash  = Hash;
+        using value_equal = KeyEqual;
+        using value_allocator = Allocator<value_type>;
+
+        using t_store = arena_store<value_type, Allocator>;
+
+        using ptr_type = t_arena_ptr<value_type, t_store>;
+        using ptr_const = std::add_const_t<ptr_type>;
+        using ptr_hash = typename ptr_type::t_hash;
+        using ptr_equal = std::equal_to<ptr_type>;
+
+        static inline value_const * to_ptr(ptr_const& v) { return v.get_ptr(); }
+      };
+
+      static inline constexpr bool ensure_unique_v = true;
+      static inline constexpr bool ref_counting = false;
+
+      template<
+        typename T,
+        typename Hash = std::hash<T>,
+        typename KeyEqual = std::equal_to<T>,
+        template<typename> typename Allocator = std::allocator
+      > class make {
+      public:
+        using type = make<T, Hash, KeyEqual, Allocator>;
+        using value_type = T;
+
+        using ref_struct = make_ref<T, Hash, KeyEqual, Allocator>;
+        using t_store = typename ref_struct::t_store;
+        using t_ptr  = typename ref_struct::ptr_type;
+
+        struct hasher {
+          hrw::utils::hash_value operator()(const t_ptr& t) const { return Hash()(*t); }
+        };
+        struct key_equal {
+          bool operator()(const t_ptr& lhs, const t_ptr& rhs) const { return (lhs == rhs) || KeyEqual()(*lhs, *rhs); }
+        };
+
+        using t_content = tt_set<t_ptr, hasher, key_equal>;
+        using size_type = typename t_content::size_type;
+
+        using const_iterator = iterator_wrapper<typename t_content::const_iterator>;
+
+        static inline constexpr bool safe_reference = true;
+        static inline constexpr bool ref_counting = false;
+
+        //////////////////////////////////////////
+        // constructors / destructors
+        make(): m_content() { ++t_store::instance().users(); }
+        make(const type&) = delete;
+        ~make() {
+          this->m_content.clear();
+          if((--t_store::instance().users()) == 0) {
+            t_store::instance().clear();
+          }
+        }
+
+        //////////////////////////////////////////
+        // api
+        t_ptr add(value_type&& t) {
+          t_store& store = t_store::instance();
+          t_ptr res(store.emplace(std::move(t)));
+          auto it = this->m_content.insert(res);
+          if(!it.second) {
+            store.pop_back();
+          }
+          return *(it.first);
+        }
+
+        const_iterator begin() { return const_iterator(this->m_content.cbegin()); }
+        const_iterator end() { return const_iterator(this->m_content.cend()); }
+        size_type size() const { return this->m_content.size(); }
+
+        void clear() noexcept {
+          this->m_content.clear();
+          if(t_store::instance().users() == 1) {
+            t_store::instance().clear();
+          }
+        }
+
+      private:
+        t_content m_content;
+      };
+    };
+
+
+
     // the fact that the registry stores const values has effect on the type of iterators! because the content of the iterator is const
     template<typename R> struct is_make_ref_const {
       using t_ptr = typename R::ptr_type;
@@ -821,6 +1595,12 @@ namespace hrw {
     template<typename R> constexpr bool is_registry_const_v = is_registry_const<R>::value;
 
 
+    // a registry (the make class) is collectable when it can remove its values that are not reachable anymore
+    template<typename R, typename=void> struct is_registry_collectable: public std::false_type {};
+    template<typename R> struct is_registry_collectable<R, std::enable_if_t<R::collectable>>: public std::true_type {};
+    template<typename R> constexpr bool is_registry_collectable_v = is_registry_collectable<R>::value;
+
+
   }
 }
 
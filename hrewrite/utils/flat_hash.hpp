@@ -0,0 +1,444 @@
+/*
+ * This file is part of the hrewrite library.
+ * Copyright (c) 2021 ONERA.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+ // Author: Michael Lienhardt
+ // Maintainer: Michael Lienhardt
+ // email: michael.lienhardt@onera.fr
+
+
+
+#ifndef __HREWRITE_UTILS_FLAT_HASH_H__
+#define __HREWRITE_UTILS_FLAT_HASH_H__
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <utility>
+#include <functional>
+#include <iterator>
+#include <type_traits>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+
+namespace hrw {
+  namespace utils {
+
+    /////////////////////////////////////////////////////////////////////////////
+    // 1. CONTROL BYTES
+    /////////////////////////////////////////////////////////////////////////////
+
+    // open addressing table in the style of swiss tables: every slot has a control byte, which is either empty, deleted,
+    // or the 7 low bits of the hash of its value. Slots are probed by groups of 16, whose control bytes are compared in one go
+
+    namespace _flat_hash_detail {
+      using t_ctrl = std::int8_t;
+      static inline constexpr t_ctrl ctrl_empty   = -128; // 0b10000000
+      static inline constexpr t_ctrl ctrl_deleted = -2;   // 0b11111110
+      static inline constexpr std::size_t group_size = 16;
+
+      inline bool is_full(t_ctrl c) { return c >= 0; }
+
+      // spreads the bits of the hash, as std::hash is the identity on integers and pointers
+      inline std::size_t mix(std::size_t h) {
+        std::uint64_t res = static_cast<std::uint64_t>(h) * 0x9e3779b97f4a7c15ull;
+        return static_cast<std::size_t>(res ^ (res >> 32));
+      }
+      inline t_ctrl h2(std::size_t h) { return static_cast<t_ctrl>(h & 0x7f); }
+      inline std::size_t h1(std::size_t h) { return h >> 7; }
+
+      inline unsigned int ctz(std::uint32_t v) {
+#if defined(__GNUC__) || defined(__clang__)
+        return static_cast<unsigned int>(__builtin_ctz(v));
+#else
+        unsigned int res = 0;
+        while((v & 1u) == 0) { v >>= 1; ++res; }
+        return res;
+#endif
+      }
+
+      // the control bytes of a group, with bitmasks of the slots matching a given criteria
+      class t_group {
+      public:
+        explicit t_group(const t_ctrl* pos) {
+#if defined(__SSE2__)
+          this->m_ctrl = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pos));
+#else
+          std::memcpy(this->m_ctrl, pos, group_size);
+#endif
+        }
+
+        std::uint32_t match(t_ctrl h) const {
+#if defined(__SSE2__)
+          return static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h), this->m_ctrl)));
+#else
+          std::uint32_t res = 0;
+          for(std::size_t i = 0; i < group_size; ++i) { res |= std::uint32_t(this->m_ctrl[i] == h) << i; }
+          return res;
+#endif
+        }
+        std::uint32_t match_empty() const { return this->match(ctrl_empty); }
+        std::uint32_t match_free() const { // empty or deleted
+#if defined(__SSE2__)
+          return static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_set1_epi8(-1), this->m_ctrl)));
+#else
+          std::uint32_t res = 0;
+          for(std::size_t i = 0; i < group_size; ++i) { res |= std::uint32_t(this->m_ctrl[i] < -1) << i; }
+          return res;
+#endif
+        }
+
+      private:
+#if defined(__SSE2__)
+        __m128i m_ctrl;
+#else
+        t_ctrl m_ctrl[group_size];
+#endif
+      };
+
+
+      /////////////////////////////////////////////////////////////////////////////
+      // 2. GENERIC TABLE
+      /////////////////////////////////////////////////////////////////////////////
+
+      // KeyOf extracts the key from a stored value. The capacity is a power of 2, at least group_size, and the table is at most 7/8 full.
+      // Values are moved when the table grows: references and iterators are invalidated by insertions
+      template<typename Value, typename Key, typename KeyOf, typename Hash, typename KeyEqual, typename Allocator>
+      class t_table {
+      public:
+        using type = t_table<Value, Key, KeyOf, Hash, KeyEqual, Allocator>;
+        using key_type = Key;
+        using value_type = Value;
+        using size_type = std::size_t;
+        using difference_type = std::ptrdiff_t;
+        using hasher = Hash;
+        using key_equal = KeyEqual;
+        using allocator_type = typename std::allocator_traits<Allocator>::template rebind_alloc<value_type>;
+        using reference = value_type&;
+        using const_reference = const value_type&;
+
+        template<bool is_const>
+        class tt_iterator {
+        public:
+          using iterator_category = std::forward_iterator_tag;
+          using value_type = std::conditional_t<is_const, const Value, Value>;
+          using difference_type = std::ptrdiff_t;
+          using pointer = value_type*;
+          using reference = value_type&;
+
+          tt_iterator(): m_ctrl(nullptr), m_slot(nullptr), m_end(nullptr) {}
+          tt_iterator(const t_ctrl* ctrl, Value* slot, const t_ctrl* end): m_ctrl(ctrl), m_slot(slot), m_end(end) { this->skip(); }
+          template<bool b=is_const, std::enable_if_t<b, bool> = true>
+          tt_iterator(const tt_iterator<false>& it): m_ctrl(it.m_ctrl), m_slot(it.m_slot), m_end(it.m_end) {}
+
+          reference operator*() const { return *this->m_slot; }
+          pointer operator->() const { return this->m_slot; }
+          tt_iterator& operator++() { ++this->m_ctrl; ++this->m_slot; this->skip(); return *this; }
+          tt_iterator operator++(int) { tt_iterator res(*this); ++(*this); return res; }
+
+          friend bool operator==(const tt_iterator& it1, const tt_iterator& it2) { return it1.m_slot == it2.m_slot; }
+          friend bool operator!=(const tt_iterator& it1, const tt_iterator& it2) { return it1.m_slot != it2.m_slot; }
+
+        private:
+          friend class t_table;
+          template<bool> friend class tt_iterator;
+          const t_ctrl* m_ctrl;
+          Value* m_slot;
+          const t_ctrl* m_end;
+
+          void skip() {
+            while((this->m_ctrl != this->m_end) && (!is_full(*this->m_ctrl))) { ++this->m_ctrl; ++this->m_slot; }
+          }
+        };
+
+        using iterator = tt_iterator<false>;
+        using const_iterator = tt_iterator<true>;
+
+        //////////////////////////////////////////
+        // constructors / destructors
+        t_table(): t_table(0) {}
+        explicit t_table(size_type count, const hasher& h=hasher(), const key_equal& k=key_equal(), const allocator_type& a=allocator_type()):
+          m_ctrl(nullptr), m_slots(nullptr), m_capacity(0), m_size(0), m_growth_left(0), m_hash(h), m_eq(k), m_alloc(a) {
+          if(count > 0) { this->rehash(count); }
+        }
+        t_table(const type& t): t_table(t.m_size, t.m_hash, t.m_eq, t.m_alloc) {
+          for(const_reference v: t) { this->insert_unique(v); }
+        }
+        t_table(type&& t): m_ctrl(t.m_ctrl), m_slots(t.m_slots), m_capacity(t.m_capacity), m_size(t.m_size), m_growth_left(t.m_growth_left),
+          m_hash(std::move(t.m_hash)), m_eq(std::move(t.m_eq)), m_alloc(std::move(t.m_alloc)) {
+          t.m_ctrl = nullptr; t.m_slots = nullptr; t.m_capacity = 0; t.m_size = 0; t.m_growth_left = 0;
+        }
+        ~t_table() { this->release(); }
+
+        type& operator=(type t) {
+          this->swap(t);
+          return *this;
+        }
+
+        //////////////////////////////////////////
+        // iteration
+        iterator begin() { return iterator(this->m_ctrl, this->m_slots, this->m_ctrl + this->m_capacity); }
+        iterator end() { return iterator(this->m_ctrl + this->m_capacity, this->m_slots + this->m_capacity, this->m_ctrl + this->m_capacity); }
+        const_iterator begin() const { return const_iterator(this->m_ctrl, this->m_slots, this->m_ctrl + this->m_capacity); }
+        const_iterator end() const { return const_iterator(this->m_ctrl + this->m_capacity, this->m_slots + this->m_capacity, this->m_ctrl + this->m_capacity); }
+        const_iterator cbegin() const { return this->begin(); }
+        const_iterator cend() const { return this->end(); }
+
+        size_type size() const { return this->m_size; }
+        bool empty() const { return this->m_size == 0; }
+        size_type bucket_count() const { return this->m_capacity; }
+
+        //////////////////////////////////////////
+        // lookup
+        iterator find(const key_type& k) {
+          Value* res = this->find_slot(k, mix(this->m_hash(k)));
+          return (res == nullptr)?this->end():this->iterator_at(res);
+        }
+        const_iterator find(const key_type& k) const {
+          Value* res = this->find_slot(k, mix(this->m_hash(k)));
+          return (res == nullptr)?this->end():const_iterator(this->iterator_at(res));
+        }
+        size_type count(const key_type& k) const { return (this->find_slot(k, mix(this->m_hash(k))) == nullptr)?0:1; }
+        bool contains(const key_type& k) const { return this->count(k) == 1; }
+
+        //////////////////////////////////////////
+        // modification
+        std::pair<iterator, bool> insert(const value_type& v) { return this->insert_value(value_type(v)); }
+        std::pair<iterator, bool> insert(value_type&& v) { return this->insert_value(std::move(v)); }
+
+        template<typename ... Args>
+        std::pair<iterator, bool> emplace(Args&& ... args) { return this->insert_value(value_type(std::forward<Args>(args)...)); }
+
+        size_type erase(const key_type& k) {
+          Value* slot = this->find_slot(k, mix(this->m_hash(k)));
+          if(slot == nullptr) { return 0; }
+          this->erase_slot(static_cast<size_type>(slot - this->m_slots));
+          return 1;
+        }
+        iterator erase(const_iterator it) {
+          size_type i = static_cast<size_type>(it.m_slot - this->m_slots);
+          this->erase_slot(i);
+          return iterator(this->m_ctrl + i + 1, this->m_slots + i + 1, this->m_ctrl + this->m_capacity);
+        }
+
+        void clear() noexcept {
+          if(this->m_capacity == 0) { return; }
+          this->destroy_values();
+          std::memset(this->m_ctrl, ctrl_empty, this->m_capacity);
+          this->m_size = 0;
+          this->m_growth_left = type::max_load(this->m_capacity);
+        }
+
+        void reserve(size_type n) {
+          if(n > type::max_load(this->m_capacity)) { this->rehash(n); }
+        }
+
+        void swap(type& t) {
+          using std::swap;
+          swap(this->m_ctrl, t.m_ctrl);
+          swap(this->m_slots, t.m_slots);
+          swap(this->m_capacity, t.m_capacity);
+          swap(this->m_size, t.m_size);
+          swap(this->m_growth_left, t.m_growth_left);
+          swap(this->m_hash, t.m_hash);
+          swap(this->m_eq, t.m_eq);
+          swap(this->m_alloc, t.m_alloc);
+        }
+        friend void swap(type& t1, type& t2) { t1.swap(t2); }
+
+      private:
+        using traits_t = std::allocator_traits<allocator_type>;
+        using ctrl_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<t_ctrl>;
+        using ctrl_traits_t = std::allocator_traits<ctrl_allocator>;
+
+        t_ctrl* m_ctrl;
+        Value* m_slots;
+        size_type m_capacity;
+        size_type m_size;
+        size_type m_growth_left; // number of insertions in empty slots before a rehash
+        hasher m_hash;
+        key_equal m_eq;
+        allocator_type m_alloc;
+
+        static size_type max_load(size_type capacity) { return capacity - capacity / 8; }
+
+        iterator iterator_at(Value* slot) const {
+          size_type i = static_cast<size_type>(slot - this->m_slots);
+          return iterator(this->m_ctrl + i, slot, this->m_ctrl + this->m_capacity);
+        }
+
+        // the probe sequence goes through the groups with a triangular progression, which covers all groups as their number is a power of 2
+        Value* find_slot(const key_type& k, std::size_t h) const {
+          if(this->m_capacity == 0) { return nullptr; }
+          const size_type mask = (this->m_capacity / group_size) - 1;
+          size_type g = h1(h) & mask;
+          const t_ctrl c = h2(h);
+          for(size_type step = 1; ; ++step) {
+            t_group group(this->m_ctrl + g * group_size);
+            for(std::uint32_t m = group.match(c); m != 0; m &= (m - 1)) {
+              Value* slot = this->m_slots + g * group_size + ctz(m);
+              if(this->m_eq(KeyOf()(*slot), k)) { return slot; }
+            }
+            if(group.match_empty() != 0) { return nullptr; }
+            g = (g + step) & mask;
+          }
+        }
+
+        size_type find_free(std::size_t h) const {
+          const size_type mask = (this->m_capacity / group_size) - 1;
+          size_type g = h1(h) & mask;
+          for(size_type step = 1; ; ++step) {
+            std::uint32_t m = t_group(this->m_ctrl + g * group_size).match_free();
+            if(m != 0) { return g * group_size + ctz(m); }
+            g = (g + step) & mask;
+          }
+        }
+
+        std::pair<iterator, bool> insert_value(value_type&& v) {
+          const std::size_t h = mix(this->m_hash(KeyOf()(v)));
+          Value* slot = this->find_slot(KeyOf()(v), h);
+          if(slot != nullptr) { return std::make_pair(this->iterator_at(slot), false); }
+          if(this->m_growth_left == 0) {
+            this->rehash(2 * (this->m_size + 1));
+          }
+          size_type i = this->find_free(h);
+          if(this->m_ctrl[i] == ctrl_empty) { --this->m_growth_left; }
+          traits_t::construct(this->m_alloc, this->m_slots + i, std::move(v));
+          this->m_ctrl[i] = h2(h);
+          ++this->m_size;
+          return std::make_pair(this->iterator_at(this->m_slots + i), true);
+        }
+
+        // v is known to not be in the table, which has enough room
+        void insert_unique(const value_type& v) {
+          const std::size_t h = mix(this->m_hash(KeyOf()(v)));
+          size_type i = this->find_free(h);
+          --this->m_growth_left;
+          traits_t::construct(this->m_alloc, this->m_slots + i, v);
+          this->m_ctrl[i] = h2(h);
+          ++this->m_size;
+        }
+
+        void erase_slot(size_type i) {
+          traits_t::destroy(this->m_alloc, this->m_slots + i);
+          // a group with an empty slot ends all the probe sequences going through it, so the slot can be emptied
+          const size_type g = i / group_size;
+          if(t_group(this->m_ctrl + g * group_size).match_empty() != 0) {
+            this->m_ctrl[i] = ctrl_empty;
+            ++this->m_growth_left;
+          } else {
+            this->m_ctrl[i] = ctrl_deleted;
+          }
+          --this->m_size;
+        }
+
+        // the new capacity holds at least n values
+        void rehash(size_type n) {
+          size_type capacity = group_size;
+          while(type::max_load(capacity) < n) { capacity *= 2; }
+
+          t_ctrl* old_ctrl = this->m_ctrl;
+          Value* old_slots = this->m_slots;
+          size_type old_capacity = this->m_capacity;
+
+          ctrl_allocator ctrl_alloc(this->m_alloc);
+          this->m_ctrl = ctrl_traits_t::allocate(ctrl_alloc, capacity);
+          std::memset(this->m_ctrl, ctrl_empty, capacity);
+          this->m_slots = traits_t::allocate(this->m_alloc, capacity);
+          this->m_capacity = capacity;
+          this->m_growth_left = type::max_load(capacity) - this->m_size;
+
+          for(size_type i = 0; i < old_capacity; ++i) {
+            if(is_full(old_ctrl[i])) {
+              const std::size_t h = mix(this->m_hash(KeyOf()(old_slots[i])));
+              size_type j = this->find_free(h);
+              traits_t::construct(this->m_alloc, this->m_slots + j, std::move(old_slots[i]));
+              traits_t::destroy(this->m_alloc, old_slots + i);
+              this->m_ctrl[j] = h2(h);
+            }
+          }
+          if(old_capacity > 0) {
+            ctrl_traits_t::deallocate(ctrl_alloc, old_ctrl, old_capacity);
+            traits_t::deallocate(this->m_alloc, old_slots, old_capacity);
+          }
+        }
+
+        void destroy_values() {
+          for(size_type i = 0; i < this->m_capacity; ++i) {
+            if(is_full(this->m_ctrl[i])) { traits_t::destroy(this->m_alloc, this->m_slots + i); }
+          }
+        }
+
+        void release() {
+          if(this->m_capacity > 0) {
+            this->destroy_values();
+            ctrl_allocator ctrl_alloc(this->m_alloc);
+            ctrl_traits_t::deallocate(ctrl_alloc, this->m_ctrl, this->m_capacity);
+            traits_t::deallocate(this->m_alloc, this->m_slots, this->m_capacity);
+          }
+        }
+      };
+
+      struct t_key_of_set {
+        template<typename T> const T& operator()(const T& v) const { return v; }
+      };
+      struct t_key_of_map {
+        template<typename P> const typename P::first_type& operator()(const P& v) const { return v.first; }
+      };
+    }
+
+
+    /////////////////////////////////////////////////////////////////////////////
+    // 3. SET AND MAP
+    /////////////////////////////////////////////////////////////////////////////
+
+    // drop-in replacements of std::unordered_set and std::unordered_map for the tt_set and targ_map parameters.
+    // As values move when the table grows, the set can only be used by the registries that do not reference their cells
+    // (registry_unique<tt_set, false> and registry_arena)
+
+    template<typename Key, typename Hash=std::hash<Key>, typename KeyEqual=std::equal_to<Key>, typename Allocator=std::allocator<Key>>
+    class flat_hash_set: public _flat_hash_detail::t_table<Key, Key, _flat_hash_detail::t_key_of_set, Hash, KeyEqual, Allocator> {
+      using t_base = _flat_hash_detail::t_table<Key, Key, _flat_hash_detail::t_key_of_set, Hash, KeyEqual, Allocator>;
+    public:
+      using t_base::t_base;
+    };
+
+    template<typename Key, typename T, typename Hash=std::hash<Key>, typename KeyEqual=std::equal_to<Key>, typename Allocator=std::allocator<std::pair<const Key, T>>>
+    class flat_hash_map: public _flat_hash_detail::t_table<std::pair<const Key, T>, Key, _flat_hash_detail::t_key_of_map, Hash, KeyEqual, Allocator> {
+      using t_base = _flat_hash_detail::t_table<std::pair<const Key, T>, Key, _flat_hash_detail::t_key_of_map, Hash, KeyEqual, Allocator>;
+    public:
+      using mapped_type = T;
+      using t_base::t_base;
+
+      T& operator[](const Key& k) {
+        auto it = this->find(k);
+        if(it == this->end()) {
+          it = this->emplace(k, T()).first;
+        }
+        return it->second;
+      }
+      T& at(const Key& k) { return this->find(k)->second; }
+      const T& at(const Key& k) const { return this->find(k)->second; }
+    };
+
+  }
+}
+
+
+#endif // __HREWRITE_UTILS_FLAT_HASH_H__
@@ -22,6 +22,7 @@
 #ifndef __HREWRITE_UTILS_HASH_H__
 #define __HREWRITE_UTILS_HASH_H__
 
+#include <cstdint>
 #include <vector>
 #include <tuple>
 #include <variant>
@@ -35,6 +36,37 @@
 namespace hrw {
   namespace utils {
 
+    //////////////////////////////////////////
+    // mixing function
+
+    // multiply-xorshift finaliser of murmur3: spreads the bits of integers and pointers, on which std::hash is usually the identity
+    inline constexpr std::size_t hash_mix(std::size_t h) {
+      if constexpr(sizeof(std::size_t) >= 8) {
+        std::uint64_t x = h;
+        x ^= x >> 33;
+        x *= 0xff51afd7ed558ccdull;
+        x ^= x >> 33;
+        x *= 0xc4ceb9fe1a85ec53ull;
+        x ^= x >> 33;
+        return static_cast<std::size_t>(x);
+      } else {
+        std::uint32_t x = static_cast<std::uint32_t>(h);
+        x ^= x >> 16;
+        x *= 0x85ebca6bu;
+        x ^= x >> 13;
+        x *= 0xc2b2ae35u;
+        x ^= x >> 16;
+        return static_cast<std::size_t>(x);
+      }
+    }
+
+    // hash of integers and pointers, with mixed bits
+    template<typename T>
+    struct hash_mixed {
+      std::size_t operator()(const T& v) const { return hash_mix(std::hash<T>()(v)); }
+    };
+
+
     //////////////////////////////////////////
     // hash value with combine operator
 
@@ -46,7 +78,7 @@ namespace hrw {
       operator size_t() const { return this->m_content; }
 
       hash_value& operator<<(std::size_t s) {
-        this->m_content ^= s + 0x9e3779b9 + (this->m_content<<6) + (this->m_content>>2);
+        this->m_content = hash_mix(this->m_content ^ (s + static_cast<std::size_t>(0x9e3779b97f4a7c15ull)));
         return *this;
       }
       hash_value& operator<<(const hash_value& v) { return (*this) << v.m_content; }
@@ -273,6 +305,7 @@ namespace hrw {
     template<typename T, bool=std::is_constructible_v<std::hash<T>>, bool=has_t_hash_v<T>> struct get_hash;
 
     template<typename T> struct get_hash<T, true, false> { using type = hash<T>; };
+    template<typename T> struct get_hash<T*, true, false> { using type = hash<T*, hash_mixed<T*>>; };
     template<typename T> struct get_hash<T, false, true> { using type = typename T::t_hash; };
     template<typename T> struct get_hash<T, true, true>: public get_hash<T, false, true> {};
 
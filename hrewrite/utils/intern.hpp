@@ -0,0 +1,104 @@
+/*
+ * This file is part of the hrewrite library.
+ * Copyright (c) 2021 ONERA.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+ // Author: Michael Lienhardt
+ // Maintainer: Michael Lienhardt
+ // email: michael.lienhardt@onera.fr
+
+
+#ifndef __HREWRITE_UTILS_INTERN_H__
+#define __HREWRITE_UTILS_INTERN_H__
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <unordered_map>
+
+#include "hrewrite/utils/hash.hpp"
+
+
+namespace hrw {
+  namespace utils {
+
+    // a string stored once in a global table: it is copied, hashed and compared as a pointer.
+    // The table is never shrunk, and is protected by a mutex so that strings can be interned concurrently
+    class interned_string {
+    public:
+      using type = interned_string;
+
+      interned_string(): m_ptr(type::intern(std::string_view())) {}
+      explicit interned_string(std::string_view s): m_ptr(type::intern(s)) {}
+      explicit interned_string(const char* s): m_ptr(type::intern(std::string_view(s))) {}
+      explicit interned_string(const std::string& s): m_ptr(type::intern(std::string_view(s))) {}
+
+      const std::string& str() const { return *this->m_ptr; }
+      std::size_t size() const { return this->m_ptr->size(); }
+
+      friend bool operator==(const type& l, const type& r) { return l.m_ptr == r.m_ptr; }
+      friend bool operator!=(const type& l, const type& r) { return l.m_ptr != r.m_ptr; }
+      friend bool operator<(const type& l, const type& r) { return (*l.m_ptr) < (*r.m_ptr); }
+      friend std::ostream& operator<<(std::ostream& os, const type& s) { return os << s.str(); }
+
+      struct t_hash {
+        std::size_t operator()(const type& s) const { return hash_mix(reinterpret_cast<std::uintptr_t>(s.m_ptr)); }
+      };
+
+      static std::size_t table_size() {
+        std::lock_guard<std::mutex> lock(type::table_mutex());
+        return type::table().size();
+      }
+
+    private:
+      const std::string* m_ptr;
+
+      // the keys are views on the strings owned by the values
+      using t_table = std::unordered_map<std::string_view, std::unique_ptr<const std::string>>;
+      static t_table& table() {
+        static t_table res;
+        return res;
+      }
+      static std::mutex& table_mutex() {
+        static std::mutex res;
+        return res;
+      }
+
+      static const std::string* intern(std::string_view s) {
+        std::lock_guard<std::mutex> lock(type::table_mutex());
+        auto it = type::table().find(s);
+        if(it == type::table().end()) {
+          auto value = std::make_unique<const std::string>(s);
+          std::string_view key(*value);
+          it = type::table().emplace(key, std::move(value)).first;
+        }
+        return it->second.get();
+      }
+    };
+
+  }
+}
+
+namespace std {
+  template<> struct hash<hrw::utils::interned_string> {
+    std::size_t operator()(const hrw::utils::interned_string& s) const { return hrw::utils::interned_string::t_hash()(s); }
+  };
+}
+
+
+#endif // __HREWRITE_UTILS_INTERN_H__
@@ -0,0 +1,103 @@
+/*
+ * This file is part of the hrewrite library.
+ * Copyright (c) 2021 ONERA.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+ // Author: Michael Lienhardt
+ // Maintainer: Michael Lienhardt
+ // email: michael.lienhardt@onera.fr
+
+
+#ifndef __HREWRITE_UTILS_MAPPED_FILE_H__
+#define __HREWRITE_UTILS_MAPPED_FILE_H__
+
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <string_view>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define HREWRITE_HAS_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "hrewrite/exceptions/common.hpp"
+
+
+namespace hrw {
+  namespace utils {
+
+    // the read-only content of a file. On POSIX systems, the file is mapped in memory and read sequentially by the kernel,
+    // so it is never copied; elsewhere, it is loaded in a string
+    class mapped_file {
+    public:
+      using type = mapped_file;
+
+      explicit mapped_file(const std::string& path): m_data(nullptr), m_size(0), m_buffer() {
+#ifdef HREWRITE_HAS_MMAP
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if(fd < 0) { type::fail(path); }
+        struct stat st;
+        if(::fstat(fd, &st) != 0) {
+          ::close(fd);
+          type::fail(path);
+        }
+        this->m_size = static_cast<std::size_t>(st.st_size);
+        if(this->m_size != 0) {
+          void* ptr = ::mmap(nullptr, this->m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+          ::close(fd);
+          if(ptr == MAP_FAILED) { type::fail(path); }
+          ::madvise(ptr, this->m_size, MADV_SEQUENTIAL);
+          this->m_data = static_cast<const char*>(ptr);
+        } else {
+          ::close(fd);
+        }
+#else
+        std::ifstream in(path, std::ios::binary);
+        if(!in) { type::fail(path); }
+        this->m_buffer.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        this->m_data = this->m_buffer.data();
+        this->m_size = this->m_buffer.size();
+#endif
+      }
+      mapped_file(const type&) = delete;
+      type& operator=(const type&) = delete;
+      ~mapped_file() {
+#ifdef HREWRITE_HAS_MMAP
+        if(this->m_size != 0) { ::munmap(const_cast<char*>(this->m_data), this->m_size); }
+#endif
+      }
+
+      std::string_view content() const { return std::string_view(this->m_data, this->m_size); }
+      std::size_t size() const { return this->m_size; }
+
+    private:
+      const char* m_data;
+      std::size_t m_size;
+      std::string m_buffer;
+
+      [[noreturn]] static void fail(const std::string& path) {
+        throw hrw::exception::generic("ERROR: cannot read the file \"" + path + "\"");
+      }
+    };
+
+  }
+}
+
+
+#endif // __HREWRITE_UTILS_MAPPED_FILE_H__
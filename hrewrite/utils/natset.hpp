@@ -25,7 +25,8 @@
 #include <iostream>
 #include <algorithm>
 #include <vector>
-#include <bitset>
+#include <array>
+#include <cstdint>
 #include <iterator>
 #include <sstream>
 
@@ -40,11 +41,53 @@ namespace hrw {
     namespace _natset_detail {
       using t_nat = unsigned int;
       using size_type = typename std::vector<bool>::size_type;
+      using t_word = std::uint64_t;
+
+      inline unsigned int ctz(t_word w) {
+      #if defined(__GNUC__) || defined(__clang__)
+        return static_cast<unsigned int>(__builtin_ctzll(w));
+      #else
+        unsigned int res = 0;
+        while(!(w & 1)) { w >>= 1; ++res; }
+        return res;
+      #endif
+      }
+
+      //////////////////////////////////////////
+      // loops on arrays of words: they are kept without branches, so the compiler can vectorise them
+
+      template<typename W> void words_or(W* res, const W* w, size_type n) {
+        for(size_type i = 0; i < n; ++i) { res[i] |= w[i]; }
+      }
+      template<typename W> void words_and(W* res, const W* w, size_type n) {
+        for(size_type i = 0; i < n; ++i) { res[i] &= w[i]; }
+      }
+      template<typename W> void words_or(W* res, const W* w1, const W* w2, size_type n) {
+        for(size_type i = 0; i < n; ++i) { res[i] = w1[i] | w2[i]; }
+      }
+      template<typename W> void words_and(W* res, const W* w1, const W* w2, size_type n) {
+        for(size_type i = 0; i < n; ++i) { res[i] = w1[i] & w2[i]; }
+      }
+      template<typename W> bool words_none(const W* w, size_type n) {
+        W acc = 0;
+        for(size_type i = 0; i < n; ++i) { acc |= w[i]; }
+        return acc == 0;
+      }
+      // true iff all the bits set in w2 are also set in w1
+      template<typename W> bool words_includes(const W* w1, const W* w2, size_type n) {
+        W acc = 0;
+        for(size_type i = 0; i < n; ++i) { acc |= static_cast<W>(w2[i] & ~w1[i]); }
+        return acc == 0;
+      }
+
 
-      template<typename arg_t_holder>
+      //////////////////////////////////////////
+      // iterator on the bits set in an array of words: skips empty words, and finds the next bit with ctz
+
+      template<typename W>
       class tt_iterator {
       public:
-        using type = tt_iterator<arg_t_holder>;
+        using type = tt_iterator<W>;
 
         using difference_type = void;
         using value_type = t_nat;
@@ -52,39 +95,45 @@ namespace hrw {
         using reference = value_type&;
         using iterator_category = std::input_iterator_tag;
 
-        using t_holder = arg_t_holder;
+        using t_cell = W;
+        static constexpr size_type s_cell = sizeof(W)*8;
 
-        tt_iterator(const t_holder& t, t_nat v): m_parent(t), m_i(v) {
-          if(this->m_i < this->m_parent.size()) {
-            if(!(this->m_parent[this->m_i])) {
-              ++(*this);
-            }
+        tt_iterator(const t_cell* content, size_type size, size_type i): m_content(content), m_size(size), m_i(i), m_cell(0) {
+          if(this->m_i < this->m_size) {
+            this->m_cell = this->m_content[this->m_i];
+            this->skip();
           }
         }
 
         tt_iterator& operator++() {
-          do {
-            ++this->m_i;
-            if((this->m_i >= this->m_parent.size()) || (this->m_parent[this->m_i])) {
-              return *this;
-            }
-          } while(true);
+          this->m_cell &= static_cast<t_cell>(this->m_cell - 1);
+          this->skip();
+          return *this;
         }
 
-        t_nat operator*() { return this->m_i; }
+        t_nat operator*() const { return static_cast<t_nat>((this->m_i * s_cell) + ctz(this->m_cell)); }
 
         bool operator==(const tt_iterator& it) const {
-          return ((&(this->m_parent)) == (&(it.m_parent))) && (this->m_i == it.m_i);
+          return (this->m_content == it.m_content) && (this->m_i == it.m_i) && (this->m_cell == it.m_cell);
         }
 
-        bool operator!=(const tt_iterator& it) const {
-         return ((&(this->m_parent)) != (&(it.m_parent))) || (this->m_i != it.m_i);
-       }
-
+        bool operator!=(const tt_iterator& it) const { return !((*this) == it); }
 
       private:
-        const t_holder& m_parent;
-        t_nat m_i;
+        const t_cell* m_content;
+        size_type m_size;
+        size_type m_i;
+        t_cell m_cell; // the bits of m_content[m_i] not yet visited
+
+        void skip() {
+          while(this->m_cell == 0) {
+            if((++this->m_i) >= this->m_size) {
+              this->m_i = this->m_size;
+              return;
+            }
+            this->m_cell = this->m_content[this->m_i];
+          }
+        }
       };
     }
 
@@ -92,7 +141,7 @@ namespace hrw {
     enum e_natset_kind { STATIC, FIXED, FREE };
     enum e_natset_extensible_conf { CELL, BLOCK };
     template<e_natset_extensible_conf n> using p_natset_extensible_conf = std::integral_constant<e_natset_extensible_conf, n>;
-  
+
     //////////////////////////////////////////
     //////////////////////////////////////////
 
@@ -102,7 +151,8 @@ namespace hrw {
       using type = natset_static<limit, check>;
       using t_nat = _natset_detail::t_nat;
       using size_type = _natset_detail::size_type;
-      using t_content = std::bitset<limit>;
+      using t_word = _natset_detail::t_word;
+      using t_content = std::array<t_word, (limit + 63) / 64>;
 
       inline static constexpr e_natset_kind kind = e_natset_kind::STATIC;
 
@@ -112,7 +162,7 @@ namespace hrw {
       natset_static(const type& s): m_content(s.m_content) {}
       natset_static(size_type t): m_content() { this->check_size(t); }
 
-      natset_static(size_type t, std::initializer_list<t_nat> init) {
+      natset_static(size_type t, std::initializer_list<t_nat> init): m_content() {
         this->check_size(t);
         this->add(init);
       }
@@ -131,20 +181,20 @@ namespace hrw {
             throw hrw::exception::natset_cannot_contain<type>(val);
           }
         }
-        this->m_content[val] = 1;
+        this->m_content[val / 64] |= (t_word(1) << (val % 64));
       }
 
       void add(std::initializer_list<t_nat> init) { for(auto v: init) { this->add(v); } }
       template<typename inputIt>
       void add(inputIt begin, inputIt end) { while(begin != end) { this->add(*begin); ++begin; } }
-      void add(const type& s) { this->m_content |= s.m_content; }
+      void add(const type& s) { _natset_detail::words_or(this->m_content.data(), s.m_content.data(), nb_words); }
       void cup_update(const type& s) { this->add(s); }
 
-      void cap_update(const type& s) { this->m_content &= s.m_content; }
+      void cap_update(const type& s) { _natset_detail::words_and(this->m_content.data(), s.m_content.data(), nb_words); }
 
       void rm(t_nat val)  {
-        if(val <= limit) {
-          this->m_content[val] = 0;
+        if(val < limit) {
+          this->m_content[val / 64] &= ~(t_word(1) << (val % 64));
         }
       }
 
@@ -155,7 +205,7 @@ namespace hrw {
       void insert(const type& s) { this->add(s); }
 
       void erase(t_nat val) { this->rm(val); }
-      void clear() { this->m_content.reset(); }
+      void clear() { this->m_content.fill(0); }
       constexpr t_nat size() const { return limit; }
 
 
@@ -165,28 +215,36 @@ namespace hrw {
 
       bool operator[](t_nat val) const { return this->contains(val); }
 
-      using const_iterator = _natset_detail::tt_iterator<type>;
-      friend const_iterator;
+      using const_iterator = _natset_detail::tt_iterator<t_word>;
 
-      const_iterator begin() const { return const_iterator(*this, 0); }
-      const_iterator end() const { return const_iterator(*this, limit);}
+      const_iterator begin() const { return const_iterator(this->m_content.data(), nb_words, 0); }
+      const_iterator end() const { return const_iterator(this->m_content.data(), nb_words, nb_words);}
 
       //////////////////////////////////////////
       // 4. set operations
-      type cup(const type& s) const { return type(this->m_content | s.m_content); }
-      type cap(const type& s) const { return type(this->m_content & s.m_content); }
+      type cup(const type& s) const {
+        type res;
+        _natset_detail::words_or(res.m_content.data(), this->m_content.data(), s.m_content.data(), nb_words);
+        return res;
+      }
+      type cap(const type& s) const {
+        type res;
+        _natset_detail::words_and(res.m_content.data(), this->m_content.data(), s.m_content.data(), nb_words);
+        return res;
+      }
 
       //////////////////////////////////////////
       // 5. testing
       bool contains(t_nat val) const  {
-        if(val <= limit) {
-          return this->m_content[val];
+        if(val < limit) {
+          return (this->m_content[val / 64] >> (val % 64)) & 1;
         } else {
           return false;
         }
       }
+      bool includes(const type& s) const { return _natset_detail::words_includes(this->m_content.data(), s.m_content.data(), nb_words); }
 
-      bool empty() const { return this->m_content.none(); }
+      bool empty() const { return _natset_detail::words_none(this->m_content.data(), nb_words); }
 
 
       //////////////////////////////////////////
@@ -197,10 +255,8 @@ namespace hrw {
 
       friend std::ostream& operator<<(std::ostream& os, const type& s) {
         os << "[ ";
-        for(t_nat i = 0; i < limit; ++i) {
-          if(s.m_content[i]) {
-            os << i << " ";
-          }
+        for(t_nat i: s) {
+          os << i << " ";
         }
         os << "]";
         return os;
@@ -213,18 +269,19 @@ namespace hrw {
 
       struct t_hash {
         using value_type = type;
-        using H = hrw::utils::hash<t_content>;
+        using H = hrw::utils::hash<t_word>;
         hrw::utils::hash_value operator()(const value_type& t) {
-          return H()(t.m_content);
+          hrw::utils::hash_value res{0};
+          for(t_word w: t.m_content) { res << H()(w); }
+          return res;
         }
       };
       struct t_eq   { constexpr bool operator()( const type& lhs, const type& rhs ) const { return lhs == rhs; } };
 
     private:
+      static constexpr size_type nb_words = (limit + 63) / 64;
       t_content m_content;
 
-      natset_static(t_content&& m): m_content(m) {}
-
       inline void check_size(size_type t) {
         if(t >= limit) {
           throw hrw::exception::natset_limit<type>(t);
@@ -242,58 +299,53 @@ namespace hrw {
     public:
       using type = natset_fixed<check>;
       using t_nat = _natset_detail::t_nat;
-      using t_content = std::vector<bool>;
+      using t_word = _natset_detail::t_word;
+      using t_content = std::vector<t_word>;
       using size_type = typename t_content::size_type;
 
       inline static constexpr e_natset_kind kind = e_natset_kind::FIXED;
 
       //////////////////////////////////////////
       // 1. constructors / destructors
-      natset_fixed(const type& s): m_content(s.m_content) {}
-      natset_fixed(size_type max): m_content(max) {}
+      natset_fixed(const type& s): m_size(s.m_size), m_content(s.m_content) {}
+      natset_fixed(type&& s): m_size(s.m_size), m_content(std::move(s.m_content)) {}
+      natset_fixed(size_type max): m_size(max), m_content((max + 63) / 64) {}
 
-      natset_fixed(size_type max, std::initializer_list<t_nat> init): m_content(max) { this->add(init); }
+      natset_fixed(size_type max, std::initializer_list<t_nat> init): natset_fixed(max) { this->add(init); }
       template<typename inputIt>
-      natset_fixed(size_type max, inputIt begin, inputIt end): m_content(max) { this->add(begin, end); }
+      natset_fixed(size_type max, inputIt begin, inputIt end): natset_fixed(max) { this->add(begin, end); }
       ~natset_fixed() = default;
 
       //////////////////////////////////////////
       // 2. adding / removing
       void add(t_nat val) {
         if constexpr(check) {
-          if(val > this->m_content.size()) {
+          if(val >= this->m_size) {
             throw hrw::exception::natset_cannot_contain<type>(val);
           }
         }
-        this->m_content[val] = 1;
+        this->m_content[val / 64] |= (t_word(1) << (val % 64));
       }
 
       void add(std::initializer_list<t_nat> init) { for(auto v: init) { this->add(v); } }
       template<typename inputIt>
       void add(inputIt begin, inputIt end) { while(begin != end) { this->add(*begin); ++begin; } }
       void add(const type& s) {
-        if(s.m_content.size() <= this->m_content.size()) {
-          for(auto i=0; i < s.m_content.size(); ++i) {
-            this->m_content[i] = this->m_content[i] || s.m_content[i];
-          }
+        if(s.m_size <= this->m_size) {
+          _natset_detail::words_or(this->m_content.data(), s.m_content.data(), s.m_content.size());
         }
       }
       void cup_update(const type& s) { this->add(s); }
 
       void cap_update(const type& s) {
-        auto max = std::min(s.m_content.size(), this->m_content.size());
-        auto i=0;
-        for(; i < max; ++i) {
-          this->m_content[i] = this->m_content[i] && s.m_content[i];
-        }
-        for(; i < this->m_content.size(); ++i) {
-          this->m_content[i] = 0;
-        }
+        size_type max = std::min(s.m_content.size(), this->m_content.size());
+        _natset_detail::words_and(this->m_content.data(), s.m_content.data(), max);
+        std::fill(this->m_content.begin() + max, this->m_content.end(), 0);
       }
 
       void rm(t_nat val)  {
-        if(val <= this->m_content.size()) {
-          this->m_content[val] = 0;
+        if(val < this->m_size) {
+          this->m_content[val / 64] &= ~(t_word(1) << (val % 64));
         }
       }
 
@@ -304,8 +356,8 @@ namespace hrw {
       void insert(const type& s) { this->add(s); }
 
       void erase(t_nat val) { this->rm(val); }
-      void clear() { std::fill(this->m_content.begin(), this->m_content.end(), 0);; }
-      constexpr size_type size() const { return this->m_content.size(); }
+      void clear() { std::fill(this->m_content.begin(), this->m_content.end(), 0); }
+      size_type size() const { return this->m_size; }
 
 
 
@@ -314,40 +366,57 @@ namespace hrw {
 
       bool operator[](t_nat val) const { return this->contains(val); }
 
-      using const_iterator = _natset_detail::tt_iterator<type>;
-      friend const_iterator;
+      using const_iterator = _natset_detail::tt_iterator<t_word>;
+
+      const_iterator begin() const { return const_iterator(this->m_content.data(), this->m_content.size(), 0); }
+      const_iterator end() const { return const_iterator(this->m_content.data(), this->m_content.size(), this->m_content.size());}
 
-      const_iterator begin() const { return const_iterator(*this, 0); }
-      const_iterator end() const { return const_iterator(*this, this->m_content.size());}
+
+      //////////////////////////////////////////
+      // 4. set operations
+      type cup(const type& s) const {
+        const type& big   = (this->m_size < s.m_size)?(s):(*this);
+        const type& small = (this->m_size < s.m_size)?(*this):(s);
+        type res(big);
+        _natset_detail::words_or(res.m_content.data(), small.m_content.data(), small.m_content.size());
+        return res;
+      }
+      type cap(const type& s) const {
+        type res(*this);
+        res.cap_update(s);
+        return res;
+      }
 
 
       //////////////////////////////////////////
       // 5. testing
       bool contains(t_nat val) const  {
         if constexpr(check) {
-          if(val <= this->m_content.size()) {
-            return this->m_content[val];
-          } else {
+          if(val >= this->m_size) {
             return false;
           }
-        } else {
-          return this->m_content[val];
         }
+        return (this->m_content[val / 64] >> (val % 64)) & 1;
+      }
+      bool includes(const type& s) const {
+        size_type max = std::min(s.m_content.size(), this->m_content.size());
+        return _natset_detail::words_includes(this->m_content.data(), s.m_content.data(), max)
+          && _natset_detail::words_none(s.m_content.data() + max, s.m_content.size() - max);
       }
 
-      bool empty() const { return std::all_of(this->m_content.begin(), this->m_content.end(), [](bool b) {return b; }); }
+      bool empty() const { return _natset_detail::words_none(this->m_content.data(), this->m_content.size()); }
 
 
       //////////////////////////////////////////
-      // 4. operators / friends
-      bool operator==(const type& s) const { return this->m_content == s.m_content; }
+      // 6. operators / friends
+      type& operator=(const type& s) { this->m_size = s.m_size; this->m_content = s.m_content; return *this; }
+
+      bool operator==(const type& s) const { return (this->m_size == s.m_size) && (this->m_content == s.m_content); }
 
       friend std::ostream& operator<<(std::ostream& os, const type& s) {
         os << "[ ";
-        for(t_nat i = 0; i < s.m_content.size(); ++i) {
-          if(s.m_content[i]) {
-            os << i << " ";
-          }
+        for(t_nat i: s) {
+          os << i << " ";
         }
         os << "]";
         return os;
@@ -355,19 +424,23 @@ namespace hrw {
 
       friend void swap(type& s1, type& s2) {
         using std::swap;
+        swap(s1.m_size, s2.m_size);
         swap(s1.m_content, s2.m_content);
       }
 
       struct t_hash {
         using value_type = type;
-        using H = hrw::utils::hash<t_content>;
+        using H = hrw::utils::hash<t_word>;
         hrw::utils::hash_value operator()(const value_type& t) {
-          return H()(t.m_content);
+          hrw::utils::hash_value res{t.m_size};
+          for(t_word w: t.m_content) { res << H()(w); }
+          return res;
         }
       };
       struct t_eq   { constexpr bool operator()( const type& lhs, const type& rhs ) const { return lhs == rhs; } };
 
     private:
+      size_type m_size;
       t_content m_content;
     };
 
@@ -380,11 +453,13 @@ namespace hrw {
     template<std::size_t block_size=64>
     class natset_extensible {
     public:
+      static_assert(block_size <= 64, "natset_extensible: the cells must fit in a 64-bit word");
+
       using type = natset_extensible;
       using t_nat = _natset_detail::t_nat;
       using size_type = _natset_detail::size_type;
 
-      using t_cell = std::bitset<block_size>;
+      using t_cell = typename size_to_type<block_size>::type;
       using t_content = std::vector<t_cell>;
 
       using t_info = typename type_as_bits<t_cell>::template make<_natset_detail::t_nat, typename t_content::size_type>;
@@ -402,16 +477,16 @@ namespace hrw {
       template<e_natset_extensible_conf c=e_natset_extensible_conf::CELL>
       natset_extensible(size_type t, [[maybe_unused]] p_natset_extensible_conf<c> v=p_natset_extensible_conf<c>()): m_content([&](){
         if constexpr(c == e_natset_extensible_conf::CELL) {
-          return ((t/block_size)+1);
+          return ((t/t_info::s_cell)+1);
         } else {
           return t;
         }
       }()) {}
-  
+
       template<typename inputIt, e_natset_extensible_conf c=e_natset_extensible_conf::CELL>
       natset_extensible(size_type t, inputIt begin, inputIt end, p_natset_extensible_conf<c> v=p_natset_extensible_conf<c>()): natset_extensible(t, v) { this->add(begin, end); }
       template<e_natset_extensible_conf c=e_natset_extensible_conf::CELL>
-      natset_extensible(size_type t, std::initializer_list<t_nat> init, p_natset_extensible_conf<c> v=p_natset_extensible_conf<c>()): natset_extensible(t, v) { for(auto v: init) { this->_add_inner(v); } }
+      natset_extensible(size_type t, std::initializer_list<t_nat> init, p_natset_extensible_conf<c> v=p_natset_extensible_conf<c>()): natset_extensible(t, v) { this->add(init); }
 
      ~natset_extensible() = default;
 
@@ -441,25 +516,20 @@ namespace hrw {
         if(this->m_content.size() < size) {
           this->m_content.resize(size);
         }
-        for(t_cell_index i = 0; i < size; ++i) {
-          this->m_content[i] |= s.m_content[i];
-        }
+        _natset_detail::words_or(this->m_content.data(), s.m_content.data(), size);
       }
       void cup_update(const type& s) { this->add(s); }
 
       void cap_update(const type& s) {
         type::t_cell_index size = std::min(this->m_content.size(), s.m_content.size());
         this->m_content.resize(size);
-        for(t_cell_index i = 0; i < size; ++i) {
-          this->m_content[i] &= s.m_content[i];
-        }
+        _natset_detail::words_and(this->m_content.data(), s.m_content.data(), size);
       }
 
       void rm(t_nat val)  {
         type::t_cell_index idx = t_info::right_shift(val);
         if (this->m_content.size() > idx) {
-          // t_cell mask = t_info::get_mask(val);
-          this->m_content[idx][t_info::get_inner_index(val)] = 0;
+          this->m_content[idx] &= static_cast<t_cell>(~t_info::get_mask(val));
         }
       }
 
@@ -479,11 +549,10 @@ namespace hrw {
 
       bool operator[](t_nat val) const { return this->contains(val); }
 
-      using const_iterator = _natset_detail::tt_iterator<type>;
-      friend const_iterator;
+      using const_iterator = _natset_detail::tt_iterator<t_cell>;
 
-      const_iterator begin() const { return const_iterator(*this, 0); }
-      const_iterator end() const { return const_iterator(*this, this->size());}
+      const_iterator begin() const { return const_iterator(this->m_content.data(), this->m_content.size(), 0); }
+      const_iterator end() const { return const_iterator(this->m_content.data(), this->m_content.size(), this->m_content.size());}
 
       std::size_t size() const { return this->m_content.size() * t_info::s_cell; }
 
@@ -491,28 +560,18 @@ namespace hrw {
       //////////////////////////////////////////
       // 4. set operations
       type cup(const type& s) const {
-        t_cell_index size_max = std::max(this->m_content.size(), s.m_content.size());
-        t_cell_index size_min = std::min(this->m_content.size(), s.m_content.size());
-        type res(size_max, p_natset_extensible_conf<e_natset_extensible_conf::BLOCK>());
-        t_cell_index i = 0;
-        for(; i < size_min; ++i) {
-          res.m_content[i] = this->m_content[i] | s.m_content[i];
-        }
-        for(; i < this->m_content.size(); ++i) {
-          res.m_content[i] = this->m_content[i];
-        }
-        for(; i < s.m_content.size(); ++i) {
-          res.m_content[i] = s.m_content[i];
-        }
+        const t_content& big   = (this->m_content.size() < s.m_content.size())?(s.m_content):(this->m_content);
+        const t_content& small = (this->m_content.size() < s.m_content.size())?(this->m_content):(s.m_content);
+        type res(big.size(), p_natset_extensible_conf<e_natset_extensible_conf::BLOCK>());
+        _natset_detail::words_or(res.m_content.data(), big.data(), small.data(), small.size());
+        std::copy(big.begin() + small.size(), big.end(), res.m_content.begin() + small.size());
         return res;
       }
 
       type cap(const type& s) const {
         t_cell_index size = std::min(this->m_content.size(), s.m_content.size());
         type res(size, p_natset_extensible_conf<e_natset_extensible_conf::BLOCK>());
-        for(t_cell_index i = 0; i < size; ++i) {
-          res.m_content[i] = this->m_content[i] & s.m_content[i];
-        }
+        _natset_detail::words_and(res.m_content.data(), this->m_content.data(), s.m_content.data(), size);
         return res;
       }
 
@@ -521,32 +580,27 @@ namespace hrw {
       bool contains(t_nat val) const  {
         t_cell_index idx = t_info::right_shift(val);
         if(idx < this->m_content.size()) {
-          // std::cout << "contains(" << val << ") -> idx=" << ((unsigned int)idx) << ", in=" << ((unsigned int)t_info::get_inner_index(val)) << std::endl;
-          return this->m_content[idx][t_info::get_inner_index(val)];
+          return (this->m_content[idx] & t_info::get_mask(val)) != 0;
         } else {
           return false;
         }
       }
-
-      bool empty() const {
-        for(auto& i: this->m_content) {
-          if(i.none()) { return false; }
-        }
-        return true;
+      bool includes(const type& s) const {
+        t_cell_index size = std::min(this->m_content.size(), s.m_content.size());
+        return _natset_detail::words_includes(this->m_content.data(), s.m_content.data(), size)
+          && _natset_detail::words_none(s.m_content.data() + size, s.m_content.size() - size);
       }
 
+      bool empty() const { return _natset_detail::words_none(this->m_content.data(), this->m_content.size()); }
+
       //////////////////////////////////////////
       // 6. operators / friends
       type& operator=(const type& s) { this->m_content = s.m_content; return *this; }
 
       friend std::ostream& operator<<(std::ostream& os, const type& s) {
         os << "[ ";
-        for(t_cell_index i = 0; i < s.m_content.size(); ++i) {
-          for(t_inner_index j=0; j <= t_info::l_cell; ++j) {
-            if(s.m_content[i][j]) {
-              os << ((t_info::left_shift(i)) + j) << " ";
-            }
-          }
+        for(t_nat i: s) {
+          os << i << " ";
         }
         os << "]";
         return os;
@@ -559,7 +613,7 @@ namespace hrw {
 
     private:
       inline void _add_inner(t_nat val) { this->_add_inner(val, t_info::right_shift(val)); }
-      inline void _add_inner(t_nat val, t_cell_index idx) { this->m_content[idx][t_info::get_inner_index(val)] = 1; }
+      inline void _add_inner(t_nat val, t_cell_index idx) { this->m_content[idx] |= t_info::get_mask(val); }
 
       t_content m_content;
     };
@@ -568,7 +622,7 @@ namespace hrw {
     /**
      * This class extends the first one with an annex array that stores the values in the set.
      * That way, iterating over the values of the set is linear in the number of elements (and not linear in the max possible element)
-     * Again, if necessary, we can extend this with other set operations (union, intersection, subset testing, etc)
+     * The set operations are performed on the core, and the array is filtered using the core.
      */
     template<typename targ_core>
     class tt_natset {
@@ -578,7 +632,7 @@ namespace hrw {
       using t_nat = typename t_core::t_nat;
       using t_content = std::vector<t_nat>;
       using size_type = typename t_content::size_type;
- 
+
       inline static constexpr e_natset_kind kind = t_core::kind;
 
       //////////////////////////////////////////
@@ -587,9 +641,9 @@ namespace hrw {
       tt_natset(const type& s): m_core(s.m_core), m_content(s.m_content) {}
 
       tt_natset(size_type t): m_core(t), m_content() {}
-      tt_natset(size_type t, std::initializer_list<t_nat> init): m_core(t, init), m_content(init) {}
+      tt_natset(size_type t, std::initializer_list<t_nat> init): m_core(t), m_content() { this->add(init); }
       template<typename inputIt>
-      tt_natset(size_type t, inputIt begin, inputIt end): m_content(t) { this->add(begin, end); }
+      tt_natset(size_type t, inputIt begin, inputIt end): m_core(t), m_content() { this->add(begin, end); }
       ~tt_natset() = default;
 
 
@@ -601,14 +655,7 @@ namespace hrw {
           this->m_content.push_back(val);
         }
       }
-      void add(std::initializer_list<t_nat> init) {
-        for(auto val: init) {
-          if(!this->m_core.contains(val)) {
-            this->m_content.push_back(val);
-          }
-        }
-        this->m_core.add(init);
-      }
+      void add(std::initializer_list<t_nat> init) { for(auto val: init) { this->add(val); } }
 
       template<typename inputIt>
       void add(inputIt begin, inputIt end) { while(begin != end) { this->add(*begin); ++begin; } }
@@ -625,15 +672,17 @@ namespace hrw {
 
 
       void cap_update(const type& s) {
-        auto it_end = std::remove_if(this->m_content.begin(), this->m_content.end(), [&s](t_nat val) { return !s.m_core.contains(val); });
-        this->m_content.erase(it_end, this->m_content.end());
         this->m_core.cap_update(s.m_core);
+        auto it_end = std::remove_if(this->m_content.begin(), this->m_content.end(), [this](t_nat val) { return !this->m_core.contains(val); });
+        this->m_content.erase(it_end, this->m_content.end());
       }
 
       void rm(t_nat val)  {
-        this->m_core.rm(val);
-        auto it_end = std::remove(this->m_content.begin(), this->m_content.end(), val);
-        this->m_content.erase(it_end, this->m_content.end());
+        if(this->m_core.contains(val)) {
+          this->m_core.rm(val);
+          auto it_end = std::remove(this->m_content.begin(), this->m_content.end(), val);
+          this->m_content.erase(it_end, this->m_content.end());
+        }
       }
 
 
@@ -650,9 +699,9 @@ namespace hrw {
       //////////////////////////////////////////
       // 3. iterator
 
-      bool operator[](t_nat val) { return this->m_core[val]; }
+      bool operator[](t_nat val) const { return this->m_core[val]; }
 
-      using const_iterator = std::vector<unsigned int>::const_iterator;
+      using const_iterator = typename t_content::const_iterator;
 
       const_iterator begin() const { return this->m_content.begin(); }
       const_iterator end() const { return this->m_content.end(); }
@@ -663,7 +712,6 @@ namespace hrw {
       //////////////////////////////////////////
       // 4. set operations
       type cup(const type& s) const {
-        // construct the vector
         t_content tmp;
         tmp.reserve(this->m_content.size() + s.m_content.size());
         tmp.insert(tmp.begin(), this->m_content.begin(), this->m_content.end());
@@ -672,32 +720,30 @@ namespace hrw {
             tmp.push_back(val);
           }
         }
-        return type(std::move(tmp));
+        return type(this->m_core.cup(s.m_core), std::move(tmp));
       }
 
       type cap(const type& s) const {
+        t_core core = this->m_core.cap(s.m_core);
+        const t_content& smallest = (this->m_content.size() <= s.m_content.size())?(this->m_content):(s.m_content);
         t_content tmp;
-        size_type size = std::min(this->m_content.size(), s.m_content.size());
-        tmp.reserve(size);
-
-        t_content const& v1 = (this->m_content.size() == size)?(this->m_content):(s.m_content);
-        t_core const& v2 = (this->m_content.size() == size)?(s.m_core):(this->m_core);
-
-        for(auto val: v1) {
-          if(v2.contains(val)) {
+        tmp.reserve(smallest.size());
+        for(auto val: smallest) {
+          if(core.contains(val)) {
             tmp.push_back(val);
           }
         }
-        return type(std::move(tmp));
+        return type(std::move(core), std::move(tmp));
       }
 
       //////////////////////////////////////////
       // 5. testing
 
-      bool contains(unsigned int val) const { return this->m_core.contains(val); }
+      bool contains(t_nat val) const { return this->m_core.contains(val); }
+      bool includes(const type& s) const { return this->m_core.includes(s.m_core); }
       bool empty() const { return this->m_content.empty(); }
 
- 
+
        //////////////////////////////////////////
       // 6. operators / friends
       type& operator=(const type& s) { this->m_content = s.m_content; this->m_core = s.m_core; return *this; }
@@ -719,11 +765,7 @@ namespace hrw {
       t_core m_core;
       t_content m_content;
 
-      tt_natset(t_content&& content): m_core(), m_content(std::move(content)) {
-        for(auto val: this->m_content) {
-          this->m_core.add(val);
-        }
-      }
+      tt_natset(t_core&& core, t_content&& content): m_core(std::move(core)), m_content(std::move(content)) {}
     };
 
 
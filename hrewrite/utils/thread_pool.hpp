@@ -0,0 +1,103 @@
+/*
+ * This file is part of the hrewrite library.
+ * Copyright (c) 2021 ONERA.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+ // Author: Michael Lienhardt
+ // Maintainer: Michael Lienhardt
+ // email: michael.lienhardt@onera.fr
+
+
+
+#ifndef __HREWRITE_UTILS_THREAD_POOL_H__
+#define __HREWRITE_UTILS_THREAD_POOL_H__
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+
+namespace hrw {
+  namespace utils {
+
+    // a fixed set of workers executing the submitted jobs in order.
+    // The destructor waits for the jobs already submitted
+    class thread_pool {
+    public:
+      using type = thread_pool;
+
+      explicit thread_pool(unsigned int nb_workers=std::max(1u, std::thread::hardware_concurrency())): m_mutex(), m_cond(), m_jobs(), m_stop(false), m_workers() {
+        for(unsigned int i = 0; i < nb_workers; ++i) {
+          this->m_workers.emplace_back([this]() { this->run(); });
+        }
+      }
+      thread_pool(const type&) = delete;
+      ~thread_pool() {
+        {
+          std::lock_guard<std::mutex> lock(this->m_mutex);
+          this->m_stop = true;
+        }
+        this->m_cond.notify_all();
+        for(std::thread& w: this->m_workers) { w.join(); }
+      }
+
+      template<typename F, typename R=std::invoke_result_t<std::decay_t<F>>>
+      std::future<R> submit(F&& f) {
+        auto job = std::make_shared<std::packaged_task<R()>>(std::forward<F>(f));
+        std::future<R> res = job->get_future();
+        {
+          std::lock_guard<std::mutex> lock(this->m_mutex);
+          this->m_jobs.emplace_back([job]() { (*job)(); });
+        }
+        this->m_cond.notify_one();
+        return res;
+      }
+
+      std::size_t size() const { return this->m_workers.size(); }
+
+    private:
+      std::mutex m_mutex;
+      std::condition_variable m_cond;
+      std::deque<std::function<void()>> m_jobs;
+      bool m_stop;
+      std::vector<std::thread> m_workers;
+
+      void run() {
+        while(true) {
+          std::function<void()> job;
+          {
+            std::unique_lock<std::mutex> lock(this->m_mutex);
+            this->m_cond.wait(lock, [this]() { return this->m_stop || !this->m_jobs.empty(); });
+            if(this->m_jobs.empty()) { return; }
+            job = std::move(this->m_jobs.front());
+            this->m_jobs.pop_front();
+          }
+          job();
+        }
+      }
+    };
+
+  }
+}
+
+
+#endif // __HREWRITE_UTILS_THREAD_POOL_H__
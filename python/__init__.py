@@ -20,6 +20,8 @@
 # email: michael.lienhardt@onera.fr
 
 
+import asyncio
+
 from . import libhrewrite_python as hrw
 
 
@@ -79,6 +81,21 @@ class lit(object):
   def __rshift__(self, sort):
     return spec_ext_cls(sort, self)
 
+# literals with native values, hashed and compared by value without the python interpreter
+class lit_int(lit):
+  __slots__ = ()
+class lit_float(lit):
+  __slots__ = ()
+class lit_str(lit):
+  __slots__ = ()
+
+_lit_add_constructor_ = {
+  lit: hrw.add_constructor_literal,
+  lit_int: hrw.add_constructor_literal_int,
+  lit_float: hrw.add_constructor_literal_float,
+  lit_str: hrw.add_constructor_literal_str,
+}
+
 
 _reg_terms_ = hrw.term_registry
 _reg_cs_ = {}
@@ -94,7 +111,7 @@ class cs_wrapper(object):
     self.m_spec__ = spec_ext.m_spec__
 
     if(isinstance(self.m_spec__, lit)):
-      self.m_cs_core__ = hrw.add_constructor_literal(self.m_sort__, self.m_name__)
+      self.m_cs_core__ = _lit_add_constructor_[self.m_spec__.__class__](self.m_sort__, self.m_name__)
       def m_fun(obj):
         # print(f"_reg_terms_.create_sterm({self.m_name__}[{type(self.m_cs_core__)}], {obj}[{type(obj)}])")
         # if(obj < 0):
@@ -122,6 +139,9 @@ class cs_wrapper(object):
   def data(self):
     return self.m_data__
   @property
+  def spec(self):
+    return self.m_spec__
+  @property
   def name(self):
     return self.m_name__
 
@@ -186,7 +206,7 @@ is_subsort = hrw.is_subsort
 # get info from constructors
 
 is_cs_free = lambda cs: ((cs.spec.__class__ is free) and (len(cs.spec.m_spec__) != 0))
-is_cs_lit  = lambda cs: (cs.spec.__class__ is lit)
+is_cs_lit  = lambda cs: isinstance(cs.spec, lit)
 is_cs_leaf = lambda cs: ((cs.spec.__class__ is free) and (len(cs.spec.m_spec__) == 0))
 
 ##########################################
@@ -204,12 +224,12 @@ is_term_wrapper = lambda t: (isinstance(t, cs_wrapper) and is_term_core(t.data))
 is_term = lambda t: (is_term_core(t) or is_term_wrapper(t))
 
 is_term_variable = lambda t: (is_term_core(t) and hrw.is_term_variable(t))
-is_term_literal  = lambda t: (is_term_core(t) and hrw.is_term_literal(t))
+is_term_literal  = lambda t: (is_term_core(t) and (hrw.is_term_literal(t) or hrw.is_term_literal_int(t) or hrw.is_term_literal_float(t) or hrw.is_term_literal_str(t)))
 is_term_leaf     = lambda t: ((is_term_core(t) and hrw.is_term_leaf(t)) or is_term_wrapper(t))
 is_term_free     = lambda t: (is_term_core(t) and hrw.is_term_free(t))
 
 is_term_ground = lambda t: ((is_term_core(t) and t.is_ground()) or is_term_wrapper(t))
-is_term_structured = lambda t: ((is_term_literal_int(t)) or (is_term_leaf(t)) or (is_term_free(t)))
+is_term_structured = lambda t: ((is_term_literal(t)) or (is_term_leaf(t)) or (is_term_free(t)))
 
 def get_constructor(t):
   global _reg_cs_
@@ -233,6 +253,34 @@ def walk_dfs(t, fun_enter, fun_exit):
     if(go_on): fun_exit(t)
   walk_dfs_rec(t)
 
+##########################################
+# binary serialisation
+
+def to_bytes(t): return cs_unwrap(t).to_bytes()
+from_bytes = hrw.t_term.from_bytes
+
+##########################################
+# bulk construction
+
+build_term = hrw.build_term
+build_terms = hrw.build_terms
+
+# the converse, returning a dict of numpy arrays
+def export_terms(terms): return hrw.export_terms([cs_unwrap(t) for t in terms])
+
+##########################################
+# text parsing: returns the list of terms and the list of (pattern, image) rules of a text,
+# written with the constructors of the signature
+
+parse_terms = hrw.parse_terms
+parse_file = hrw.parse_file
+
+##########################################
+# native guards, executed without calling back into python
+
+guard_expr = hrw.guard_expr
+native_guard = hrw.native_guard
+
 ##########################################
 # substitution
 
@@ -248,24 +296,74 @@ def instantiate(t, substitution):
 # REWRITE ENGINE
 ###############################################################################
 
+RewriteLimit = hrw.RewriteLimit
+
 class rw_engine_cls(object):
   __slots__ = ("m_rw__",)
-  def __init__(self):
+  def __init__(self, universe=None):
     global _reg_terms_
-    self.m_rw__ = hrw.context_rw(_reg_terms_)
+    self.m_rw__ = hrw.context_rw(_reg_terms_ if(universe is None) else universe.m_reg_terms__)
   def add(self, pattern, image, guard=None):
     pattern = cs_unwrap(pattern)
     image = cs_unwrap(image)
     if(guard is None): self.m_rw__.add(pattern, image)
     else: self.m_rw__.add(pattern, image, guard)
-  def rewrite(self, t):
+  def rewrite(self, t, nb_steps=-1):
+    t = cs_unwrap(t)
+    return self.m_rw__.rewrite(t, nb_steps)
+
+  # the rewriting is executed by a pool of workers, and its result is given in a concurrent.futures.Future:
+  # cancelling the future stops the rewriting, as does the exhaustion of its budget with RewriteLimit
+  def rewrite_async(self, t, nb_steps=-1):
     t = cs_unwrap(t)
-    return self.m_rw__.rewrite(t)
+    return self.m_rw__.rewrite_async(t, nb_steps)
+  def rewrite_aio(self, t, nb_steps=-1):
+    return asyncio.wrap_future(self.rewrite_async(t, nb_steps))
 
   def clear_nf(self): self.m_rw__.clear_nf()
   def clear(self): self.m_rw__.clear()
 
 
+###############################################################################
+# UNIVERSES
+###############################################################################
+
+# a universe owns its terms and rules: different universes can be built, rewritten and cleared independently,
+# in different threads, while sharing the sorts and constructors declared above
+
+class universe(object):
+  __slots__ = ("m_reg_terms__",)
+  def __init__(self):
+    self.m_reg_terms__ = hrw.context_term()
+
+  def term(self, cs, *args):
+    if(is_cs_lit(cs)):
+      return self.m_reg_terms__.create_sterm(cs.m_cs_core__, *args)
+    elif(is_cs_leaf(cs)):
+      return self.m_reg_terms__.create_sterm(cs.m_cs_core__)
+    else:
+      return self.m_reg_terms__.create_sterm(cs.m_cs_core__, tuple(self.import_term(el) for el in args))
+
+  def import_term(self, t):
+    if(isinstance(t, cs_wrapper) and is_cs_leaf(t)): return self.term(t)
+    return t
+
+  def var(self, spec): return self.m_reg_terms__.create_variable(spec)
+  def vars(self, *specs): return tuple(self.m_reg_terms__.create_variable(spec) for spec in specs)
+
+  def instantiate(self, t, substitution):
+    return self.m_reg_terms__.instantiate(self.import_term(t), substitution)
+
+  def build_term(self, nested, check=True): return hrw.build_term(nested, check, self.m_reg_terms__)
+  def build_terms(self, *args, **kwargs): return hrw.build_terms(*args, registry=self.m_reg_terms__, **kwargs)
+  def from_bytes(self, data, check=True): return hrw.t_term.from_bytes(data, check, self.m_reg_terms__)
+  def parse_terms(self, text, signature, check=True): return hrw.parse_terms(text, signature, check, self.m_reg_terms__)
+  def parse_file(self, path, signature, check=True): return hrw.parse_file(path, signature, check, self.m_reg_terms__)
+
+  def rw_engine(self): return rw_engine_cls(self)
+  def clear(self): self.m_reg_terms__.clear()
+
+
 ###############################################################################
 # CLEAN UP
 ###############################################################################
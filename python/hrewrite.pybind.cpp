@@ -59,7 +59,7 @@ using t_sparser = utils::combine_variant<t_alphabet, alphabet, utils::sequence,
 // solution: instead of using targs, write functions directly. would work. Need to add template arguments, that's all
 struct th_api_free {
   static const std::string& name() { static const std::string res = "free"; return res; }
-  template<typename tt, const tt& arg> using tt_theory = hrw::theory::tp_theory_free<std::vector, t_sparser>::template type<tt, arg>;
+  template<typename tt, const tt& arg> using tt_theory = hrw::theory::tp_theory_free<hrw::utils::small_vector_default, t_sparser>::template type<tt, arg>;
   template<typename t_theory, typename t_term_full_wrapper> struct th_factory {
     using t_term_full = typename t_term_full_wrapper::t_term_full;
     using t_term_full_ref = typename t_term_full_wrapper::t_term_full_ref;
@@ -102,13 +102,18 @@ struct th_api_free {
 
 
 
+// the objects are taken by reference, as a copy changes their reference count, which requires the GIL.
+// The hash may be called by a rewriting that released the GIL, and so takes it
 struct pyobj_hash {
   using value_type = py::object;
-  std::size_t operator()(py::object const obj) const { return static_cast<std::size_t>(obj.attr("__hash__")().cast<std::make_signed_t<std::size_t>>()); }
+  std::size_t operator()(py::object const & obj) const {
+    py::gil_scoped_acquire acquire;
+    return static_cast<std::size_t>(obj.attr("__hash__")().cast<std::make_signed_t<std::size_t>>());
+  }
 };
 struct pyobj_eq {
   using value_type = py::object;
-  bool operator()(py::object const left, py::object const right) const { return left.is(right); }
+  bool operator()(py::object const & left, py::object const & right) const { return left.is(right); }
 };
 
 struct th_api_lit_obj {
@@ -131,6 +136,36 @@ struct th_api_lit_obj {
 };
 
 
+// literals with native values: they are hashed and compared in C++, so equal values are shared, and never touch the interpreter
+template<typename T>
+struct th_api_lit_native {
+  template<typename tt, const tt& arg> using tt_theory = typename hrw::theory::tp_theory_literal<T>::template type<tt, arg>;
+  template<typename t_theory, typename t_term_full_wrapper> struct th_factory {
+    using t_term_full = typename t_term_full_wrapper::t_term_full;
+    using t_term_full_ref = typename t_term_full_wrapper::t_term_full_ref;
+    using t_term = typename t_theory::template tt_term<t_term_full>;
+
+    using t_cargs = std::tuple<const std::string>;     // the arguments for constructor creation
+    using t_targs = std::tuple<T>;     // the arguments for term creation
+    static py::tuple dumps(const t_term& t, std::function<const py::tuple(const t_term_full_ref)>) { return py::make_tuple(t.get_constructor(), t.get_value()); }
+    static std::pair<t_constructor_id, t_targs> loads(const py::tuple t, std::function<t_term_full_ref(const py::tuple)>) {
+      t_constructor_id cid = t[0].cast<t_constructor_id>();
+      return std::make_pair(cid, std::make_tuple(t[1].cast<T>()));
+    }
+  };
+};
+
+struct th_api_lit_int: public th_api_lit_native<std::int64_t> {
+  static const std::string& name() { static const std::string res = "literal_int"; return res; }
+};
+struct th_api_lit_float: public th_api_lit_native<double> {
+  static const std::string& name() { static const std::string res = "literal_float"; return res; }
+};
+struct th_api_lit_str: public th_api_lit_native<hrw::utils::interned_string> {
+  static const std::string& name() { static const std::string res = "literal_str"; return res; }
+};
+
+
 struct th_api_leaf {
   static const std::string& name() { static const std::string res = "leaf"; return res; }
   template<typename tt, const tt& arg> using tt_theory = hrw::theory::tp_theory_leaf::template type<tt, arg>;
@@ -158,7 +193,7 @@ PYBIND11_MODULE(libhrewrite_python, m) {
     false,
     hrw::e_strategy::STY_INNER,
     t_vparser,
-    th_api_free, th_api_leaf, th_api_lit_obj
+    th_api_free, th_api_leaf, th_api_lit_obj, th_api_lit_int, th_api_lit_float, th_api_lit_str
   >(m);
 }
 
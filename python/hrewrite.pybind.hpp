@@ -30,6 +30,12 @@
 #include <stdexcept>
 #include <chrono>
 #include <typeinfo>
+#include <mutex>
+#include <atomic>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <string_view>
 
 #include <unordered_map>
 #include <unordered_set>
@@ -50,6 +56,24 @@ namespace py = pybind11;
 
 #include "hrewrite/exceptions/theory_free.hpp"
 
+// the interned strings are python str
+namespace pybind11 {
+  namespace detail {
+    template<> struct type_caster<hrw::utils::interned_string> {
+    public:
+      PYBIND11_TYPE_CASTER(hrw::utils::interned_string, _("str"));
+      bool load(handle src, bool) {
+        if(!py::isinstance<py::str>(src)) { return false; }
+        this->value = hrw::utils::interned_string(src.cast<std::string>());
+        return true;
+      }
+      static handle cast(const hrw::utils::interned_string& s, return_value_policy, handle) {
+        return py::str(s.str()).release();
+      }
+    };
+  }
+}
+
 using namespace hrw;
 
 
@@ -92,12 +116,15 @@ template<
   typename ... th_apis
 > struct hconstruct {  
   using t_ctx_th = context_theory<int,
-    hrw::context_sort<hrw::utils::natset>,
+    hrw::context_sort<hrw::utils::natset, true>,
     hrw::theory::tp_theory_variable_vector<t_vparser>::template type,
     th_apis::template tt_theory ...
   >;
 
-  using t_ctx_tm        = context_term<t_ctx_th, my_term_registry>;
+  // a universe of terms, with its own registry and lock: the universes share the signature, but are built and freed independently
+  struct t_ctx_tm: public context_term<t_ctx_th, my_term_registry> {
+    std::recursive_mutex m_mutex;
+  };
   using t_term_full     = typename t_ctx_tm::t_term_full;
   using t_term_full_ref = typename t_term_full::reference;
   using t_variable      = typename t_term_full::t_variable;
@@ -179,15 +206,13 @@ void register_cdecl(py::module &m, t_wrapper<std::tuple<t_ctx_th, t_ctx_tm, t_te
   m.def("theory_index", [](t_constructor_core<th>&) { return t_ctx_th::template theory_index_v<th>; }, py::return_value_policy::automatic);
   m.attr(name_index.c_str()) = t_ctx_th::template theory_index_v<th>;
 
-  if constexpr(has_value_v<t_term>) {
-    m.def("get_value", [](t_term_full_wrapper t){ return std::get<t_term>(t.m_content->m_content).get_value(); });
-  }
 }
 
 template<typename py_class, typename t_term_full_wrapper, typename t_ctx_tm, typename thw, typename ... Args>
 void register_tdecl(py_class& c, t_wrapper<std::tuple<t_term_full_wrapper, t_ctx_tm, thw, Args...>>) {
   using th = typename thw::t_theory;
   c.def("create_sterm", [](t_ctx_tm* _this, const t_constructor_core<th> c, Args& ... args) {
+    auto lock = lock_terms(*_this);
     if constexpr(thw::has_targs_wrapper_v) {
       return t_term_full_wrapper{_this->create_sterm(c, thw::th_factory::t_targs_wrapper(args...))};
     } else {
@@ -326,6 +351,59 @@ private:
 };
 
 
+// codec of the binary format for the python literals: they are either stored in a list given with the bytes,
+// so that pickle manages them with the rest of its data, or pickled in place
+class __attribute__ ((visibility("hidden"))) t_pyobj_codec {
+public:
+  t_pyobj_codec(): m_objects(std::nullopt), m_dumps(), m_loads() {
+    py::module pickle = py::module::import("pickle");
+    this->m_dumps = pickle.attr("dumps");
+    this->m_loads = pickle.attr("loads");
+  }
+  t_pyobj_codec(py::list objects): t_pyobj_codec() { this->m_objects = objects; }
+
+  template<typename T>
+  void write(hrw::term_binary::output& out, const T& v) {
+    if constexpr(std::is_same_v<T, py::object>) {
+      if(this->m_objects.has_value()) {
+        out.write(static_cast<hrw::term_binary::t_word>(this->m_objects.value().size()));
+        this->m_objects.value().append(v);
+      } else {
+        std::string data = this->m_dumps(v).template cast<std::string>();
+        out.write(static_cast<hrw::term_binary::t_word>(data.size()));
+        out.write_raw(data.data(), data.size());
+      }
+    } else {
+      hrw::term_binary::codec().write(out, v);
+    }
+  }
+
+  template<typename T>
+  T read(hrw::term_binary::input& in) {
+    if constexpr(std::is_same_v<T, py::object>) {
+      hrw::term_binary::t_word idx = in.read();
+      if(this->m_objects.has_value()) {
+        if(idx >= this->m_objects.value().size()) {
+          throw hrw::exception::binary_format("wrong object index");
+        }
+        py::object res = this->m_objects.value()[idx];
+        return res;
+      } else {
+        std::string_view data = in.read_view(idx);
+        return this->m_loads(py::bytes(data.data(), data.size()));
+      }
+    } else {
+      return hrw::term_binary::codec().template read<T>(in);
+    }
+  }
+
+private:
+  std::optional<py::list> m_objects;
+  py::object m_dumps;
+  py::object m_loads;
+};
+
+
 //////////////////////////////////////////
 // 4. ensure correct rw rules definition
 
@@ -395,6 +473,315 @@ bool vbind_check(t_term_full_ref lhs, t_term_full_ref rhs) {
   return true;
 }
 
+//////////////////////////////////////////
+// 5. concurrency
+
+// the rewritings without guard run without the GIL, so the terms of a universe are created under its lock.
+// It is recursive, as the guards create terms during a rewriting, and the GIL is released while waiting for it
+template<typename t_ctx_tm>
+std::unique_lock<std::recursive_mutex> lock_terms(t_ctx_tm& ctx) {
+  std::unique_lock<std::recursive_mutex> res(ctx.m_mutex, std::try_to_lock);
+  if(!res.owns_lock()) {
+    py::gil_scoped_release release;
+    res.lock();
+  }
+  return res;
+}
+
+// the workers of the asynchronous rewritings. The pool is never destroyed, as its workers may wait for the GIL while python exits
+inline hrw::utils::thread_pool& async_pool() {
+  static hrw::utils::thread_pool* res = new hrw::utils::thread_pool();
+  return *res;
+}
+
+// an asynchronous rewriting: its python objects are only copied and released with the GIL,
+// and its terms are only released under the lock of their universe
+template<typename t_term_full_ref>
+struct t_async_rewrite {
+  py::object m_engine;
+  py::object m_future;
+  std::optional<t_term_full_ref> m_term;
+  std::shared_ptr<std::atomic<unsigned int>> m_budget;
+};
+
+inline unsigned int to_budget(long long nb_steps) {
+  return (nb_steps < 0) ? std::numeric_limits<unsigned int>::max() : static_cast<unsigned int>(std::min<long long>(nb_steps, std::numeric_limits<unsigned int>::max()));
+}
+
+
+//////////////////////////////////////////
+// 6. bulk term construction
+
+// translation of a nested python structure into a term_bulk. A node is a tuple or a list whose first element is its constructor
+// (a key (theory index, constructor id), or an object with get_constructor_key like cs_wrapper), followed by its subterms or its literal value.
+// A t_term, or an object whose m_data__ is a t_term, is an external node, and a python object used several times is a single node
+template<typename hrw_all_arg> class __attribute__ ((visibility("hidden"))) tt_term_bulk_flatten {
+public:
+  using type = tt_term_bulk_flatten<hrw_all_arg>;
+  using hrw_all = hrw_all_arg;
+  using t_ctx_tm = typename hrw_all::t_ctx_tm;
+  using t_term_full_ref = typename hrw_all::t_term_full_ref;
+  using t_term_full_wrapper = typename hrw_all::t_term_full_wrapper;
+  using t_builder = hrw::term_bulk_builder<t_ctx_tm>;
+  using t_index = hrw::term_bulk::t_index;
+
+  tt_term_bulk_flatten(): m_theories(), m_constructors(), m_offsets({0}), m_children(), m_externals(), m_values(), m_memo(), m_keys() {}
+  tt_term_bulk_flatten(const type&) = delete;
+
+  // returns the index of the node of obj
+  t_index add(py::handle obj) {
+    std::vector<t_frame> stack;
+    std::vector<t_index> child_indices;
+    this->enter(obj, stack, child_indices);
+    while(!stack.empty()) {
+      t_frame& frame = stack.back();
+      if(frame.m_next != frame.m_end) {
+        py::object child = frame.m_seq[frame.m_next++];
+        this->enter(child, stack, child_indices);
+      } else {
+        t_index res = static_cast<t_index>(this->m_theories.size());
+        this->m_theories.push_back(frame.m_theory);
+        this->m_constructors.push_back(frame.m_constructor);
+        this->m_children.insert(this->m_children.end(), child_indices.begin() + frame.m_indices, child_indices.end());
+        this->m_offsets.push_back(static_cast<t_index>(this->m_children.size()));
+        this->m_memo[frame.m_seq.ptr()] = res;
+        child_indices.resize(frame.m_indices);
+        child_indices.push_back(res);
+        stack.pop_back();
+      }
+    }
+    return child_indices.back();
+  }
+
+  hrw::term_bulk description() const {
+    return hrw::term_bulk{this->m_theories.size(), this->m_children.size(),
+      this->m_theories.data(), this->m_constructors.data(), this->m_offsets.data(), this->m_children.data()};
+  }
+  const std::vector<t_term_full_ref>& externals() const { return this->m_externals; }
+  py::list values() const { return this->m_values; }
+
+private:
+  static inline constexpr t_index in_progress = hrw::term_bulk::external;
+
+  struct t_frame {
+    py::sequence m_seq;
+    std::size_t m_next;
+    std::size_t m_end;
+    std::size_t m_indices;
+    t_index m_theory;
+    t_index m_constructor;
+  };
+
+  std::vector<t_index> m_theories;
+  std::vector<t_index> m_constructors;
+  std::vector<t_index> m_offsets;
+  std::vector<t_index> m_children;
+  std::vector<t_term_full_ref> m_externals;
+  py::list m_values;
+  std::unordered_map<PyObject*, t_index> m_memo;
+  std::unordered_map<PyObject*, std::pair<t_index, t_index>> m_keys;
+
+  void enter(py::handle obj, std::vector<t_frame>& stack, std::vector<t_index>& child_indices) {
+    auto it = this->m_memo.find(obj.ptr());
+    if(it != this->m_memo.end()) {
+      if(it->second == in_progress) {
+        throw hrw::exception::generic("ERROR: the structure given to build_term is cyclic");
+      }
+      child_indices.push_back(it->second);
+    } else if(py::isinstance<py::tuple>(obj) || py::isinstance<py::list>(obj)) {
+      py::sequence seq = py::reinterpret_borrow<py::sequence>(obj);
+      std::size_t size = py::len(seq);
+      if(size == 0) {
+        throw hrw::exception::generic("ERROR: a node given to build_term has no constructor");
+      }
+      auto [theory, c] = this->get_key(seq[0]);
+      if(t_builder::has_value(theory)) {
+        if(size != 2) {
+          throw hrw::exception::generic("ERROR: a literal given to build_term must have exactly one value");
+        }
+        this->m_values.append(seq[1]);
+        child_indices.push_back(this->add_node(obj, theory, c));
+      } else {
+        this->m_memo.emplace(obj.ptr(), in_progress);
+        stack.push_back(t_frame{seq, 1, size, child_indices.size(), theory, c});
+      }
+    } else {
+      py::object t = py::reinterpret_borrow<py::object>(obj);
+      if((!py::isinstance<t_term_full_wrapper>(t)) && py::hasattr(t, "m_data__")) { // ad-hoc hook for cs_wrapper
+        t = t.attr("m_data__");
+      }
+      if(!py::isinstance<t_term_full_wrapper>(t)) {
+        throw hrw::exception::generic("ERROR: unexpected object given to build_term");
+      }
+      this->m_externals.push_back(t.cast<t_term_full_wrapper>().m_content);
+      child_indices.push_back(this->add_node(obj, hrw::term_bulk::external, static_cast<t_index>(this->m_externals.size() - 1)));
+    }
+  }
+
+  t_index add_node(py::handle obj, t_index theory, t_index c) {
+    t_index res = static_cast<t_index>(this->m_theories.size());
+    this->m_theories.push_back(theory);
+    this->m_constructors.push_back(c);
+    this->m_offsets.push_back(static_cast<t_index>(this->m_children.size()));
+    this->m_memo[obj.ptr()] = res;
+    return res;
+  }
+
+  std::pair<t_index, t_index> get_key(py::handle obj) {
+    auto it = this->m_keys.find(obj.ptr());
+    if(it == this->m_keys.end()) {
+      py::object key = py::isinstance<py::tuple>(obj) ? py::reinterpret_borrow<py::object>(obj) : obj.attr("get_constructor_key")();
+      it = this->m_keys.emplace(obj.ptr(), key.cast<std::pair<t_index, t_index>>()).first;
+    }
+    return it->second;
+  }
+};
+
+// source of the literal values of a bulk construction
+struct __attribute__ ((visibility("hidden"))) t_pyobj_values {
+  py::list m_values;
+  template<typename T> T get(std::size_t k) {
+    if(k >= this->m_values.size()) {
+      throw hrw::exception::generic("ERROR: not enough values given for the literals of a bulk term construction");
+    }
+    return this->m_values[k].template cast<T>();
+  }
+};
+
+
+//////////////////////////////////////////
+// 7. native guards
+
+// the native guards run while the GIL is held, as the rewritings with guards do not release it
+namespace hrw {
+  namespace guard {
+    template<> struct value_traits<py::object> {
+      static t_value to_value(const py::object& v) {
+        if(py::isinstance<py::bool_>(v)) { return t_value(v.cast<bool>()); }
+        if(py::isinstance<py::int_>(v)) {
+          int overflow;
+          long long res = PyLong_AsLongLongAndOverflow(v.ptr(), &overflow);
+          return (overflow == 0) ? t_value(static_cast<std::int64_t>(res)) : t_value();
+        }
+        if(py::isinstance<py::float_>(v)) { return t_value(v.cast<double>()); }
+        if(py::isinstance<py::str>(v)) { return t_value(v.cast<std::string>()); }
+        return t_value();
+      }
+      static std::optional<py::object> from_value(const t_value& v) {
+        return std::visit(hrw::utils::visit_helper {
+          [](const std::monostate&) { return std::optional<py::object>(); },
+          [](const auto& x) { return std::optional<py::object>(py::cast(x)); }
+        }, v);
+      }
+    };
+  }
+}
+
+// the python values and terms usable in a guard expression
+template<typename t_guard_expr, typename t_term_full_wrapper>
+t_guard_expr to_guard_expr(py::handle obj) {
+  if(py::isinstance<t_guard_expr>(obj)) { return obj.cast<t_guard_expr>(); }
+  if(py::isinstance<py::bool_>(obj)) { return t_guard_expr(obj.cast<bool>()); }
+  if(py::isinstance<py::int_>(obj)) { return t_guard_expr(obj.cast<std::int64_t>()); }
+  if(py::isinstance<py::float_>(obj)) { return t_guard_expr(obj.cast<double>()); }
+  if(py::isinstance<py::str>(obj)) { return t_guard_expr(obj.cast<std::string>()); }
+  py::object t = py::reinterpret_borrow<py::object>(obj);
+  if((!py::isinstance<t_term_full_wrapper>(t)) && py::hasattr(t, "m_data__")) { // ad-hoc hook for cs_wrapper
+    t = t.attr("m_data__");
+  }
+  if(py::isinstance<t_term_full_wrapper>(t)) { return t_guard_expr::variable(t.cast<t_term_full_wrapper>().m_content); }
+  throw hrw::exception::guard_invalid("unexpected object in a guard expression");
+}
+
+// a constructor given as a key (theory index, constructor id), or as an object with get_constructor_key like cs_wrapper
+inline t_constructor_key to_constructor_key(py::handle obj) {
+  py::object key = py::isinstance<py::tuple>(obj) ? py::reinterpret_borrow<py::object>(obj) : obj.attr("get_constructor_key")();
+  return key.cast<t_constructor_key>();
+}
+
+
+//////////////////////////////////////////
+// 8. python guards
+
+// a python function called as a guard. Unlike the conversion of pybind11/functional.h, the python wrapper of the substitution
+// is created once and reused by all the calls, so a call costs a single python call.
+// The state is shared by the copies of the guard, and is released with the GIL
+template<typename t_ctx_rw, typename t_substitution>
+class t_py_guard {
+public:
+  t_py_guard(py::function fun): m_state(std::make_shared<t_state>(std::move(fun))) {}
+
+  bool operator()(t_ctx_rw* rw, t_substitution* s) const {
+    py::gil_scoped_acquire gil;
+    t_state& state = *this->m_state;
+    if(state.m_subst != s) {
+      state.m_subst_wrapper = py::cast(s, py::return_value_policy::reference);
+      state.m_subst = s;
+    }
+    return state.m_fun(py::cast(rw, py::return_value_policy::reference), state.m_subst_wrapper).template cast<bool>();
+  }
+
+private:
+  struct t_state {
+    t_state(py::function fun): m_fun(std::move(fun)), m_subst(nullptr), m_subst_wrapper() {}
+    ~t_state() {
+      py::gil_scoped_acquire gil;
+      this->m_fun = py::function();
+      this->m_subst_wrapper = py::object();
+    }
+    py::function m_fun;
+    t_substitution* m_subst;
+    py::object m_subst_wrapper;
+  };
+  std::shared_ptr<t_state> m_state;
+};
+
+
+//////////////////////////////////////////
+// 9. text parsing
+
+// a literal of the text is a python int or float when it reads as one, and a str otherwise.
+// The values are created while the GIL is held, as the whole parsing is
+namespace hrw {
+  template<> struct text_value_traits<py::object> {
+    static std::optional<py::object> from_text(std::string_view s, bool quoted) {
+      if(!quoted) {
+        std::int64_t i;
+        auto [end_i, ec_i] = std::from_chars(s.data(), s.data() + s.size(), i);
+        if(end_i == s.data() + s.size()) {
+          if(ec_i == std::errc()) { return py::object(py::int_(i)); }
+          if(ec_i == std::errc::result_out_of_range) { return py::object(py::int_(py::str(std::string(s)))); }
+        }
+        double d;
+        auto [end_d, ec_d] = std::from_chars(s.data(), s.data() + s.size(), d);
+        if((ec_d == std::errc()) && (end_d == s.data() + s.size())) { return py::object(py::float_(d)); }
+        return py::object(py::str(std::string(s)));
+      }
+      return py::object(py::str(hrw::text_unescape(s)));
+    }
+  };
+}
+
+// the terms of a text read by read(parser, on_term, on_rule), and its rules as (pattern, image) pairs
+template<typename t_term_full_wrapper, typename t_ctx_tm, typename F>
+py::tuple parse_text(t_ctx_tm& reg, py::iterable signature, bool check, F&& read) {
+  using t_term_full_ref = typename t_ctx_tm::t_term_full_ref;
+  hrw::term_text_parser<t_ctx_tm> parser(reg, check);
+  for(auto c: signature) {
+    t_constructor_key key = to_constructor_key(c);
+    parser.declare(static_cast<hrw::term_bulk::t_index>(key.first), static_cast<hrw::term_bulk::t_index>(key.second));
+  }
+  py::list terms, rules;
+  auto on_term = [&terms](t_term_full_ref t) { terms.append(t_term_full_wrapper{t}); };
+  auto on_rule = [&rules](t_term_full_ref pattern, t_term_full_ref image) {
+    rules.append(py::make_tuple(t_term_full_wrapper{pattern}, t_term_full_wrapper{image}));
+  };
+  auto lock = lock_terms(reg);
+  read(parser, on_term, on_rule);
+  return py::make_tuple(terms, rules);
+}
+
+
 /////////////////////////////////////////////////////////////////////////////
 // MAIN API
 /////////////////////////////////////////////////////////////////////////////
@@ -435,6 +822,14 @@ void register_hrw(py::module &m) {
 
   using t_print = typename hrw_all::t_print;
 
+  using t_term_binary_writer = hrw::term_binary_writer<t_ctx_tm, t_pyobj_codec>;
+  using t_term_binary_reader = hrw::term_binary_reader<t_ctx_tm, t_pyobj_codec>;
+  using t_term_bulk_flatten = tt_term_bulk_flatten<hrw_all>;
+  using t_index = hrw::term_bulk::t_index;
+  using t_index_array = py::array_t<t_index, py::array::c_style | py::array::forcecast>;
+  using t_native_guard = hrw::native_guard<t_ctx_rw>;
+  using t_guard_expr = typename t_native_guard::t_expr;
+
   static t_ctx_tm term_registry;
   // static t_term_dumps term_dumps;
   // static t_term_loads term_loads(term_registry);
@@ -454,11 +849,100 @@ void register_hrw(py::module &m) {
   m.def("get_subsorts", [](const t_sort_id sort) { return translate_sortset<t_ctx_th>(t_ctx_th::get_subsorts(sort)); });
 
   // clearing all declaration: WARNING: all terms in ctx_rw are invalid pointers after calling this function
-  m.def("clear", []() { t_ctx_th::clear(); term_registry.clear(); });
+  m.def("clear", []() {
+    auto lock = lock_terms(term_registry);
+    t_ctx_th::clear();
+    term_registry.clear();
+  });
 
 
   //////////////////////////////////////////
   // 1. term
+
+  // loading of the pickled terms: the data comes from __reduce__, so the subterms are not checked again
+  m.def("term_from_bytes", [](py::bytes data, py::list objects) {
+    auto lock = lock_terms(term_registry);
+    std::string buffer = data;
+    t_term_binary_reader reader(term_registry, buffer, false, t_pyobj_codec(objects));
+    if(reader.roots().size() != 1) {
+      throw hrw::exception::binary_format("expected a single root");
+    }
+    return t_term_full_wrapper{reader.roots().front()};
+  });
+  py::object term_from_bytes = m.attr("term_from_bytes");
+
+  // the universe given to a function, or the default one
+  auto get_registry = [](t_ctx_tm* registry) -> t_ctx_tm& { return (registry == nullptr) ? term_registry : *registry; };
+
+  // bulk construction: the terms are type-checked and created in a single call
+  m.def("build_term", [get_registry](py::object nested, bool check, t_ctx_tm* registry) {
+    t_term_bulk_flatten flatten;
+    flatten.add(nested);
+    t_ctx_tm& reg = get_registry(registry);
+    auto lock = lock_terms(reg);
+    hrw::term_bulk_builder<t_ctx_tm> builder(reg);
+    return t_term_full_wrapper{builder.build(flatten.description(), flatten.externals(), t_pyobj_values{flatten.values()}, check).back()};
+  }, py::arg("nested"), py::arg("check")=true, py::arg("registry")=static_cast<t_ctx_tm*>(nullptr));
+
+  // the numpy-compatible version: the root is the last node. The GIL is released when no literal values are given
+  m.def("build_terms", [get_registry](t_index_array theories, t_index_array constructors, t_index_array offsets, t_index_array children,
+                          py::list values, py::list externals, bool check, t_ctx_tm* registry) {
+    if((constructors.size() != theories.size()) || (offsets.size() != (theories.size() + 1)) || (theories.size() == 0)) {
+      throw hrw::exception::generic("ERROR: build_terms expects n theories and constructors, and n+1 offsets, with n > 0");
+    }
+    std::vector<t_term_full_ref> ext;
+    for(auto t: externals) { ext.push_back(t.cast<t_term_full_wrapper>().m_content); }
+    hrw::term_bulk desc{static_cast<std::size_t>(theories.size()), static_cast<std::size_t>(children.size()),
+      theories.data(), constructors.data(), offsets.data(), children.data()};
+
+    t_ctx_tm& reg = get_registry(registry);
+    auto lock = lock_terms(reg);
+    hrw::term_bulk_builder<t_ctx_tm> builder(reg);
+    if(values.size() == 0) {
+      py::gil_scoped_release release;
+      return t_term_full_wrapper{builder.build(desc, ext, hrw::term_bulk_no_values(), check).back()};
+    } else {
+      return t_term_full_wrapper{builder.build(desc, ext, t_pyobj_values{values}, check).back()};
+    }
+  }, py::arg("theories"), py::arg("constructors"), py::arg("offsets"), py::arg("children"),
+     py::arg("values")=py::list(), py::arg("externals")=py::list(), py::arg("check")=true, py::arg("registry")=static_cast<t_ctx_tm*>(nullptr));
+
+  // the converse: the terms are walked once, and their nodes are returned in numpy arrays owned by a single capsule
+  m.def("export_terms", [](py::iterable terms) {
+    hrw::term_bulk_exporter<t_ctx_tm> exporter;
+    py::list values;
+    auto on_value = [&values](const auto& v) { values.append(py::cast(v)); };
+    for(auto t: terms) { exporter.add(t.cast<t_term_full_wrapper>().m_content, on_value); }
+
+    hrw::term_bulk_data* data = new hrw::term_bulk_data(std::move(exporter.data()));
+    py::capsule owner(data, [](void* ptr) { delete static_cast<hrw::term_bulk_data*>(ptr); });
+    auto to_array = [&owner](const std::vector<t_index>& v) { return py::array_t<t_index>(v.size(), v.data(), owner); };
+    py::list externals;
+    for(auto& t: exporter.externals()) { externals.append(t_term_full_wrapper{t}); }
+
+    py::dict res;
+    res["theories"] = to_array(data->theories);
+    res["constructors"] = to_array(data->constructors);
+    res["sorts"] = to_array(data->sorts);
+    res["offsets"] = to_array(data->offsets);
+    res["children"] = to_array(data->children);
+    res["literals"] = to_array(data->literals);
+    res["roots"] = to_array(data->roots);
+    res["values"] = values;
+    res["externals"] = externals;
+    return res;
+  }, py::arg("terms"));
+
+  // text parsing: the signature lists the constructors usable in the text
+  m.def("parse_terms", [get_registry](const std::string& text, py::iterable signature, bool check, t_ctx_tm* registry) {
+    return parse_text<t_term_full_wrapper>(get_registry(registry), signature, check,
+      [&text](auto& parser, auto& on_term, auto& on_rule) { parser.parse(text, on_term, on_rule); });
+  }, py::arg("text"), py::arg("signature"), py::arg("check")=true, py::arg("registry")=static_cast<t_ctx_tm*>(nullptr));
+  m.def("parse_file", [get_registry](const std::string& path, py::iterable signature, bool check, t_ctx_tm* registry) {
+    return parse_text<t_term_full_wrapper>(get_registry(registry), signature, check,
+      [&path](auto& parser, auto& on_term, auto& on_rule) { parser.parse_file(path, on_term, on_rule); });
+  }, py::arg("path"), py::arg("signature"), py::arg("check")=true, py::arg("registry")=static_cast<t_ctx_tm*>(nullptr));
+
   py::class_<t_term_full_wrapper> (m, "t_term")
   .def("__repr__", [](t_term_full_wrapper _this) {
     t_print p;
@@ -490,16 +974,47 @@ void register_hrw(py::module &m) {
     using t_hash_ref = typename t_term_full::template t_hash_ref<false>;
     return t_hash_ref()(_this.m_content);
   })
-  .def("get_gid", [](t_term_full_wrapper _this) -> std::size_t {
-    using t_hash_ref = typename t_term_full::template t_hash_ref<true>;
-    return t_hash_ref()(_this.m_content);
-  })
-  .def(py::pickle(
+  .def("get_gid", [](t_term_full_wrapper _this) -> std::size_t { return _this.m_content->get_hash(); })
+  .def(py::pickle( // kept to load the terms pickled with the tuple format
     [](t_term_full_wrapper _this) { return t_term_dumps().translate(_this.m_content); },
-    [](py::tuple t) { return t_term_full_wrapper{t_term_loads(term_registry).translate(t)}; }
-  ));
+    [](py::tuple t) {
+      auto lock = lock_terms(term_registry);
+      return t_term_full_wrapper{t_term_loads(term_registry).translate(t)};
+    }
+  ))
+  .def("to_bytes", [](t_term_full_wrapper _this) {
+    t_term_binary_writer writer;
+    writer.add(_this.m_content);
+    return py::bytes(writer.bytes());
+  })
+  .def_static("from_bytes", [get_registry](py::bytes data, bool check, t_ctx_tm* registry) {
+    t_ctx_tm& reg = get_registry(registry);
+    auto lock = lock_terms(reg);
+    std::string buffer = data;
+    t_term_binary_reader reader(reg, buffer, check);
+    if(reader.roots().size() != 1) {
+      throw hrw::exception::binary_format("expected a single root");
+    }
+    return t_term_full_wrapper{reader.roots().front()};
+  }, py::arg("data"), py::arg("check")=true, py::arg("registry")=static_cast<t_ctx_tm*>(nullptr))
+  .def("__reduce__", [term_from_bytes](t_term_full_wrapper _this) {
+    py::list objects;
+    t_term_binary_writer writer{t_pyobj_codec(objects)};
+    writer.add(_this.m_content);
+    return py::make_tuple(term_from_bytes, py::make_tuple(py::bytes(writer.bytes()), objects));
+  });
 
   m.def("is_term_variable", [](t_term_full_wrapper _this) { return (std::get_if<t_variable>(&(_this.m_content->m_content)) != nullptr); });
+  m.def("get_value", [](t_term_full_wrapper _this) {
+    return std::visit([](auto& t) -> py::object {
+      using t_term_core = std::remove_cv_t<std::remove_reference_t<decltype(t)>>;
+      if constexpr(has_value_v<t_term_core>) {
+        return py::cast(t.get_value());
+      } else {
+        throw hrw::exception::generic("ERROR: the term is not a literal");
+      }
+    }, _this.m_content->m_content);
+  });
   m.def("get_subterms", [](t_term_full_wrapper _this) {
     py::list subterms;
     std::visit([&subterms](auto& t) {
@@ -547,6 +1062,36 @@ void register_hrw(py::module &m) {
       throw hrw::exception::generic(oss.str());
     }
   })
+  // direct access to the image of a variable bound to a single term, without instantiating the variable
+  .def("__contains__", [](t_substitution& _this, t_term_full_wrapper var) {
+    t_variable const * v = var.m_content->template get_if<t_variable>();
+    return (v != nullptr) && _this.contains(v);
+  })
+  .def("__getitem__", [](t_substitution& _this, t_term_full_wrapper var) {
+    t_variable const * v = var.m_content->template get_if<t_variable>();
+    std::optional<t_term_full_ref> res = (v != nullptr) ? _this.get_single(v) : std::nullopt;
+    if(!res.has_value()) { throw py::key_error("the variable is not bound to a single term"); }
+    return t_term_full_wrapper{*res};
+  })
+  .def("get", [](t_substitution& _this, t_term_full_wrapper var, py::object def) -> py::object {
+    t_variable const * v = var.m_content->template get_if<t_variable>();
+    std::optional<t_term_full_ref> res = (v != nullptr) ? _this.get_single(v) : std::nullopt;
+    return res.has_value() ? py::cast(t_term_full_wrapper{*res}) : def;
+  }, py::arg("var"), py::arg("default")=py::none())
+  // the value of the literal bound to a variable
+  .def("value", [](t_substitution& _this, t_term_full_wrapper var) {
+    t_variable const * v = var.m_content->template get_if<t_variable>();
+    std::optional<t_term_full_ref> res = (v != nullptr) ? _this.get_single(v) : std::nullopt;
+    if(!res.has_value()) { throw py::key_error("the variable is not bound to a single term"); }
+    return std::visit([](auto& t) -> py::object {
+      using t_term_core = std::remove_cv_t<std::remove_reference_t<decltype(t)>>;
+      if constexpr(has_value_v<t_term_core>) {
+        return py::cast(t.get_value());
+      } else {
+        throw hrw::exception::generic("ERROR: the image of the variable is not a literal");
+      }
+    }, (*res)->m_content);
+  })
   .def("__eq__", [](t_substitution& _this, t_substitution& other) { return t_substitution_equal()(_this, other); })
   .def("__hash__", [](t_substitution& _this) { return size_t(t_substitution_hash()(_this)); })
   ;
@@ -562,34 +1107,188 @@ void register_hrw(py::module &m) {
   //   return oss.str();
   // })
   // terms
-  .def("create_variable", [](t_ctx_tm* _this, std::string& s) { return t_term_full_wrapper{_this->create_vterm(s)}; })
+  .def("create_variable", [](t_ctx_tm* _this, std::string& s) {
+    auto lock = lock_terms(*_this);
+    return t_term_full_wrapper{_this->create_vterm(s)};
+  })
   .def("instantiate", [](t_ctx_tm* _this, t_term_full_wrapper t, t_substitution & subst) {
+    auto lock = lock_terms(*_this);
     return t_term_full_wrapper{_this->instantiate(t.m_content, subst)};
   })
-  .def("clear", &t_ctx_tm::clear)
+  .def("clear", [](t_ctx_tm* _this) {
+    auto lock = lock_terms(*_this);
+    _this->clear();
+  })
   ;
 
   m.attr("term_registry") = &term_registry;
 
 
   //////////////////////////////////////////
-  // 4. rewrite context
+  // 4. native guards
+  auto to_expr = [](py::handle obj) { return to_guard_expr<t_guard_expr, t_term_full_wrapper>(obj); };
+  auto op1 = [to_expr](hrw::guard::e_op op) {
+    return [to_expr, op](py::object e) { return t_guard_expr::apply(op, {to_expr(e)}); };
+  };
+  auto op2 = [to_expr](hrw::guard::e_op op) {
+    return [to_expr, op](py::object l, py::object r) { return t_guard_expr::apply(op, {to_expr(l), to_expr(r)}); };
+  };
+  auto op2r = [to_expr](hrw::guard::e_op op) {
+    return [to_expr, op](py::object r, py::object l) { return t_guard_expr::apply(op, {to_expr(l), to_expr(r)}); };
+  };
+  using e_op = hrw::guard::e_op;
+
+  py::class_<t_guard_expr>(m, "guard_expr")
+  .def(py::init(to_expr))
+  .def("__add__", op2(e_op::ADD)).def("__radd__", op2r(e_op::ADD))
+  .def("__sub__", op2(e_op::SUB)).def("__rsub__", op2r(e_op::SUB))
+  .def("__mul__", op2(e_op::MUL)).def("__rmul__", op2r(e_op::MUL))
+  .def("__floordiv__", op2(e_op::DIV)).def("__rfloordiv__", op2r(e_op::DIV))
+  .def("__truediv__", [to_expr](py::object l, py::object r) { return t_guard_expr::apply(e_op::DIV, {hrw::guard::to_float(to_expr(l)), to_expr(r)}); })
+  .def("__mod__", op2(e_op::MOD)).def("__rmod__", op2r(e_op::MOD))
+  .def("__neg__", op1(e_op::NEG))
+  .def("__eq__", op2(e_op::EQ)).def("__ne__", op2(e_op::NE))
+  .def("__lt__", op2(e_op::LT)).def("__le__", op2(e_op::LE))
+  .def("__gt__", op2(e_op::GT)).def("__ge__", op2(e_op::GE))
+  .def("__and__", op2(e_op::AND)).def("__rand__", op2r(e_op::AND))
+  .def("__or__", op2(e_op::OR)).def("__ror__", op2r(e_op::OR))
+  .def("__invert__", op1(e_op::NOT))
+  .def("length", op1(e_op::LENGTH))
+  .def("contains", op2(e_op::CONTAINS))
+  .def("startswith", op2(e_op::STARTS_WITH))
+  .def("endswith", op2(e_op::ENDS_WITH))
+  .def("to_int", op1(e_op::TO_INT))
+  .def("to_float", op1(e_op::TO_FLOAT))
+  .def("to_str", op1(e_op::TO_STRING))
+  .def("is_sort", [to_expr](py::object e, const std::string& sort) { return t_guard_expr::is_sort(to_expr(e), t_ctx_th::get_sort_id(sort)); })
+  .def("__bool__", [](py::object) -> bool { throw hrw::exception::guard_invalid("a guard expression has no truth value, use &, | and ~"); })
+  .attr("__hash__") = py::none();
+
+  py::class_<t_native_guard>(m, "native_guard")
+  .def(py::init<>())
+  .def("when", [to_expr](t_native_guard& _this, py::object cond) -> t_native_guard& { return _this.when(to_expr(cond)); }, py::return_value_policy::reference_internal)
+  .def("bind", [to_expr](t_native_guard& _this, t_term_full_wrapper var, py::object constructor, py::object value) -> t_native_guard& {
+    return _this.bind(var.m_content, to_constructor_key(constructor), to_expr(value));
+  }, py::return_value_policy::reference_internal)
+  ;
+
+
+  //////////////////////////////////////////
+  // 5. rewrite context
+  static py::exception<hrw::exception::rw_limit> rw_limit_exception(m, "RewriteLimit");
   m.def("check_rule", [](t_term_full_wrapper pattern, t_term_full_wrapper image) { return vbind_check<t_variable, t_term_full_ref>(pattern.m_content, image.m_content); });
 
   auto py_ctx_rw = py::class_<t_ctx_rw> (m, "context_rw")
-    .def(py::init<t_ctx_tm&>())
-    .def("add", [](t_ctx_rw* _this, t_term_full_wrapper pattern, t_term_full_wrapper image) { _this->template add<rw_strict_sorting>(pattern.m_content, image.m_content); })
-    .def("add", [](t_ctx_rw* _this, t_term_full_wrapper pattern, t_term_full_wrapper image, typename t_ctx_rw::t_guard guard) { _this->template add<rw_strict_sorting>(pattern.m_content, image.m_content, guard); })
-    .def("add", [](t_ctx_rw* _this, t_ctx_rw const & other) { _this->add(other); })
-    .def("clear", &t_ctx_rw::clear)
-    .def("clear_nf", &t_ctx_rw::clear_nf)
-    .def("rewrite", [](t_ctx_rw* _this, t_term_full_wrapper t) { return t_term_full_wrapper{_this->template rewrite<rw_strategy>(t.m_content)}; })
+    .def(py::init<t_ctx_tm&>(), py::keep_alive<1, 2>())
+    .def("add", [](t_ctx_rw* _this, t_term_full_wrapper pattern, t_term_full_wrapper image) {
+      auto lock = lock_terms(_this->get_ctx_term());
+      _this->template add<rw_strict_sorting>(pattern.m_content, image.m_content);
+    })
+    .def("add", [](t_ctx_rw* _this, t_term_full_wrapper pattern, t_term_full_wrapper image, const t_native_guard& guard) {
+      auto lock = lock_terms(_this->get_ctx_term());
+      _this->template add<rw_strict_sorting>(pattern.m_content, image.m_content, typename t_ctx_rw::t_guard(guard));
+    })
+    .def("add", [](t_ctx_rw* _this, t_term_full_wrapper pattern, t_term_full_wrapper image, py::function guard) {
+      auto lock = lock_terms(_this->get_ctx_term());
+      _this->template add<rw_strict_sorting>(pattern.m_content, image.m_content, typename t_ctx_rw::t_guard(t_py_guard<t_ctx_rw, t_substitution>(guard)));
+    })
+    .def("add", [](t_ctx_rw* _this, t_ctx_rw const & other) {
+      auto lock = lock_terms(_this->get_ctx_term());
+      _this->add(other);
+    })
+    .def("clear", [](t_ctx_rw* _this) {
+      auto lock = lock_terms(_this->get_ctx_term());
+      _this->clear();
+    })
+    .def("clear_nf", [](t_ctx_rw* _this) {
+      auto lock = lock_terms(_this->get_ctx_term());
+      _this->clear_nf();
+    })
+    .def("rewrite", [](t_ctx_rw* _this, t_term_full_wrapper t, long long nb_steps) {
+      auto lock = lock_terms(_this->get_ctx_term());
+      auto run = [&]() {
+        if(nb_steps < 0) {
+          return t_term_full_wrapper{_this->template rewrite<rw_strategy>(t.m_content)};
+        } else {
+          return t_term_full_wrapper{_this->template rewrite<rw_strategy>(t.m_content, to_budget(nb_steps))};
+        }
+      };
+      if(_this->has_guard()) { // the guards are python functions
+        return run();
+      } else {
+        // without guard, no python code is executed: the python literals are compared by identity, and their hash takes the GIL
+        py::gil_scoped_release release;
+        return run();
+      }
+    }, py::arg("t"), py::arg("nb_steps")=-1)
+    // the rewriting is queued on the workers, and its result is set in a concurrent.futures.Future (awaitable with asyncio.wrap_future).
+    // Cancelling the future sets the step budget of the rewriting to 0, which then stops at its next rule application
+    .def("rewrite_async", [](py::object self, t_term_full_wrapper t, long long nb_steps) {
+      using t_state = t_async_rewrite<t_term_full_ref>;
+      t_ctx_rw* _this = self.cast<t_ctx_rw*>();
+      auto budget = std::make_shared<std::atomic<unsigned int>>(to_budget(nb_steps));
+      py::object future = py::module::import("concurrent.futures").attr("Future")();
+      future.attr("add_done_callback")(py::cpp_function([budget](py::object f) {
+        if(f.attr("cancelled")().cast<bool>()) { budget->store(0, std::memory_order_relaxed); }
+      }));
+      t_state* state = [&]() {
+        auto lock = lock_terms(_this->get_ctx_term());
+        return new t_state{self, future, t.m_content, budget};
+      }();
+
+      async_pool().submit([_this, state]() {
+        t_ctx_tm& ctx = _this->get_ctx_term();
+        std::optional<t_term_full_ref> res;
+        std::exception_ptr error;
+        auto run = [&]() {
+          try {
+            res = _this->template rewrite<rw_strategy>(*state->m_term, *state->m_budget);
+          } catch(...) {
+            error = std::current_exception();
+          }
+        };
+        std::unique_lock<std::recursive_mutex> lock(ctx.m_mutex);
+        if(!_this->has_guard()) {
+          run();
+          lock.unlock();
+        } else { // the guards are python functions
+          lock.unlock();
+          py::gil_scoped_acquire gil;
+          auto lock_gil = lock_terms(ctx);
+          run();
+        }
+
+        py::gil_scoped_acquire gil;
+        auto lock_release = lock_terms(ctx);
+        if(!state->m_future.attr("done")().cast<bool>()) {
+          if(res.has_value()) {
+            state->m_future.attr("set_result")(t_term_full_wrapper{*res});
+          } else {
+            try {
+              std::rethrow_exception(error);
+            } catch(hrw::exception::rw_limit const & e) {
+              state->m_future.attr("set_exception")(py::reinterpret_borrow<py::object>(rw_limit_exception)(e.what()));
+            } catch(py::error_already_set const & e) {
+              state->m_future.attr("set_exception")(e.value());
+            } catch(std::exception const & e) {
+              state->m_future.attr("set_exception")(py::reinterpret_borrow<py::object>(PyExc_RuntimeError)(e.what()));
+            } catch(...) {
+              state->m_future.attr("set_exception")(py::reinterpret_borrow<py::object>(PyExc_RuntimeError)("unknown error in an asynchronous rewriting"));
+            }
+          }
+        }
+        error = nullptr;
+        res.reset();
+        delete state;
+      });
+      return future;
+    }, py::arg("t"), py::arg("nb_steps")=-1)
     .def("get_count", &t_ctx_rw::get_rw_count)
     ;
 
 
   //////////////////////////////////////////
-  // 5. conclude
+  // 6. conclude
   using th_free_construct = hrw::exception::th_free_construct<t_term_full_ref>;
   static py::exception<th_free_construct> term_error_exception(m, "TermError");
   py::register_exception_translator([](std::exception_ptr p) {
@@ -597,6 +1296,8 @@ void register_hrw(py::module &m) {
       if(p) { std::rethrow_exception(p); }
     } catch (th_free_construct const & e) {
       term_error_exception(e.get_spec_got().c_str());
+    } catch (hrw::exception::rw_limit const & e) {
+      rw_limit_exception(e.what());
     }
   });
 
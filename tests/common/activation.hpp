@@ -24,6 +24,7 @@
 
 
 #define ENABLE_UTILS_CONTAINER   1
+#define ENABLE_UTILS_FLAT_HASH   1
 #define ENABLE_UTILS_GRAPH       1
 #define ENABLE_UTILS_HASH        1
 #define ENABLE_UTILS_ITERATOR    1
@@ -31,6 +32,7 @@
 #define ENABLE_UTILS_TYPE_TRAITS 1
 
 #define ENABLE_PARSING_INCLUSION 1
+#define ENABLE_PARSING_INTERN    1
 #define ENABLE_PARSING_MATCH     1
 #define ENABLE_PARSING_TRIGGER   1
 
@@ -39,6 +41,7 @@
 #define ENABLE_THEORY_LITERAL    1
 #define ENABLE_THEORY_VARIABLE   1
 
+#define ENABLE_CONTEXT_SORT      1
 #define ENABLE_HTERM             1
 #define ENABLE_HREWRITE          1
 
@@ -0,0 +1,112 @@
+/*
+ * This file is part of the hrewrite library.
+ * Copyright (c) 2021 ONERA.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+ // Author: Michael Lienhardt
+ // Maintainer: Michael Lienhardt
+ // email: michael.lienhardt@onera.fr
+
+#include "tests/common/activation.hpp"
+#if ENABLE_CONTEXT_SORT
+
+#include "doctest/doctest.h"
+#include "tests/common/debug.hpp"
+
+#include "hrewrite/utils.hpp"
+#include "hrewrite/context_sort.hpp"
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <random>
+
+using hrw::t_sort_id;
+
+
+template<typename t_ctx_sort>
+void check_subsort(t_ctx_sort& ctx) {
+  ctx.clear();
+  t_sort_id a = ctx.add_sort("a");
+  t_sort_id b = ctx.add_sort("b");
+  t_sort_id c = ctx.add_sort("c");
+  t_sort_id d = ctx.add_sort("d");
+
+  // lookup by name
+  CHECK(ctx.contains(std::string_view("c")));
+  CHECK_FALSE(ctx.contains("f"));
+  CHECK_EQ(ctx.get_letter(std::string("d")), d);
+  CHECK_EQ(ctx.add_sort("b"), b);
+
+  ctx.add_subsort(a, b);
+  CHECK(ctx.is_subsort(a, a));
+  CHECK(ctx.is_subsort(a, b));
+  CHECK_FALSE(ctx.is_subsort(b, a));
+  CHECK_FALSE(ctx.is_subsort(a, c));
+
+  // the closure is updated after a new subsort relation
+  ctx.add_subsort("b", "c");
+  CHECK(ctx.is_subsort(a, c));
+  CHECK(ctx.is_subsort("b", "c"));
+  CHECK_FALSE(ctx.is_subsort(d, c));
+  CHECK_FALSE(ctx.is_subsort(c, a));
+
+  // and after a new sort
+  t_sort_id e = ctx.add_sort("e");
+  ctx.add_subsort(c, e);
+  CHECK(ctx.is_subsort(a, e));
+  CHECK(ctx.is_subsort(e, e));
+  CHECK_FALSE(ctx.is_subsort(d, e));
+}
+
+
+TEST_CASE("context_sort") {
+  std::cout << "==================================================================\n";
+  std::cout << "= context_sort\n";
+
+  using t_sparse = hrw::context_sort<hrw::utils::natset>;
+  using t_dense  = hrw::context_sort<hrw::utils::natset, true>;
+
+  t_sparse ctx_sparse;
+  t_dense  ctx_dense;
+  check_subsort(ctx_sparse);
+  check_subsort(ctx_dense);
+
+  // random hierarchy: both representations must agree
+  ctx_sparse.clear();
+  ctx_dense.clear();
+  constexpr unsigned int nb_sorts = 60;
+  for(unsigned int i = 0; i < nb_sorts; ++i) {
+    ctx_sparse.add_sort("s" + std::to_string(i));
+    ctx_dense.add_sort("s" + std::to_string(i));
+  }
+  std::mt19937 gen(42);
+  std::uniform_int_distribution<unsigned int> dist(0, nb_sorts - 1);
+  for(unsigned int i = 0; i < 80; ++i) {
+    unsigned int s1 = dist(gen), s2 = dist(gen);
+    if(s1 < s2) { // keeps the hierarchy acyclic
+      ctx_sparse.add_subsort(s1, s2);
+      ctx_dense.add_subsort(s1, s2);
+    }
+  }
+  for(unsigned int s1 = 0; s1 < nb_sorts; ++s1) {
+    for(unsigned int s2 = 0; s2 < nb_sorts; ++s2) {
+      CHECK_EQ(ctx_sparse.is_subsort(s1, s2), ctx_dense.is_subsort(s1, s2));
+    }
+  }
+}
+
+
+#endif
@@ -42,6 +42,9 @@ using namespace hrw;
 #include <unordered_map>
 #include <iostream>
 #include <string>
+#include <thread>
+#include <fstream>
+#include <cstdio>
 
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -52,10 +55,13 @@ using namespace hrw;
 // 1. list of term registry
 
 template<typename ... Args> using unordered_set_wrapper = std::unordered_set<Args...>;
+template<typename ... Args> using flat_set_wrapper = hrw::utils::flat_hash_set<Args...>;
 
 using t_term_registry_list = term_registry_list<
-  hrw::utils::registry_unique<unordered_set_wrapper, true, false>
-  // hrw::utils::registry_unique<unordered_set_wrapper, true, true>
+  hrw::utils::registry_unique<unordered_set_wrapper, true, false>,
+  hrw::utils::registry_arena<flat_set_wrapper>,
+  hrw::utils::registry_concurrent<unordered_set_wrapper>,
+  hrw::utils::registry_unique<unordered_set_wrapper, true, true>
   // hrw::utils::registry_shared
 >;
 
@@ -64,8 +70,9 @@ using t_term_registry_list = term_registry_list<
 // 2. list of map for term refs
 
 template<typename ... Args> using my_umap = std::unordered_map<Args...>;
+template<typename ... Args> using my_fmap = hrw::utils::flat_hash_map<Args...>;
 
-using t_map_list = map_list<my_umap>;
+using t_map_list = map_list<my_umap, my_fmap>;
 // using t_map_list = map_list<my_umap, my_rmap>;
 
 
@@ -105,20 +112,20 @@ template<typename t_alphabet, const t_alphabet& alphabet>
 using t_sparser = utils::combine_variant<t_alphabet, alphabet, utils::sequence, my_automata>;
 
 // using t_structured_theory_list_list = std::tuple<
-//   structured_theory_list<hrw::theory::tp_theory_free<std::vector, t_sparser>::template type>,
+//   structured_theory_list<hrw::theory::tp_theory_free<hrw::utils::small_vector_default, t_sparser>::template type>,
 //   structured_theory_list<hrw::theory::tp_theory_literal<int>::template type>
 // >;
 
 using t_structured_theory_list_list = std::tuple<
-  // structured_theory_list<hrw::theory::tp_theory_free<std::vector, t_sparser>::template type>,
+  // structured_theory_list<hrw::theory::tp_theory_free<hrw::utils::small_vector_default, t_sparser>::template type>,
   // structured_theory_list<hrw::theory::tp_theory_leaf::template type>,
   // structured_theory_list<hrw::theory::tp_theory_literal<int>::template type>,
   // structured_theory_list<
-  //   hrw::theory::tp_theory_free<std::vector, t_sparser>::template type,
+  //   hrw::theory::tp_theory_free<hrw::utils::small_vector_default, t_sparser>::template type,
   //   hrw::theory::tp_theory_literal<int>::template type
   // >
   structured_theory_list<
-    hrw::theory::tp_theory_free<std::vector, t_sparser>::template type,
+    hrw::theory::tp_theory_free<hrw::utils::small_vector_default, t_sparser>::template type,
     hrw::theory::tp_theory_literal<int>::template type,
     hrw::theory::tp_theory_literal<double>::template type,
     hrw::theory::tp_theory_leaf::template type
@@ -130,11 +137,20 @@ using t_structured_theory_list_list = std::tuple<
 //// GENERIC TESTING SETUP
 ////////////////////////////////////////////////////////////////////////////////
 
+// the arena registries share their store between instances, so their universes cannot be built in parallel
+template<typename T> struct is_registry_arena: public std::false_type {};
+template<template<typename ... Args> typename tt_set> struct is_registry_arena<hrw::utils::registry_arena<tt_set>>: public std::true_type {};
+
+// literal values of the bulk construction
+struct bulk_values {
+  template<typename T> T get(std::size_t k) { return T(9001 + k); }
+};
+
 template<typename config, typename can_run=void> struct test_all;
 
 template<typename config>
 struct test_all<config, std::enable_if_t<
-    !is_valid_sth_v<hrw::theory::tp_theory_free<std::vector, t_sparser>::template type, config>
+    !is_valid_sth_v<hrw::theory::tp_theory_free<hrw::utils::small_vector_default, t_sparser>::template type, config>
     || !is_valid_sth_v<hrw::theory::tp_theory_literal<int>::template type, config>
     || !is_valid_sth_v<hrw::theory::tp_theory_literal<double>::template type, config>
     || !is_valid_sth_v<hrw::theory::tp_theory_leaf::template type, config>
@@ -143,7 +159,7 @@ struct test_all<config, std::enable_if_t<
 
 template<typename config>
 struct test_all<config, std::enable_if_t<
-    is_valid_sth_v<hrw::theory::tp_theory_free<std::vector, t_sparser>::template type, config>
+    is_valid_sth_v<hrw::theory::tp_theory_free<hrw::utils::small_vector_default, t_sparser>::template type, config>
     && is_valid_sth_v<hrw::theory::tp_theory_literal<int>::template type, config>
     && is_valid_sth_v<hrw::theory::tp_theory_literal<double>::template type, config>
     && is_valid_sth_v<hrw::theory::tp_theory_leaf::template type, config>
@@ -163,7 +179,7 @@ struct test_all<config, std::enable_if_t<
 
   using t_print = typename t_hrewrite::t_print;
 
-  using t_theory_free = get_stheory_t<hrw::theory::tp_theory_free<std::vector, t_sparser>::template type, config>;
+  using t_theory_free = get_stheory_t<hrw::theory::tp_theory_free<hrw::utils::small_vector_default, t_sparser>::template type, config>;
   using t_theory_lit_int = get_stheory_t<hrw::theory::tp_theory_literal<int>::template type, config>;
   using t_theory_lit_double = get_stheory_t<hrw::theory::tp_theory_literal<double>::template type, config>;
   using t_theory_leaf = get_stheory_t<hrw::theory::tp_theory_leaf::template type, config>;
@@ -361,6 +377,21 @@ struct test_all<config, std::enable_if_t<
     CHECK(s.contains(pv_alpha));
     CHECK(s.contains(pv_beta));
     CHECK(s.contains(pv_gamma));
+
+    // direct access to the images bound to single terms
+    {
+      using t_eq = typename t_term_full::template t_eq<true>;
+      auto to_ptr = [](const t_term_full_ref& t) { return t_term_full::make_ptr_struct::to_ptr(t); };
+      std::optional<t_term_full_ref> im_alpha = s.get_single(pv_alpha);
+      std::optional<t_term_full_ref> im_gamma = s.get_single(pv_gamma);
+      REQUIRE(im_alpha.has_value());
+      REQUIRE(im_gamma.has_value());
+      CHECK(t_eq()(*to_ptr(*im_alpha), *to_ptr(plus)));
+      CHECK(t_eq()(*to_ptr(*im_gamma), *to_ptr(three)));
+      t_term_full_ref delta (ctx_tm.create_vterm("int"));
+      const t_variable* pv_delta = &(std::get<t_variable>(delta->m_content));
+      CHECK_FALSE(s.get_single(pv_delta).has_value());
+    }
     bool good = true;
     if(!s.contains(pv_alpha)) {
       std::cout << "no image for alpha!" << std::endl;
@@ -461,6 +492,304 @@ struct test_all<config, std::enable_if_t<
 
   }
 
+  void test_binary() {
+    std::cout << "= hrewrite - binary\n";
+    t_ctx_tm ctx_tm;
+    using t_eq = typename t_term_full::template t_eq<true>;
+    auto to_ptr = [](const t_term_full_ref& t) { return t_term_full::make_ptr_struct::to_ptr(t); };
+
+    t_term_full_ref zero  (ctx_tm.create_sterm(c_zero));
+    t_term_full_ref two   (ctx_tm.create_sterm(c_succ, t_container({ctx_tm.create_sterm(c_succ, t_container({zero}))})));
+    t_term_full_ref huge  (ctx_tm.create_sterm(c_value_int, 9001));
+    t_term_full_ref plus  (ctx_tm.create_sterm(c_plus, t_container({
+      ctx_tm.create_sterm(c_plus, t_container({two, huge})),
+      ctx_tm.create_sterm(c_plus, t_container({two, two}))
+    })));
+    t_term_full_ref print (ctx_tm.create_sterm(c_print, t_container({plus})));
+    t_term_full_ref huged (ctx_tm.create_sterm(c_value_double, 9001.5));
+
+    for(bool check: {true, false}) {
+      t_term_full_ref res = hrw::term_from_bytes(ctx_tm, hrw::term_to_bytes<t_ctx_tm>(print), check);
+      CHECK(t_eq()(*to_ptr(res), *to_ptr(print)));
+      if constexpr(t_ctx_tm::ensure_unique_v) {
+        CHECK_EQ(to_ptr(res), to_ptr(print));
+      }
+    }
+
+    // shared subterms are written once, and several roots can be stored together
+    hrw::term_binary_writer<t_ctx_tm> writer;
+    CHECK_EQ(writer.add(zero), 0);
+    std::uint32_t idx_two = writer.add(two);
+    CHECK_EQ(idx_two, 2);
+    CHECK_EQ(writer.add(two), idx_two);
+    writer.add(huged);
+    std::string data = writer.bytes();
+    hrw::term_binary_reader<t_ctx_tm> reader(ctx_tm, data);
+    CHECK_EQ(reader.roots().size(), 4);
+    CHECK(t_eq()(*to_ptr(reader.roots()[1]), *to_ptr(two)));
+    CHECK_EQ(to_ptr(reader.roots()[1]), to_ptr(reader.roots()[2]));
+    CHECK(t_eq()(*to_ptr(reader.roots()[3]), *to_ptr(huged)));
+
+    // variables are recreated, and shared
+    t_term_full_ref alpha (ctx_tm.create_vterm("int"));
+    t_term_full_ref pattern (ctx_tm.create_sterm(c_plus, t_container({alpha, alpha})));
+    t_term_full_ref pattern_res = hrw::term_from_bytes(ctx_tm, hrw::term_to_bytes<t_ctx_tm>(pattern));
+    auto const * pattern_term = to_ptr(pattern_res)->template get_if<typename t_theory_free::template tt_term<t_term_full>>();
+    REQUIRE(pattern_term != nullptr);
+    t_term_full_ref alpha_res = pattern_term->get_subterms()[0];
+    CHECK_EQ(to_ptr(alpha_res), to_ptr(pattern_term->get_subterms()[1]));
+    CHECK_NE(to_ptr(alpha_res), to_ptr(alpha));
+    CHECK(!alpha_res->is_structured());
+    CHECK_EQ(alpha_res->get_spec(), alpha->get_spec());
+
+    // malformed data
+    for(std::string_view wrong: {std::string_view(data).substr(0, data.size() - 1), std::string_view(data), std::string_view("0123456789")}) {
+      try {
+        hrw::term_from_bytes(ctx_tm, wrong);
+        CHECK(false);
+      } catch(hrw::exception::binary_format const& e) {}
+    }
+  }
+
+  void test_bulk() {
+    std::cout << "= hrewrite - bulk\n";
+    t_ctx_tm ctx_tm;
+    using t_eq = typename t_term_full::template t_eq<true>;
+    using t_index = hrw::term_bulk::t_index;
+    auto to_ptr = [](const t_term_full_ref& t) { return t_term_full::make_ptr_struct::to_ptr(t); };
+
+    const t_index th_free = ctx_th::template theory_index_v<t_theory_free>;
+    const t_index th_leaf = ctx_th::template theory_index_v<t_theory_leaf>;
+    const t_index th_int  = ctx_th::template theory_index_v<t_theory_lit_int>;
+    const t_index th_ext  = hrw::term_bulk::external;
+    CHECK(hrw::term_bulk_builder<t_ctx_tm>::has_subterms(th_free));
+    CHECK(!hrw::term_bulk_builder<t_ctx_tm>::has_subterms(th_int));
+    CHECK(hrw::term_bulk_builder<t_ctx_tm>::has_value(th_int));
+    CHECK(!hrw::term_bulk_builder<t_ctx_tm>::has_value(th_leaf));
+
+    // plus(plus(succ(zero), int[9001]), plus(succ(zero), alpha))
+    t_term_full_ref alpha (ctx_tm.create_vterm("int"));
+    std::vector<t_index> theories     = {th_leaf, th_free, th_int, th_free, th_ext, th_free, th_free};
+    std::vector<t_index> constructors = {c_zero.id(), c_succ.id(), c_value_int.id(), c_plus.id(), 0, c_plus.id(), c_plus.id()};
+    std::vector<t_index> offsets      = {0, 0, 1, 1, 3, 3, 5, 7};
+    std::vector<t_index> children     = {0, 1, 2, 1, 4, 3, 5};
+    hrw::term_bulk desc{theories.size(), children.size(), theories.data(), constructors.data(), offsets.data(), children.data()};
+
+    t_term_full_ref one (ctx_tm.create_sterm(c_succ, t_container({ctx_tm.create_sterm(c_zero)})));
+    t_term_full_ref expected (ctx_tm.create_sterm(c_plus, t_container({
+      ctx_tm.create_sterm(c_plus, t_container({one, ctx_tm.create_sterm(c_value_int, 9001)})),
+      ctx_tm.create_sterm(c_plus, t_container({one, alpha}))
+    })));
+
+    for(bool check: {true, false}) {
+      hrw::term_bulk_builder<t_ctx_tm> builder(ctx_tm);
+      std::vector<t_term_full_ref> res = builder.build(desc, {alpha}, bulk_values(), check);
+      REQUIRE(res.size() == theories.size());
+      CHECK(t_eq()(*to_ptr(res.back()), *to_ptr(expected)));
+      CHECK_EQ(to_ptr(res[4]), to_ptr(alpha));
+    }
+
+    // the export of expected gives back the same shared nodes, and builds the same term
+    {
+      hrw::term_bulk_exporter<t_ctx_tm> exporter;
+      std::vector<int> values;
+      auto on_value = [&values](const auto& v) { values.push_back(static_cast<int>(v)); };
+      t_index root = exporter.add(expected, on_value);
+      CHECK_EQ(exporter.add(one, on_value), 1);
+      hrw::term_bulk_data& data = exporter.data();
+      REQUIRE(data.theories.size() == 7);
+      CHECK_EQ(root, 6);
+      CHECK_EQ(data.offsets.size(), 8);
+      CHECK_EQ(data.children.size(), 7);
+      CHECK_EQ(data.roots.size(), 2);
+      CHECK_EQ(data.sorts[root], sort_int);
+      CHECK_EQ(values.size(), 1);
+      CHECK_EQ(values[0], 9001);
+      REQUIRE(exporter.externals().size() == 1);
+      CHECK_EQ(to_ptr(exporter.externals()[0]), to_ptr(alpha));
+      std::size_t nb_literals = 0;
+      for(std::size_t i = 0; i < data.theories.size(); ++i) {
+        CHECK_EQ((data.theories[i] == th_ext), (data.sorts[i] == th_ext));
+        if(data.literals[i] != th_ext) { ++nb_literals; }
+      }
+      CHECK_EQ(nb_literals, 1);
+
+      hrw::term_bulk_builder<t_ctx_tm> builder(ctx_tm);
+      std::vector<t_term_full_ref> res = builder.build(data.description(), exporter.externals(), bulk_values());
+      CHECK(t_eq()(*to_ptr(res[root]), *to_ptr(expected)));
+    }
+
+    // errors are found before any term is created
+    hrw::term_bulk_builder<t_ctx_tm> builder(ctx_tm);
+    auto check_error = [&](std::size_t node) {
+      try {
+        builder.build(desc, {alpha}, bulk_values());
+        CHECK(false);
+      } catch(hrw::exception::bulk_format const& e) {
+        CHECK_EQ(e.get_node(), node);
+      }
+    };
+    children[1] = 3;
+    check_error(3);
+    children[1] = 1;
+    constructors[4] = 1;
+    check_error(4);
+    constructors[4] = 0;
+    theories[1] = th_leaf;
+    check_error(1);
+    theories[1] = th_free;
+
+    // type-checking: succ with two subterms
+    constructors[6] = c_succ.id();
+    try {
+      builder.build(desc, {alpha}, bulk_values());
+      CHECK(false);
+    } catch(hrw::exception::th_free_construct<t_term_full_ref> const& e) {}
+    std::vector<t_term_full_ref> res = builder.build(desc, {alpha}, bulk_values(), false);
+    CHECK_EQ(res.back()->get_constructor(), c_succ.id());
+  }
+
+  void test_universes() {
+    if constexpr(!is_registry_arena<typename config::t_term_registry>::value) {
+      std::cout << "= hrewrite - parallel universes\n";
+      constexpr unsigned int nb_universes = 4;
+      std::vector<char> results(nb_universes, 0);
+      auto run_universe = [this, &results](unsigned int id) {
+        t_ctx_tm ctx_tm;
+        t_ctx_rw ctx_rw(ctx_tm);
+        t_term_full_ref alpha (ctx_tm.create_vterm("int"));
+        t_term_full_ref beta  (ctx_tm.create_vterm("int"));
+        t_term_full_ref zero  (ctx_tm.create_sterm(this->c_zero));
+        auto incr = [&](t_term_full_ref t) { return ctx_tm.create_sterm(this->c_succ, t_container({t})); };
+        ctx_rw.add(ctx_tm.create_sterm(this->c_plus, t_container({zero, alpha})), alpha);
+        ctx_rw.add(ctx_tm.create_sterm(this->c_plus, t_container({incr(alpha), beta})), ctx_tm.create_sterm(this->c_plus, t_container({alpha, incr(beta)})));
+
+        t_term_full_ref lhs (zero), expected (zero);
+        for(unsigned int i = 0; i < 50 + id; ++i) { lhs = incr(lhs); expected = incr(expected); }
+        for(unsigned int i = 0; i < 50; ++i) { expected = incr(expected); }
+        t_term_full_ref rhs (zero);
+        for(unsigned int i = 0; i < 50; ++i) { rhs = incr(rhs); }
+        results[id] = (ctx_rw.rewrite(ctx_tm.create_sterm(this->c_plus, t_container({lhs, rhs}))) == expected);
+      };
+      std::vector<std::thread> threads;
+      for(unsigned int id = 0; id < nb_universes; ++id) {
+        threads.emplace_back(run_universe, id);
+      }
+      for(std::thread& t: threads) { t.join(); }
+      for(unsigned int id = 0; id < nb_universes; ++id) {
+        CHECK(results[id]);
+      }
+    }
+  }
+
+  void test_async() {
+    std::cout << "= hrewrite - budget and asynchronous rewriting\n";
+    using t_eq = typename t_term_full::template t_eq<true>;
+    auto to_ptr = [](const t_term_full_ref& t) { return t_term_full::make_ptr_struct::to_ptr(t); };
+    t_ctx_tm ctx_tm;
+    t_ctx_rw ctx_rw(ctx_tm);
+    t_term_full_ref alpha (ctx_tm.create_vterm("int"));
+    t_term_full_ref beta  (ctx_tm.create_vterm("int"));
+    t_term_full_ref zero  (ctx_tm.create_sterm(c_zero));
+    auto incr = [&](t_term_full_ref t) { return ctx_tm.create_sterm(c_succ, t_container({t})); };
+    ctx_rw.add(ctx_tm.create_sterm(c_plus, t_container({zero, alpha})), alpha);
+    ctx_rw.add(ctx_tm.create_sterm(c_plus, t_container({incr(alpha), beta})), ctx_tm.create_sterm(c_plus, t_container({alpha, incr(beta)})));
+    t_term_full_ref three (incr(incr(incr(zero))));
+    t_term_full_ref six   (incr(incr(incr(three))));
+    auto make_plus = [&]() { return ctx_tm.create_sterm(c_plus, t_container({three, three})); };
+
+    // 3 + 3 needs 4 rule applications
+    bool thrown = false;
+    try {
+      ctx_rw.rewrite(make_plus(), 3);
+    } catch(hrw::exception::rw_limit const&) { thrown = true; }
+    CHECK(thrown);
+    CHECK_EQ(ctx_rw.get_rw_count(), 3);
+    CHECK(t_eq()(*to_ptr(ctx_rw.rewrite(make_plus(), 4)), *to_ptr(six)));
+
+    hrw::utils::thread_pool pool(2);
+    std::mutex mutex;
+    auto job = hrw::rewrite_async(pool, ctx_rw, mutex, make_plus());
+    CHECK(t_eq()(*to_ptr(job.get()), *to_ptr(six)));
+
+    // a job cancelled before it runs stops at its first rule application
+    t_term_full_ref nine (ctx_tm.create_sterm(c_plus, t_container({six, three})));
+    std::unique_lock<std::mutex> lock(mutex);
+    auto cancelled = hrw::rewrite_async(pool, ctx_rw, mutex, nine);
+    cancelled.cancel();
+    lock.unlock();
+    thrown = false;
+    try {
+      cancelled.get();
+    } catch(hrw::exception::rw_limit const&) { thrown = true; }
+    CHECK(thrown);
+  }
+
+  void test_text() {
+    std::cout << "= hrewrite - text\n";
+    using t_eq = typename t_term_full::template t_eq<true>;
+    auto to_ptr = [](const t_term_full_ref& t) { return t_term_full::make_ptr_struct::to_ptr(t); };
+    t_ctx_tm ctx_tm;
+    t_ctx_rw ctx_rw(ctx_tm);
+    hrw::term_text_parser<t_ctx_tm> parser(ctx_tm);
+    parser.declare(c_zero);
+    parser.declare(c_succ);
+    parser.declare(c_plus);
+    parser.declare(c_sum);
+    parser.declare(ctx_th::template theory_index_v<t_theory_lit_int>, c_value_int.id());
+    parser.declare(c_value_double);
+
+    std::vector<t_term_full_ref> terms;
+    auto on_term = [&terms](t_term_full_ref t) { terms.push_back(t); };
+    auto on_rule = [&ctx_rw](t_term_full_ref pattern, t_term_full_ref image) { ctx_rw.add(pattern, image); };
+    parser.parse(
+      "; addition on peano integers\n"
+      "(=> (plus zero ?x:int) ?x)\n"
+      "(=> (plus (succ ?x:int) ?y:\"int\") (plus ?x (succ ?y)))\n"
+      "(plus (succ (succ zero)) (succ zero)) (sum (int 9001) (int -3) zero) (double 1.5)",
+      on_term, on_rule);
+    REQUIRE(terms.size() == 3);
+    t_term_full_ref zero (ctx_tm.create_sterm(c_zero));
+    auto incr = [&](t_term_full_ref t) { return ctx_tm.create_sterm(c_succ, t_container({t})); };
+    t_term_full_ref three (incr(incr(incr(zero))));
+    CHECK(t_eq()(*to_ptr(ctx_rw.rewrite(terms[0])), *to_ptr(three)));
+    CHECK_EQ(to_ptr(terms[1]), to_ptr(ctx_tm.create_sterm(c_sum, t_container({ctx_tm.create_sterm(c_value_int, 9001), ctx_tm.create_sterm(c_value_int, -3), zero}))));
+    CHECK_EQ(to_ptr(terms[2]), to_ptr(ctx_tm.create_sterm(c_value_double, 1.5)));
+
+    // the same text read from a file
+    std::string path = "hrewrite_test_text.txt";
+    {
+      std::ofstream out(path);
+      out << "(succ (succ (succ zero)))\n";
+    }
+    terms.clear();
+    parser.parse_file(path, on_term, on_rule);
+    std::remove(path.c_str());
+    REQUIRE(terms.size() == 1);
+    CHECK(t_eq()(*to_ptr(terms[0]), *to_ptr(three)));
+
+    // errors give the position of the faulty part of the text
+    auto check_error = [&](const std::string& text, std::size_t line, std::size_t column) {
+      try {
+        parser.parse(text, on_term, on_rule);
+        CHECK(false);
+      } catch(hrw::exception::text_format const& e) {
+        CHECK_EQ(e.get_line(), line);
+        CHECK_EQ(e.get_column(), column);
+      }
+    };
+    check_error("(succ zero)\n(succ one)", 2, 7);
+    check_error("(plus zero", 1, 1);
+    check_error("(succ zero))", 1, 12);
+    check_error("(int 1.5)", 1, 6);
+    check_error("(int)", 1, 5);
+    check_error("(zero zero)", 1, 1);
+    check_error("(plus ?x zero)", 1, 7);
+    check_error("(plus ?x:int ?x:double)", 1, 14);
+    check_error("(=> zero)", 1, 1);
+    check_error("(succ \"zero)", 1, 7);
+  }
+
   // 5. wrap up
   void run() {
     std::cout << "  - main" << std::endl;
@@ -468,6 +797,11 @@ struct test_all<config, std::enable_if_t<
     this->test_term_creation();
     this->test_manipulation();
     this->test_rewrite();
+    this->test_binary();
+    this->test_bulk();
+    this->test_universes();
+    this->test_async();
+    this->test_text();
   }
 };
 
@@ -490,7 +824,7 @@ template<typename config> struct test_unicity<config, std::enable_if_t<get_hrewr
 
   using t_print = typename t_hrewrite::t_print;
 
-  static inline constexpr bool has_th_free = is_valid_sth_v<hrw::theory::tp_theory_free<std::vector, t_sparser>::template type, config>;
+  static inline constexpr bool has_th_free = is_valid_sth_v<hrw::theory::tp_theory_free<hrw::utils::small_vector_default, t_sparser>::template type, config>;
   static inline constexpr bool has_th_lit_int = is_valid_sth_v<hrw::theory::tp_theory_literal<int>::template type, config>;
   static inline constexpr bool has_th_lit_double = is_valid_sth_v<hrw::theory::tp_theory_literal<double>::template type, config>;
   static inline constexpr bool has_th_leaf = is_valid_sth_v<hrw::theory::tp_theory_leaf::template type, config>;
@@ -521,7 +855,7 @@ template<typename config> struct test_unicity<config, std::enable_if_t<get_hrewr
 
   template<typename targ_config, bool=tmp<targ_config, has_th_free>> struct S_free;
   template<typename targ_config> struct S_free<targ_config, true> {
-    using type = get_stheory_t<hrw::theory::tp_theory_free<std::vector, t_sparser>::template type, config>;
+    using type = get_stheory_t<hrw::theory::tp_theory_free<hrw::utils::small_vector_default, t_sparser>::template type, config>;
   };
   template<typename targ_config> struct S_free<targ_config, false>: public S_lit_int<targ_config> {};
 
@@ -595,6 +929,7 @@ template<typename config> struct test_unicity<config, std::enable_if_t<get_hrewr
 
     // with rewriting now
     ctx_rw.add(zero_1, one_2);
+    CHECK(!ctx_rw.has_guard());
 
     t_term_full_ref res_4 (ctx_rw.rewrite(one_2));
     t_term_full_ref res_1 (ctx_rw.rewrite(zero_1));
@@ -668,6 +1003,102 @@ template<typename config> struct test_unicity<config, std::enable_if_t<get_hrewr
 
       t_term_full_ref zero_2 (ctx_tm.create_sterm_from_diff(*r_zero_1, t_container()));
       CHECK_EQ(zero_1, zero_2);
+
+      t_term_full_ref zero_3 (ctx_tm.create_sterm_from_diff(zero_1, *r_zero_1, t_container()));
+      CHECK_EQ(zero_1, zero_3);
+
+      // the structural hash does not depend on the registry
+      t_ctx_tm ctx_tm_other;
+      t_term_full_ref zero_other (get_term(ctx_tm_other, c_zero));
+      CHECK_EQ(zero_1->get_hash(), zero_other->get_hash());
+    }
+  }
+
+  void collect() {
+    if constexpr(t_ctx_tm::collectable_v && has_th_free) {
+      using t_container = typename t_term::t_container;
+      t_ctx_tm ctx_tm;
+      t_ctx_rw ctx_rw(ctx_tm);
+
+      t_constructor_core<t_term_theory> c_succ = ctx_th::template add_constructor<t_term_theory>(sort_int, "succ", "int");
+      t_constructor_core<t_term_theory> c_plus = ctx_th::template add_constructor<t_term_theory>(sort_int, "plus", "int int");
+      auto incr  = [&](t_term_full_ref t) { return ctx_tm.create_sterm(c_succ, t_container({t})); };
+      auto plus  = [&](t_term_full_ref t1, t_term_full_ref t2) { return ctx_tm.create_sterm(c_plus, t_container({t1, t2})); };
+
+      t_term_full_ref zero  (get_term(ctx_tm, c_zero));
+      t_term_full_ref alpha (ctx_tm.create_vterm("int"));
+      t_term_full_ref beta  (ctx_tm.create_vterm("int"));
+      ctx_rw.add(plus(zero, alpha), alpha);
+      ctx_rw.add(plus(incr(alpha), beta), plus(alpha, incr(beta)));
+
+      // the rules are kept
+      std::size_t nb_rules = ctx_tm.size();
+      incr(incr(incr(zero)));
+      CHECK_EQ(ctx_rw.collect(), 3);
+      CHECK_EQ(ctx_tm.size(), nb_rules);
+
+      // the roots, their subterms, and the recorded rule applications are kept
+      t_term_full_ref two (incr(incr(zero)));
+      ctx_tm.add_root(two);
+      t_term_full_ref res (ctx_rw.rewrite(plus(two, two)));
+      ctx_tm.add_root(res);
+      ctx_rw.collect();
+      CHECK_EQ(ctx_rw.rewrite(plus(two, two)), res);
+      CHECK_EQ(res, incr(incr(two)));
+
+      ctx_rw.clear();
+      ctx_tm.remove_root(two);
+      std::size_t nb_terms = ctx_tm.size();
+      CHECK_EQ(ctx_tm.collect(), nb_terms - 5); // res, and its subterms
+      CHECK_EQ(two, incr(incr(zero)));
+      ctx_tm.remove_root(res);
+      ctx_tm.collect();
+      CHECK_EQ(ctx_tm.size(), 0);
+
+      // collection at an allocation threshold
+      ctx_tm.set_collect_threshold(4);
+      zero = get_term(ctx_tm, c_zero);
+      incr(incr(zero));
+      CHECK_EQ(ctx_tm.collect_if_needed(ctx_rw), 0);
+      incr(incr(incr(zero)));
+      CHECK_EQ(ctx_tm.collect_if_needed(ctx_rw), 4);
+    }
+  }
+
+  void weak_cache() {
+    if constexpr(t_ctx_rw::weak_cache_v && has_th_free) {
+      using t_container = typename t_term::t_container;
+      t_ctx_tm ctx_tm;
+      t_ctx_rw ctx_rw(ctx_tm);
+
+      t_constructor_core<t_term_theory> c_succ = ctx_th::template add_constructor<t_term_theory>(sort_int, "succ", "int");
+      t_constructor_core<t_term_theory> c_plus = ctx_th::template add_constructor<t_term_theory>(sort_int, "plus", "int int");
+      auto incr  = [&](t_term_full_ref t) { return ctx_tm.create_sterm(c_succ, t_container({t})); };
+      auto plus  = [&](t_term_full_ref t1, t_term_full_ref t2) { return ctx_tm.create_sterm(c_plus, t_container({t1, t2})); };
+
+      t_term_full_ref zero  (get_term(ctx_tm, c_zero));
+      t_term_full_ref alpha (ctx_tm.create_vterm("int"));
+      t_term_full_ref beta  (ctx_tm.create_vterm("int"));
+      ctx_rw.add(plus(zero, alpha), alpha);
+      ctx_rw.add(plus(incr(alpha), beta), plus(alpha, incr(beta)));
+      std::size_t nb_terms = ctx_tm.size();
+
+      // the recorded rule applications do not keep the terms alive
+      {
+        t_term_full_ref two (incr(incr(zero)));
+        t_term_full_ref res (ctx_rw.rewrite(plus(two, two)));
+        CHECK_EQ(res, incr(incr(two)));
+        CHECK_EQ(ctx_rw.rewrite(plus(two, two)), res);
+        CHECK(ctx_tm.size() > nb_terms);
+      }
+      CHECK_EQ(ctx_tm.size(), nb_terms);
+
+      {
+        t_term_full_ref res (ctx_rw.rewrite(plus(incr(zero), zero)));
+        CHECK_EQ(res, incr(zero));
+        ctx_rw.clear_nf();
+      }
+      CHECK_EQ(ctx_tm.size(), nb_terms);
     }
   }
 
@@ -677,6 +1108,8 @@ template<typename config> struct test_unicity<config, std::enable_if_t<get_hrewr
     this->variable_with();
     this->instantiate();
     this->create_from_diff();
+    this->collect();
+    this->weak_cache();
 
   }
 
@@ -688,13 +1121,13 @@ template<typename config, typename can_run=void> struct test_eval_lit;
 
 template<typename config>
 struct test_eval_lit<config, std::enable_if_t<
-    !is_valid_sth_v<hrw::theory::tp_theory_free<std::vector, t_sparser>::template type, config>
+    !is_valid_sth_v<hrw::theory::tp_theory_free<hrw::utils::small_vector_default, t_sparser>::template type, config>
     || !is_valid_sth_v<hrw::theory::tp_theory_literal<int>::template type, config>
   , void>> { void run() {} };
 
 template<typename config>
 struct test_eval_lit<config, std::enable_if_t<
-    is_valid_sth_v<hrw::theory::tp_theory_free<std::vector, t_sparser>::template type, config>
+    is_valid_sth_v<hrw::theory::tp_theory_free<hrw::utils::small_vector_default, t_sparser>::template type, config>
     && is_valid_sth_v<hrw::theory::tp_theory_literal<int>::template type, config>
   , void>> {
   // 1. types
@@ -714,10 +1147,10 @@ struct test_eval_lit<config, std::enable_if_t<
 
   using t_print = typename t_hrewrite::t_print;
 
-  using t_theory_free = get_stheory_t<hrw::theory::tp_theory_free<std::vector, t_sparser>::template type, config>;
+  using t_theory_free = get_stheory_t<hrw::theory::tp_theory_free<hrw::utils::small_vector_default, t_sparser>::template type, config>;
   using t_theory_lit_int = get_stheory_t<hrw::theory::tp_theory_literal<int>::template type, config>;
 
-  using t_term_free = get_sterm_t<hrw::theory::tp_theory_free<std::vector, t_sparser>::template type, config>;
+  using t_term_free = get_sterm_t<hrw::theory::tp_theory_free<hrw::utils::small_vector_default, t_sparser>::template type, config>;
   using t_term_lit_int = get_sterm_t<hrw::theory::tp_theory_literal<int>::template type, config>;
 
   using t_container = typename t_theory_free::template tt_term<t_term_full>::t_container;
@@ -783,6 +1216,7 @@ struct test_eval_lit<config, std::enable_if_t<
       }
     };
     ctx_rw.add(succ(alpha), beta, guard_succ);
+    CHECK(ctx_rw.has_guard());
 
     t_container c_plus;
     t_guard guard_plus = [alpha, beta, gamma, &ctx_tm, &c_plus, this](t_ctx_rw *, t_substitution * s) {
@@ -847,6 +1281,47 @@ struct test_eval_lit<config, std::enable_if_t<
         CHECK(t_eq()(i1, ctx_rw.rewrite(p2)));
       }
     }
+
+    // the same semantics with native guards
+    {
+      using t_native_guard = hrw::native_guard<t_ctx_rw>;
+      using t_expr = typename t_native_guard::t_expr;
+      using t_value = hrw::guard::t_value;
+
+      t_substitution s;
+      CHECK(t_native_guard::eval(ctx_tm, t_expr(7) / 2, s) == t_value(std::int64_t(3)));
+      CHECK(t_native_guard::eval(ctx_tm, t_expr(7.0) / 2, s) == t_value(3.5));
+      CHECK(std::holds_alternative<std::monostate>(t_native_guard::eval(ctx_tm, t_expr(7) % 0, s)));
+      CHECK(t_native_guard::eval(ctx_tm, hrw::guard::to_str(t_expr(1.5)) + "!", s) == t_value(std::string("1.5!")));
+      CHECK(t_native_guard::eval(ctx_tm, hrw::guard::to_int(t_expr("42")) == 42, s) == t_value(true));
+      CHECK(t_native_guard::eval(ctx_tm, hrw::guard::contains(t_expr("hello"), "ell") && (t_expr(1) < 2.5), s) == t_value(true));
+      CHECK(t_native_guard::eval(ctx_tm, t_expr(1) != "1", s) == t_value(true));
+
+      t_ctx_rw ctx_native(ctx_tm);
+      t_expr a = t_expr::variable(alpha);
+      t_expr b = t_expr::variable(beta);
+      ctx_native.add(succ(alpha), beta, t_guard(t_native_guard().bind(beta, c_val, a + 1)));
+      ctx_native.add(plus(alpha, beta), gamma, t_guard(t_native_guard().when(t_expr::is_sort(a, sort_int) && (a >= 0)).bind(gamma, c_val, a + b)));
+
+      t_term_full_ref p1 (plus(succ(succ(val(1))), plus(val(2), succ(val(2)))));
+      t_term_full_ref p3 (plus(val(-1), val(2)));
+      if constexpr(t_ctx_tm::ensure_unique_v) {
+        CHECK_EQ(i1, ctx_native.rewrite(p1));
+        CHECK_EQ(p3, ctx_native.rewrite(p3));
+      } else {
+        using t_eq = typename t_term_full::template t_eq_ref<true>;
+        CHECK(t_eq()(i1, ctx_native.rewrite(p1)));
+        CHECK(t_eq()(p3, ctx_native.rewrite(p3)));
+      }
+
+      bool thrown = false;
+      try {
+        t_native_guard().bind(beta, ctx_th::get_key(this->c_succ), a);
+      } catch(const hrw::exception::guard_invalid&) {
+        thrown = true;
+      }
+      CHECK(thrown);
+    }
   }
 };
 
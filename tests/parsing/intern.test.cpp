@@ -0,0 +1,99 @@
+/*
+ * This file is part of the hrewrite library.
+ * Copyright (c) 2021 ONERA.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+ // Author: Michael Lienhardt
+ // Maintainer: Michael Lienhardt
+ // email: michael.lienhardt@onera.fr
+
+#include "tests/common/activation.hpp"
+#if ENABLE_PARSING_INTERN
+
+#include "doctest/doctest.h"
+#include "tests/common/debug.hpp"
+
+
+#include "hrewrite/parsing.hpp"
+#include "hrewrite/utils.hpp"
+
+using namespace hrw::utils;
+
+
+#include <string>
+#include <unordered_set>
+
+//////////////////////////////////////////
+// global alphabet class
+
+struct t_smanager {
+  using t_letter = char;
+  using t_letter_set = std::unordered_set<t_letter>;
+  t_letter get_letter(const std::string& s) const {
+    if(s.size() != 1) {
+      throw "ERROR: a string is not a valid symbol : \"" + s + "\"";
+    } else {
+      return s[0];
+    }
+  }
+  bool is_subletter(const t_letter& s1, const t_letter& s2) const { return s1 <= s2; }
+};
+
+static t_smanager smanager;
+
+template<typename t_alphabet, const t_alphabet& alphabet>
+using my_automata = tt_automata<hrw::utils::natset, hrw::utils::natset>::template type<t_alphabet, alphabet>;
+
+using t_automata = my_automata<t_smanager, smanager>;
+using t_combo = combine_variant<t_smanager, smanager, element, sequence, my_automata>;
+
+
+TEST_CASE("parsing intern") {
+  std::cout << "==================================================================\n";
+  std::cout << "= parsing intern\n";
+
+  // 1. normalisation
+  CHECK_EQ(normalize_regexp("a"), "a");
+  CHECK_EQ(normalize_regexp("  a  b\tc\n"), "a b c");
+  CHECK_EQ(normalize_regexp("( a | b ) * c"), "(a|b)*c");
+  CHECK_EQ(normalize_regexp(""), "");
+
+  // 2. sharing
+  using t_intern = spec_intern<t_automata>;
+  t_intern::clear();
+  auto a1 = t_intern::get("(a | b)* c");
+  auto a2 = t_intern::get("(a|b)*   c");
+  auto a3 = t_intern::get("(a|b)* d");
+  CHECK_EQ(a1, a2);
+  CHECK_NE(a1, a3);
+  CHECK(*a1 == *a2);
+  CHECK_FALSE(*a1 == *a3);
+  CHECK_EQ(t_intern::size(), 2);
+
+  auto c1 = spec_intern<t_combo>::get("a b");
+  auto c2 = spec_intern<t_combo>::get(" a  b ");
+  CHECK_EQ(c1, c2);
+  CHECK_EQ(c1->get_regexp(), "a b");
+
+  // 3. clear keeps the already distributed parsers alive
+  t_intern::clear();
+  CHECK_EQ(t_intern::size(), 0);
+  CHECK_EQ(a1->get_regexp(), "(a|b)*c");
+  auto a4 = t_intern::get("(a|b)*c");
+  CHECK_NE(a1, a4);
+}
+
+
+#endif
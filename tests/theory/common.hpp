@@ -87,6 +87,7 @@ namespace hrw {
 
       static constexpr bool is_const = arg_is_const;
 
+      bool is_structured() const { return true; }
       t_sort_id get_sort() const { return this->m_content.get_sort(); }
       t_constructor_id get_constructor() const { return this->m_content.get_constructor(); }
 
@@ -115,6 +116,10 @@ namespace hrw {
           return true;
         }
 
+        template<typename termIt1, typename termIt2>
+        static bool match_term(termIt1 p_begin, termIt1 p_end, termIt2 t_begin, termIt2 t_end, const t_sort_id*, t_substitution& subst) {
+          return match_term(p_begin, p_end, t_begin, t_end, subst);
+        }
       };
 
       tt_term_full(t_content c): m_content(c) {}
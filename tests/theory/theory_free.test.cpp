@@ -73,6 +73,66 @@ TEST_CASE("theory free") {
 }
 
 
+TEST_CASE("theory free subterm sorts") {
+  std::cout << "==================================================================\n";
+  std::cout << "= theory free subterm sorts\n";
+
+  t_factory th;
+  t_container v;
+  t_term t1 = th.create_term(1, 0, v);
+  t_term t2 = th.create_term(2, 0, v);
+
+  t_container v2{&t1, &t2, &t1};
+  t_term t3 = th.create_term(3, 1, v2);
+  const hrw::t_sort_id* sorts = t3.m_content.get_subterm_sorts();
+
+  REQUIRE(sorts != nullptr);
+  CHECK(sorts[0] == 1);
+  CHECK(sorts[1] == 2);
+  CHECK(sorts[2] == 1);
+
+  t_term t4(t3.m_content);
+  sorts = t4.m_content.get_subterm_sorts();
+  REQUIRE(sorts != nullptr);
+  CHECK(sorts[1] == 2);
+}
+
+
+TEST_CASE("theory free small_vector") {
+  std::cout << "==================================================================\n";
+  std::cout << "= theory free small_vector\n";
+
+  using t_theory_free_sv = tt_theory_free<t_spec, hrw::utils::small_vector_default>;
+  using t_term_sv = tt_term_full<t_theory_free_sv::template tt_term, false>;
+  using t_factory_sv = typename t_theory_free_sv::template factory<t_term_sv>;
+  using t_term_inner_sv = typename t_term_sv::template tt_term<t_theory_free_sv::template tt_term>;
+  using t_container_sv = typename t_term_inner_sv::t_container;
+
+  t_factory_sv th;
+  t_container_sv v;
+  t_term_sv t1 = th.create_term(1, 0, v);
+  t_term_sv t2 = th.create_term(2, 0, v);
+
+  t_container_sv v1{&t1, &t2};
+  t_container_sv v2{&t1, &t2};
+  t_container_sv v3{&t1, &t2, &t1, &t2, &t1};
+  t_term_sv t3 = th.create_term(3, 1, v1);
+  t_term_sv t4 = th.create_term(3, 1, std::move(v2));
+  t_term_sv t5 = th.create_term(3, 1, v3);
+
+  CHECK(t3.m_content.get_subterms().is_inline());
+  CHECK_FALSE(t5.m_content.get_subterms().is_inline());
+  CHECK(t5.m_content.size() == 5);
+  CHECK(t5.m_content.get_subterm_sorts()[4] == 1);
+
+  using t_eq_sv = typename t_term_inner_sv::template t_eq<true>;
+  using t_hash_sv = typename t_term_inner_sv::template t_hash<true>;
+  CHECK(t_eq_sv()(t3.m_content, t4.m_content));
+  CHECK(t_hash_sv()(t3.m_content) == t_hash_sv()(t4.m_content));
+  CHECK_FALSE(t_eq_sv()(t3.m_content, t5.m_content));
+}
+
+
 
 
 
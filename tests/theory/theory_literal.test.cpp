@@ -26,6 +26,7 @@
 
 #include "hrewrite/theory/core.hpp"
 #include "hrewrite/theory/theory_literal.hpp"
+#include "hrewrite/utils/intern.hpp"
 
 #include "tests/theory/common.hpp"
 
@@ -125,5 +126,35 @@ TEST_CASE("theory literal unicity") {
 }
 
 
+
+TEST_CASE("theory literal interned string") {
+  std::cout << "==================================================================\n";
+  std::cout << "= theory literal interned string\n";
+
+  using t_istring = hrw::utils::interned_string;
+  using t_theory_istring = tt_theory_literal<t_istring>;
+  using t_eq_istring = typename t_theory_istring::template tt_term<tt_term<t_theory_istring>>::template t_eq<true>;
+  using t_hash_istring = typename t_theory_istring::template tt_term<tt_term<t_theory_istring>>::template t_hash<true>;
+
+  std::string s1 = "hello";
+  std::string s2 = "hel";
+  s2 += "lo";
+  CHECK(&(t_istring(s1).str()) == &(t_istring(s2).str()));
+  CHECK(t_istring(s1) == t_istring(s2));
+  CHECK(t_istring(s1) != t_istring("world"));
+  CHECK(t_istring("a") < t_istring("b"));
+  CHECK(t_istring().str().empty());
+
+  tt_factory<t_theory_istring> th;
+  tt_term<t_theory_istring> t1 = th.create_term(0, 0, t_istring(s1));
+  tt_term<t_theory_istring> t2 = th.create_term(0, 0, t_istring(s2));
+  tt_term<t_theory_istring> t3 = th.create_term(0, 0, t_istring("world"));
+  CHECK(t_eq_istring()(t1.m_content, t2.m_content));
+  CHECK(t_hash_istring()(t1.m_content) == t_hash_istring()(t2.m_content));
+  CHECK(!t_eq_istring()(t1.m_content, t3.m_content));
+  CHECK(t1.m_content.get_value().str() == "hello");
+}
+
+
 #endif
 
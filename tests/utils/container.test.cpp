@@ -26,6 +26,7 @@
 #include "tests/common/debug.hpp"
 
 #include "hrewrite/utils/container.hpp"
+#include "hrewrite/utils/flat_hash.hpp"
 
 #include "hrewrite/utils/type_traits.hpp"
 #include "hrewrite/utils/print.hpp"
@@ -40,6 +41,8 @@ using namespace hrw::utils;
 #include <unordered_set>
 #include <unordered_map>
 #include <optional>
+#include <thread>
+#include <string>
 
 
 
@@ -149,6 +152,54 @@ TEST_CASE("container_single") {
 }
 
 
+/////////////////////////////////////////////////////////////////////////////
+// SMALL VECTOR
+/////////////////////////////////////////////////////////////////////////////
+
+
+TEST_CASE("small_vector") {
+  OUTPUT("==================================================================");
+  OUTPUT("= small vector");
+
+  using t_sv = small_vector<std::string, 2>;
+  t_sv v;
+  CHECK(v.empty());
+  CHECK(v.is_inline());
+
+  v.push_back("a");
+  v.emplace_back("b");
+  CHECK(v.size() == 2);
+  CHECK(v.is_inline());
+
+  v.push_back(v[0]);
+  CHECK(v.size() == 3);
+  CHECK_FALSE(v.is_inline());
+  CHECK(v[2] == "a");
+
+  std::vector<std::string> other{"c", "d"};
+  v.insert(v.begin() + 1, other.begin(), other.end());
+  CHECK(v == t_sv{"a", "c", "d", "b", "a"});
+
+  t_sv v_inline{"x"};
+  t_sv v_copy(v);
+  t_sv v_move(std::move(v));
+  CHECK(v.empty());
+  CHECK(v.is_inline());
+  CHECK(v_copy == v_move);
+
+  swap(v_inline, v_move);
+  CHECK(v_inline == v_copy);
+  CHECK(v_move == t_sv{"x"});
+  CHECK(v_move.is_inline());
+
+  v_move = v_copy;
+  CHECK(v_move == v_copy);
+  v_move.pop_back();
+  v_move.clear();
+  CHECK(v_move.empty());
+}
+
+
 /////////////////////////////////////////////////////////////////////////////
 // REGISTERY STORE
 /////////////////////////////////////////////////////////////////////////////
@@ -257,7 +308,11 @@ using t_reg_makes = std::tuple<
   registry_unique<std::unordered_set, true, false>,
   registry_unique<std::unordered_set, true, true>,
   registry_unique<std::unordered_set, false, false>,
-  registry_unique<std::unordered_set, false, true>
+  registry_unique<std::unordered_set, false, true>,
+  registry_arena<std::unordered_set>,
+  registry_concurrent<std::unordered_set>,
+  registry_unique<flat_hash_set, false, false>,
+  registry_arena<flat_hash_set>
 >;
 template<typename TM> using make_d = typename TM::template make<D, D_hash>;
 using td_regs = tuple_map_t<make_d, t_reg_makes>;
@@ -286,6 +341,84 @@ TEST_CASE("registry_unique") {
 }
 
 
+TEST_CASE("registry_concurrent") {
+  OUTPUT("==================================================================");
+  OUTPUT("= registry concurrent");
+
+  using t_reg = registry_concurrent<std::unordered_set, 8>::make<D, D_hash>;
+  using t_ptr = typename t_reg::t_ptr;
+  constexpr std::size_t nb_threads = 4;
+  constexpr int nb_values = 100;
+
+  t_reg reg;
+  std::vector<std::vector<t_ptr>> refs(nb_threads, std::vector<t_ptr>(nb_values, nullptr));
+  std::vector<std::thread> threads;
+  for(std::size_t i = 0; i < nb_threads; ++i) {
+    threads.emplace_back([&reg, &refs, i]() {
+      for(int n = 0; n < 50; ++n) {
+        for(int v = 0; v < nb_values; ++v) {
+          int value = static_cast<int>((v + i * 7 + n) % nb_values);
+          refs[i][value] = reg.add(D{value});
+        }
+      }
+    });
+  }
+  for(std::thread& t: threads) { t.join(); }
+
+  CHECK(reg.size() == nb_values);
+  for(std::size_t i = 1; i < nb_threads; ++i) {
+    CHECK(refs[i] == refs[0]);
+  }
+  std::size_t count = 0;
+  for(auto it = reg.begin(); it != reg.end(); ++it) { ++count; }
+  CHECK(count == nb_values);
+}
+
+
+template<typename t_reg>
+void check_registry_pool() {
+  OUTPUT(" check_registry_pool(", type_name<t_reg>(), ")");
+  pool_allocator_store& store = pool_allocator_store::instance();
+  std::size_t live = store.live();
+  {
+    t_reg reg;
+    auto r1 = reg.add(D{1});
+    auto r2 = reg.add(D{2});
+    CHECK(reg.add(D{1}) == r1);
+    CHECK(r1 != r2);
+    CHECK(store.live() > live);
+    reg.clear();
+    CHECK(store.live() == live);
+    auto r3 = reg.add(D{3});
+    CHECK(r3->m_content == 3);
+  }
+  CHECK(store.live() == live);
+}
+
+TEST_CASE("pool_allocator") {
+  OUTPUT("==================================================================");
+  OUTPUT("= pool allocator");
+
+  std::vector<int*> ptrs;
+  pool_allocator<int> alloc;
+  for(int i = 0; i < 10000; ++i) {
+    ptrs.push_back(alloc.allocate(1));
+    *ptrs.back() = i;
+  }
+  for(int i = 0; i < 10000; ++i) { CHECK(*ptrs[i] == i); }
+  int* array = alloc.allocate(100); // not pooled
+  alloc.deallocate(array, 100);
+  for(int* p: ptrs) { alloc.deallocate(p, 1); }
+  int* p = alloc.allocate(1);
+  CHECK(p == ptrs.back());
+  alloc.deallocate(p, 1);
+
+  check_registry_pool<registry_unique<std::unordered_set, true, false>::make<D, D_hash, std::equal_to<D>, pool_allocator>>();
+  check_registry_pool<registry_unique<std::unordered_set, false, false>::make<D, D_hash, std::equal_to<D>, pool_allocator>>();
+  pool_allocator_store::instance().release();
+}
+
+
 /////////////////////////////////////////////////////////////////////////////
 // REGISTERY NO STORE
 /////////////////////////////////////////////////////////////////////////////
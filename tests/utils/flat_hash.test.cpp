@@ -0,0 +1,130 @@
+/*
+ * This file is part of the hrewrite library.
+ * Copyright (c) 2021 ONERA.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+ // Author: Michael Lienhardt
+ // Maintainer: Michael Lienhardt
+ // email: michael.lienhardt@onera.fr
+
+
+#include "tests/common/activation.hpp"
+#if ENABLE_UTILS_FLAT_HASH
+
+#include "doctest/doctest.h"
+#include "tests/common/debug.hpp"
+
+#include "hrewrite/utils/flat_hash.hpp"
+
+using namespace hrw::utils;
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <unordered_set>
+#include <unordered_map>
+#include <random>
+
+
+
+TEST_CASE("flat_hash_set") {
+  OUTPUT("==================================================================");
+  OUTPUT("= flat hash set");
+
+  flat_hash_set<int> s;
+  std::unordered_set<int> ref;
+  CHECK(s.empty());
+  CHECK(s.find(0) == s.end());
+
+  std::mt19937 gen;
+  std::uniform_int_distribution<int> distrib(0, 2000);
+  for(int i = 0; i < 20000; ++i) {
+    int v = distrib(gen);
+    if(i % 3 == 2) {
+      CHECK_EQ(s.erase(v), ref.erase(v));
+    } else {
+      CHECK_EQ(s.insert(v).second, ref.insert(v).second);
+    }
+  }
+  CHECK_EQ(s.size(), ref.size());
+  for(int v = 0; v <= 2000; ++v) {
+    CHECK_EQ(s.count(v), ref.count(v));
+  }
+
+  std::size_t count = 0;
+  for(int v: s) {
+    CHECK(ref.count(v) == 1);
+    ++count;
+  }
+  CHECK_EQ(count, ref.size());
+
+  flat_hash_set<int> s_copy(s);
+  CHECK_EQ(s_copy.size(), s.size());
+  flat_hash_set<int> s_move(std::move(s_copy));
+  CHECK(s_copy.empty());
+  CHECK_EQ(s_move.size(), s.size());
+
+  s.clear();
+  CHECK(s.empty());
+  CHECK(s.begin() == s.end());
+  CHECK(s.insert(42).second);
+  CHECK(s.contains(42));
+}
+
+
+TEST_CASE("flat_hash_set - move only values") {
+  OUTPUT("==================================================================");
+  OUTPUT("= flat hash set - move only values");
+
+  struct t_hash {
+    std::size_t operator()(const std::unique_ptr<std::string>& p) const { return std::hash<std::string>()(*p); }
+  };
+  struct t_eq {
+    bool operator()(const std::unique_ptr<std::string>& p1, const std::unique_ptr<std::string>& p2) const { return *p1 == *p2; }
+  };
+
+  flat_hash_set<std::unique_ptr<std::string>, t_hash, t_eq> s;
+  for(int i = 0; i < 100; ++i) {
+    s.emplace(std::make_unique<std::string>(std::to_string(i % 50)));
+  }
+  CHECK_EQ(s.size(), 50);
+  CHECK(s.find(std::make_unique<std::string>("7")) != s.end());
+  CHECK(s.find(std::make_unique<std::string>("50")) == s.end());
+}
+
+
+TEST_CASE("flat_hash_map") {
+  OUTPUT("==================================================================");
+  OUTPUT("= flat hash map");
+
+  flat_hash_map<const int*, std::string> m;
+  std::vector<int> keys(1000);
+  for(std::size_t i = 0; i < keys.size(); ++i) {
+    m[&keys[i]] = std::to_string(i);
+  }
+  CHECK_EQ(m.size(), keys.size());
+  CHECK(m.insert(std::make_pair(&keys[3], std::string("x"))).second == false);
+  for(std::size_t i = 0; i < keys.size(); ++i) {
+    auto it = m.find(&keys[i]);
+    REQUIRE(it != m.end());
+    CHECK_EQ(it->second, std::to_string(i));
+  }
+  m.erase(&keys[0]);
+  CHECK(m.find(&keys[0]) == m.end());
+  CHECK_EQ(m.at(&keys[1]), "1");
+}
+
+
+#endif
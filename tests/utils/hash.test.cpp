@@ -27,6 +27,10 @@
 
 #include "hrewrite/utils/hash.hpp"
 
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
 using namespace hrw::utils;
 
 
@@ -92,6 +96,29 @@ TEST_CASE("hash wrapper - immutable") {
 
 }
 
+TEST_CASE("hash mix") {
+  OUTPUT("==================================================================");
+  OUTPUT("= hash mix");
+
+  // aligned pointers must spread over the low bits used by power of two tables
+  std::vector<std::uint64_t> data(4096);
+  std::vector<unsigned int> buckets(256, 0);
+  for(const std::uint64_t& v: data) {
+    ++buckets[hash_mixed<const std::uint64_t*>()(&v) & 255];
+  }
+  unsigned int nb_empty = static_cast<unsigned int>(std::count(buckets.begin(), buckets.end(), 0u));
+  CHECK(nb_empty < 8);
+  CHECK(*std::max_element(buckets.begin(), buckets.end()) < 48);
+
+  // the combination depends on the order
+  hash_value h1(0), h2(0);
+  h1 << 1 << 2;
+  h2 << 2 << 1;
+  CHECK(static_cast<std::size_t>(h1) != static_cast<std::size_t>(h2));
+  CHECK(hash_mix(0) == 0);
+  CHECK(hash_mix(1) != hash_mix(2));
+}
+
 
 #endif
 
@@ -58,6 +58,8 @@ template<typename T, std::size_t max>
 T create_natset() {
   if constexpr(T::kind == e_natset_kind::FREE) {
     return T();
+  } else if constexpr(T::kind == e_natset_kind::FIXED) {
+    return T(max+1);
   } else {
     return T(max);
   }
@@ -304,6 +306,10 @@ TEST_CASE("natset") {
     check_natset_set_api<natset_static<120>, 119>();
   }
 
+  SUBCASE("natset_fixed") {
+    check_natset_base_api<natset_fixed<>, max_value>();
+    check_natset_set_api<natset_fixed<>, max_value>();
+  }
 
   SUBCASE("natset_extensible") {
     check_natset_base_api<natset_extensible<>, max_value>();
@@ -324,5 +330,38 @@ TEST_CASE("natset") {
 }
 
 
+template<typename N, std::size_t max>
+void check_natset_includes() {
+  auto s1 = create_natset<N, max>();
+  auto s2 = create_natset<N, max>();
+
+  CHECK(s1.empty());
+  CHECK(s1.includes(s2));
+  for(t_nat val: insert_1) { if(val <= max) { s1.insert(val); } }
+  for(t_nat val: erase_1)  { if(val <= max) { s2.insert(val); } }
+  CHECK_FALSE(s1.empty());
+
+  auto s = s1.cap(s2);
+  CHECK(s1.includes(s));
+  CHECK(s2.includes(s));
+  s = s1.cup(s2);
+  CHECK(s.includes(s1));
+  CHECK(s.includes(s2));
+  CHECK_FALSE(s1.includes(s) && s2.includes(s));
+
+  for(t_nat val: insert_1) { if(val <= max) { s1.erase(val); } }
+  CHECK(s1.empty());
+}
+
+
+TEST_CASE("natset_includes") {
+  check_natset_includes<natset_static<120>, 119>();
+  check_natset_includes<natset_fixed<>, max_value>();
+  check_natset_includes<natset_extensible<>, max_value>();
+  check_natset_includes<natset_extensible<8>, max_value>();
+  check_natset_includes<tt_natset<natset_extensible<>>, max_value>();
+}
+
+
 #endif
 